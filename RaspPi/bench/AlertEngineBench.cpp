@@ -0,0 +1,44 @@
+#include "../includes/AlertEngine.h"
+
+#include <benchmark/benchmark.h>
+
+// Проверка правил на одном отсчёте в потоке опроса.
+// Аргумент - число правил; мощность колеблется у порога, часть правил срабатывает.
+
+static void BM_AlertEngineEvaluate(benchmark::State& state)
+{
+    AlertEngine engine;
+    std::vector<AlertRule> rules;
+    for (int i = 0; i < state.range(0); ++i)
+    {
+        AlertRule rule;
+        rule.name = "rule" + std::to_string(i);
+        rule.metric = i % 2 ? AlertMetric::CURRENT : AlertMetric::POWER;
+        rule.threshold = i % 2 ? 8.0f : 1800.0f;
+        rule.hysteresis = i % 2 ? 0.5f : 50.0f;
+        rule.minDurationMs = 500;
+        rule.cooldownMs = 5000;
+        if (i % 4 == 3)
+            rule.rateOfChange = 200.0f;
+        rules.push_back(rule);
+    }
+    engine.SetRules(rules);
+    
+    PowerData data {};
+    data.voltage = 230.0f;
+    int64_t nowNs = 0;
+    int step = 0;
+    
+    for (auto _ : state)
+    {
+        data.power = 1700.0f + static_cast<float>(step % 300);
+        data.current = data.power / data.voltage;
+        data.timestamp = static_cast<uint64_t>(nowNs / 1000000);
+        engine.Evaluate(data, nowNs);
+        nowNs += 100000000;
+        ++step;
+    }
+    
+    state.counters["dropped"] = static_cast<double>(engine.GetDroppedCount());
+}
+BENCHMARK(BM_AlertEngineEvaluate)->Arg(1)->Arg(8)->Arg(32);
@@ -0,0 +1,67 @@
+#include "../includes/AnomalyDetector.h"
+#include "../includes/AlertEngine.h"
+#include "../includes/LoadSimulator.h"
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <vector>
+
+// Поиск аномалий на каждом отсчёте: четыре канала EWMA/CUSUM и часовое
+// среднее. Отсчёты с циклами прибора и шумом сети, так что сдвиги тоже
+// попадают в замер; события уходят в очередь AlertEngine без рассылки.
+
+static std::vector<PowerData> MakeSamples(size_t count)
+{
+    LoadSimulator simulator;
+    simulator.SetBaseLoad(60.0f);
+    ApplianceModel fridge;
+    fridge.name = "fridge";
+    fridge.power = 120.0f;
+    fridge.powerFactor = 0.8f;
+    fridge.onSeconds = 60.0f;
+    fridge.offSeconds = 90.0f;
+    fridge.noise = 0.02f;
+    simulator.AddAppliance(fridge);
+    
+    std::mt19937 rng(42);
+    std::normal_distribution<float> voltNoise(0.0f, 1.5f);
+    std::normal_distribution<float> freqNoise(0.0f, 0.02f);
+    
+    std::vector<PowerData> samples(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        LoadSample load = simulator.Sample(static_cast<int64_t>(i) * 100000000);
+        samples[i].power = load.power;
+        samples[i].current = load.current;
+        samples[i].voltage = LoadSimulator::NOMINAL_VOLTAGE + voltNoise(rng);
+        samples[i].frequency = LoadSimulator::NOMINAL_FREQUENCY + freqNoise(rng);
+        samples[i].timestamp = 1700000000000ULL + i * 100;
+    }
+    return samples;
+}
+
+static void BM_AnomalyDetectorProcess(benchmark::State& state)
+{
+    std::vector<PowerData> samples = MakeSamples(36000);
+    
+    AlertEngine alerts;
+    AnomalyDetector detector;
+    detector.Configure(AnomalySettings());
+    detector.SetAlertEngine(&alerts);
+    size_t index = 0;
+    
+    for (auto _ : state)
+    {
+        detector.Process(samples[index]);
+        if (++index == samples.size())
+            index = 0;
+    }
+    
+    AnomalySnapshot snapshot = detector.GetSnapshot();
+    uint64_t anomalies = 0;
+    for (const AnomalyChannelState& channel : snapshot.channels)
+        anomalies += channel.anomalies;
+    state.counters["anomalies"] = static_cast<double>(anomalies);
+}
+BENCHMARK(BM_AnomalyDetectorProcess);
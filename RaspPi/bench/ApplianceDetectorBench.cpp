@@ -0,0 +1,71 @@
+#include "../includes/ApplianceDetector.h"
+#include "../includes/LoadSimulator.h"
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+// Распознавание приборов на каждом отсчёте. Отсчёты заранее сгенерированы
+// симулятором (3 прибора с циклами), так что в замер попадают и скачки.
+// Аргумент - число сигнатур в библиотеке.
+
+static std::vector<PowerData> MakeSamples(size_t count)
+{
+    LoadSimulator simulator;
+    ApplianceModel kettle;
+    kettle.name = "kettle";
+    kettle.power = 2000.0f;
+    kettle.onSeconds = 12.0f;
+    kettle.offSeconds = 30.0f;
+    kettle.noise = 0.01f;
+    simulator.AddAppliance(kettle);
+    
+    ApplianceModel fridge;
+    fridge.name = "fridge";
+    fridge.power = 120.0f;
+    fridge.powerFactor = 0.8f;
+    fridge.onSeconds = 20.0f;
+    fridge.offSeconds = 25.0f;
+    fridge.inrushFactor = 5.0f;
+    fridge.inrushMs = 300.0f;
+    simulator.AddAppliance(fridge);
+    
+    std::vector<PowerData> samples(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        LoadSample load = simulator.Sample(static_cast<int64_t>(i) * 100000000);
+        samples[i].power = load.power;
+        samples[i].reactive_power = load.reactive;
+        samples[i].timestamp = i * 100;
+    }
+    return samples;
+}
+
+static void BM_ApplianceDetectorProcess(benchmark::State& state)
+{
+    std::vector<PowerData> samples = MakeSamples(36000);
+    
+    std::vector<ApplianceSignature> signatures;
+    for (int i = 0; i < state.range(0); ++i)
+    {
+        ApplianceSignature signature;
+        signature.name = "appliance_" + std::to_string(i);
+        signature.power = 60.0f * static_cast<float>(i + 1);
+        signature.reactive = 10.0f * static_cast<float>(i % 5);
+        signatures.push_back(signature);
+    }
+    
+    ApplianceDetector detector;
+    detector.SetSignatures(signatures);
+    size_t index = 0;
+    
+    for (auto _ : state)
+    {
+        detector.Process(samples[index]);
+        if (++index == samples.size())
+            index = 0;
+    }
+    
+    state.counters["edges"] = static_cast<double>(detector.GetSnapshot().edges);
+}
+BENCHMARK(BM_ApplianceDetectorProcess)->Arg(4)->Arg(32);
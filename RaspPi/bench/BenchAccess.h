@@ -0,0 +1,38 @@
+#pragma once
+
+#include "../includes/PowerMonitor.h"
+#include "../includes/Logger.h"
+#ifdef SMART_PLUG_BENCH_HTTP
+#include "../includes/HTTPServer.h"
+#endif
+
+#include <string>
+
+// Доступ бенчмарков к закрытым методам горячих путей
+struct BenchAccess
+{
+    static void UpdateStatistics(PowerMonitor& monitor, const PowerData& data)
+    {
+        monitor.updateStatistics(data);
+    }
+    
+#ifdef SMART_PLUG_BENCH_HTTP
+    static std::string PowerRequest(HTTPServer& server) { return server.handlePowerRequest(); }
+    static std::string EnergyRequest(HTTPServer& server) { return server.handleEnergyRequest(); }
+    static std::string StatsRequest(HTTPServer& server, const std::string& period)
+    {
+        return server.handleStatsRequest(period);
+    }
+#endif
+};
+
+// Синхронный логгер без вывода на консоль; file - текстовый журнал, если нужен
+inline void QuietLogger(LogLevel level, const char* file = nullptr)
+{
+    Logger& logger = Logger::GetInstance();
+    logger.DisableAsyncMode();
+    logger.SetLogLevel(level);
+    logger.EnableConsoleOutput(false);
+    logger.EnableFileOutput(file != nullptr, file ? file : "");
+    logger.EnableBinaryOutput(false);
+}
@@ -0,0 +1,40 @@
+#include <benchmark/benchmark.h>
+
+#include <fstream>
+#include <string>
+#include <sys/utsname.h>
+
+#ifndef SMART_PLUG_REVISION
+#define SMART_PLUG_REVISION "unknown"
+#endif
+
+// Модель платы с device tree (Raspberry Pi), иначе архитектура из uname
+static std::string DetectPlatform()
+{
+    std::ifstream model("/proc/device-tree/model");
+    std::string name;
+    if (model && std::getline(model, name, '\0') && !name.empty())
+        return name;
+    
+    struct utsname info;
+    if (uname(&info) == 0)
+        return std::string(info.sysname) + " " + info.machine;
+    return "unknown";
+}
+
+// Контекст попадает в JSON-отчёт (--benchmark_out), по нему сравниваются
+// прогоны между релизами и платами (Pi 3, Pi Zero 2, x86)
+int main(int argc, char** argv)
+{
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+    
+    benchmark::AddCustomContext("smart_plug_revision", SMART_PLUG_REVISION);
+    benchmark::AddCustomContext("smart_plug_platform", DetectPlatform());
+    benchmark::AddCustomContext("smart_plug_results_format", "1");
+    
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
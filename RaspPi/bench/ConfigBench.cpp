@@ -0,0 +1,37 @@
+#include "../includes/ConfigManager.h"
+
+#include <benchmark/benchmark.h>
+
+// Чтение конфигурации: поиск по строковому ключу против ConfigHandle
+
+static void BM_ConfigGetInt(benchmark::State& state)
+{
+    ConfigManager& config = ConfigManager::GetInstance();
+    for (auto _ : state)
+        benchmark::DoNotOptimize(config.GetInt("server.port", 5000));
+}
+BENCHMARK(BM_ConfigGetInt)->ThreadRange(1, 4);
+
+static void BM_ConfigGetString(benchmark::State& state)
+{
+    ConfigManager& config = ConfigManager::GetInstance();
+    for (auto _ : state)
+        benchmark::DoNotOptimize(config.GetString("server.address", "0.0.0.0"));
+}
+BENCHMARK(BM_ConfigGetString);
+
+static void BM_ConfigGetBool(benchmark::State& state)
+{
+    ConfigManager& config = ConfigManager::GetInstance();
+    for (auto _ : state)
+        benchmark::DoNotOptimize(config.GetBool("security.enable_auth", false));
+}
+BENCHMARK(BM_ConfigGetBool);
+
+static void BM_ConfigHandleGet(benchmark::State& state)
+{
+    static const ConfigHandle<bool> enableAuth("security.enable_auth", false);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(enableAuth.Get());
+}
+BENCHMARK(BM_ConfigHandleGet)->ThreadRange(1, 4);
@@ -0,0 +1,26 @@
+#include "../includes/SamplingGovernor.h"
+
+#include <benchmark/benchmark.h>
+
+// Выбор интервала на каждом отсчёте: проверка порогов и скачков мощности.
+// Нагрузка колеблется, так что режим периодически меняется и пишет метрики.
+
+static void BM_GovernorOnSample(benchmark::State& state)
+{
+    SamplingGovernor governor;
+    governor.SetBaseRate(10);
+    governor.SetWatchLimits(2000.0f, 10.0f);
+    
+    PowerData data {};
+    data.voltage = 230.0f;
+    int64_t nowNs = 0;
+    int step = 0;
+    
+    for (auto _ : state)
+    {
+        data.power = (step++ % 1000) < 900 ? 500.0f : 1900.0f;
+        data.current = data.power / data.voltage;
+        nowNs += governor.OnSample(data, nowNs) * 1000;
+    }
+}
+BENCHMARK(BM_GovernorOnSample);
@@ -0,0 +1,58 @@
+#include "BenchAccess.h"
+#include "../includes/Logger.h"
+
+#include <benchmark/benchmark.h>
+
+// Формирование JSON в обработчиках HTTPServer, без сети и libmicrohttpd
+
+struct HTTPBenchContext
+{
+    RelayController relay;
+    SensorManager sensorManager;
+    Statistics statistics;
+    HTTPServer server {relay, sensorManager, statistics};
+    
+    HTTPBenchContext()
+    {
+        QuietLogger(LogLevel::WARNING);
+        
+        for (uint64_t i = 0; i < 1440; ++i)
+            statistics.addEnergyReading(0.002f, 1700000000 + i * 60);
+    }
+};
+
+template <typename Handler>
+static void RunHandler(benchmark::State& state, Handler handler)
+{
+    HTTPBenchContext context;
+    size_t bytes = 0;
+    
+    for (auto _ : state)
+    {
+        std::string body = handler(context.server);
+        bytes += body.size();
+        benchmark::DoNotOptimize(body);
+    }
+    
+    if (bytes == 0)
+        state.SkipWithError("Handlers are compiled without HTTP support");
+    state.SetBytesProcessed(static_cast<int64_t>(bytes));
+}
+
+static void BM_HTTPPowerJSON(benchmark::State& state)
+{
+    RunHandler(state, [](HTTPServer& server) { return BenchAccess::PowerRequest(server); });
+}
+BENCHMARK(BM_HTTPPowerJSON);
+
+static void BM_HTTPEnergyJSON(benchmark::State& state)
+{
+    RunHandler(state, [](HTTPServer& server) { return BenchAccess::EnergyRequest(server); });
+}
+BENCHMARK(BM_HTTPEnergyJSON);
+
+static void BM_HTTPStatsJSON(benchmark::State& state)
+{
+    RunHandler(state, [](HTTPServer& server) { return BenchAccess::StatsRequest(server, "week"); });
+}
+BENCHMARK(BM_HTTPStatsJSON);
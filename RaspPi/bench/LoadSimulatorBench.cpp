@@ -0,0 +1,60 @@
+#include "../includes/LoadSimulator.h"
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+// Отсчёт нагрузки в режиме симуляции и генерация формы сигнала.
+// Аргумент - число приборов в профиле.
+
+static void FillProfile(LoadSimulator& simulator, int count)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        ApplianceModel model;
+        model.name = "appliance" + std::to_string(i);
+        model.power = 50.0f + 10.0f * static_cast<float>(i);
+        model.powerFactor = 0.85f;
+        model.onSeconds = 600.0f;
+        model.offSeconds = 1200.0f;
+        model.phaseSeconds = 60.0f * static_cast<float>(i);
+        model.inrushFactor = 4.0f;
+        model.inrushMs = 200.0f;
+        model.thirdHarmonic = 0.2f;
+        model.noise = 0.02f;
+        simulator.AddAppliance(model);
+    }
+}
+
+static void BM_LoadSimulatorSample(benchmark::State& state)
+{
+    LoadSimulator simulator;
+    FillProfile(simulator, static_cast<int>(state.range(0)));
+    int64_t nowNs = 0;
+    
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(simulator.Sample(nowNs));
+        nowNs += 100000000;
+    }
+}
+BENCHMARK(BM_LoadSimulatorSample)->Arg(1)->Arg(4)->Arg(16);
+
+// Один период 50 Гц при 10 кГц
+static void BM_LoadSimulatorWaveform(benchmark::State& state)
+{
+    LoadSimulator simulator;
+    FillProfile(simulator, static_cast<int>(state.range(0)));
+    std::vector<float> voltage(200), current(200);
+    int64_t nowNs = 0;
+    
+    for (auto _ : state)
+    {
+        simulator.FillWaveform(nowNs, 10000.0, voltage.size(), voltage.data(), current.data());
+        benchmark::DoNotOptimize(current.data());
+        nowNs += 20000000;
+    }
+    
+    state.SetItemsProcessed(state.iterations() * voltage.size());
+}
+BENCHMARK(BM_LoadSimulatorWaveform)->Arg(1)->Arg(4);
\ No newline at end of file
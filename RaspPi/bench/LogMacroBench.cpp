@@ -0,0 +1,76 @@
+#include "BenchAccess.h"
+#include "../includes/Logger.h"
+
+#include <benchmark/benchmark.h>
+
+// Стоимость отключённого LOG_DEBUG: прежний макрос строил строку и
+// создавал std::string из __FUNCTION__ до проверки уровня в Log().
+
+static void DisableDebug()
+{
+    QuietLogger(LogLevel::INFO);
+}
+
+static void LegacyDebug(const std::string& message, const std::string& function, int line)
+{
+    Logger::GetInstance().Debug(message, function.c_str(), line);
+}
+
+static void BM_DisabledDebugEager(benchmark::State& state)
+{
+    DisableDebug();
+    float power = 1234.5f;
+    int pin = 17;
+    for (auto _ : state)
+    {
+        LegacyDebug("[SIM] Set pin " + std::to_string(pin) + " to HIGH, power " + std::to_string(power),
+                    __FUNCTION__, __LINE__);
+        benchmark::ClobberMemory();
+    }
+}
+
+static void BM_DisabledDebugMacro(benchmark::State& state)
+{
+    DisableDebug();
+    float power = 1234.5f;
+    int pin = 17;
+    for (auto _ : state)
+    {
+        LOG_DEBUG("[SIM] Set pin " + std::to_string(pin) + " to HIGH, power " + std::to_string(power));
+        benchmark::ClobberMemory();
+    }
+}
+
+static void BM_DisabledDebugFormat(benchmark::State& state)
+{
+    DisableDebug();
+    float power = 1234.5f;
+    int pin = 17;
+    for (auto _ : state)
+    {
+        LOG_DEBUGF("[SIM] Set pin {} to HIGH, power {}", pin, power);
+        benchmark::ClobberMemory();
+    }
+}
+
+static void BM_FormatOnly(benchmark::State& state)
+{
+    float power = 1234.5f;
+    int pin = 17;
+    for (auto _ : state)
+        benchmark::DoNotOptimize(Logger::Format("[SIM] Set pin {} to HIGH, power {}", pin, power));
+}
+
+static void BM_ConcatOnly(benchmark::State& state)
+{
+    float power = 1234.5f;
+    int pin = 17;
+    for (auto _ : state)
+        benchmark::DoNotOptimize("[SIM] Set pin " + std::to_string(pin) + " to HIGH, power " + std::to_string(power));
+}
+
+BENCHMARK(BM_DisabledDebugEager);
+BENCHMARK(BM_DisabledDebugMacro);
+BENCHMARK(BM_DisabledDebugFormat);
+BENCHMARK(BM_FormatOnly);
+BENCHMARK(BM_ConcatOnly);
@@ -0,0 +1,64 @@
+#include "BenchAccess.h"
+#include "../includes/Logger.h"
+
+#include <benchmark/benchmark.h>
+
+// Задержка одного вызова Log() на вызывающем потоке при конкуренции потоков.
+// Вывод идёт в /dev/null, чтобы измерялась стоимость логгера, а не диска.
+
+static void ConfigureLogger(bool async, LogOverflowPolicy overflow)
+{
+    QuietLogger(LogLevel::INFO, "/dev/null");
+    
+    if (async)
+    {
+        AsyncLogConfig config;
+        config.queueSize = 16384;
+        config.overflow = overflow;
+        Logger::GetInstance().EnableAsyncMode(config);
+    }
+}
+
+static void RunLogLoop(benchmark::State& state)
+{
+    const std::string message = "[192.168.1.10] GET /power -> 200";
+    for (auto _ : state)
+        LOG_INFO(message);
+}
+
+static void BM_LogSync(benchmark::State& state)
+{
+    if (state.thread_index() == 0)
+        ConfigureLogger(false, LogOverflowPolicy::DROP);
+    RunLogLoop(state);
+}
+
+static void BM_LogAsyncDrop(benchmark::State& state)
+{
+    if (state.thread_index() == 0)
+        ConfigureLogger(true, LogOverflowPolicy::DROP);
+    uint64_t droppedBefore = Logger::GetInstance().GetDroppedCount();
+    RunLogLoop(state);
+    if (state.thread_index() == 0)
+        state.counters["dropped"] = static_cast<double>(Logger::GetInstance().GetDroppedCount() - droppedBefore);
+}
+
+static void BM_LogAsyncBlock(benchmark::State& state)
+{
+    if (state.thread_index() == 0)
+        ConfigureLogger(true, LogOverflowPolicy::BLOCK);
+    RunLogLoop(state);
+}
+
+static void BM_LogFilteredOut(benchmark::State& state)
+{
+    if (state.thread_index() == 0)
+        ConfigureLogger(false, LogOverflowPolicy::DROP);
+    for (auto _ : state)
+        LOG_DEBUG("Power: " + std::to_string(123.4f) + "W");
+}
+
+BENCHMARK(BM_LogSync)->ThreadRange(1, 4)->UseRealTime();
+BENCHMARK(BM_LogAsyncDrop)->ThreadRange(1, 4)->UseRealTime();
+BENCHMARK(BM_LogAsyncBlock)->ThreadRange(1, 4)->UseRealTime();
+BENCHMARK(BM_LogFilteredOut)->ThreadRange(1, 4)->UseRealTime();
@@ -0,0 +1,45 @@
+#include "../includes/Metrics.h"
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+// Обновление метрик под конкуренцией потоков и рендер /metrics
+
+static void BM_MetricsCounterAdd(benchmark::State& state)
+{
+    static Counter& counter = MetricsRegistry::GetInstance().GetCounter("bench_counter_total", "Benchmark counter");
+    for (auto _ : state)
+        counter.Add();
+}
+BENCHMARK(BM_MetricsCounterAdd)->ThreadRange(1, 4);
+
+static void BM_MetricsHistogramObserve(benchmark::State& state)
+{
+    static Histogram& histogram = MetricsRegistry::GetInstance().GetHistogram(
+        "bench_latency_seconds", "Benchmark histogram", {0.001, 0.01, 0.1, 1.0});
+    double value = 0.0;
+    for (auto _ : state)
+    {
+        histogram.Observe(value);
+        value = value < 1.5 ? value + 0.003 : 0.0;
+    }
+}
+BENCHMARK(BM_MetricsHistogramObserve)->ThreadRange(1, 4);
+
+static void BM_MetricsRender(benchmark::State& state)
+{
+    MetricsRegistry& registry = MetricsRegistry::GetInstance();
+    for (int i = 0; i < 32; ++i)
+        registry.GetCounter("bench_render_total", "Render benchmark", "series=\"" + std::to_string(i) + "\"").Add(i);
+    
+    std::vector<char> buffer(64 * 1024);
+    size_t size = 0;
+    for (auto _ : state)
+    {
+        size = registry.Render(buffer.data(), buffer.size());
+        benchmark::DoNotOptimize(buffer.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(size) * state.iterations());
+}
+BENCHMARK(BM_MetricsRender);
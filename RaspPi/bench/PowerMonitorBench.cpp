@@ -0,0 +1,59 @@
+#include "BenchAccess.h"
+
+#include <benchmark/benchmark.h>
+
+// Оконная статистика по секундной истории мощности (3600 значений)
+
+static void FillHistory(PowerMonitor& monitor)
+{
+    PowerData data {};
+    for (int i = 0; i < 3600; ++i)
+    {
+        data.power = 100.0f + static_cast<float>(i % 700);
+        BenchAccess::UpdateStatistics(monitor, data);
+    }
+}
+
+static void BM_PowerWindowAverage(benchmark::State& state)
+{
+    PowerMonitor monitor;
+    FillHistory(monitor);
+    int seconds = static_cast<int>(state.range(0));
+    
+    for (auto _ : state)
+        benchmark::DoNotOptimize(monitor.getAveragePower(seconds));
+}
+BENCHMARK(BM_PowerWindowAverage)->Arg(60)->Arg(300)->Arg(3600);
+
+static void BM_PowerWindowMax(benchmark::State& state)
+{
+    PowerMonitor monitor;
+    FillHistory(monitor);
+    int seconds = static_cast<int>(state.range(0));
+    
+    for (auto _ : state)
+        benchmark::DoNotOptimize(monitor.getMaxPower(seconds));
+}
+BENCHMARK(BM_PowerWindowMax)->Arg(60)->Arg(3600);
+
+static void BM_PowerWindowMin(benchmark::State& state)
+{
+    PowerMonitor monitor;
+    FillHistory(monitor);
+    int seconds = static_cast<int>(state.range(0));
+    
+    for (auto _ : state)
+        benchmark::DoNotOptimize(monitor.getMinPower(seconds));
+}
+BENCHMARK(BM_PowerWindowMin)->Arg(60)->Arg(3600);
+
+static void BM_PowerHistoryUpdate(benchmark::State& state)
+{
+    PowerMonitor monitor;
+    PowerData data {};
+    data.power = 500.0f;
+    
+    for (auto _ : state)
+        BenchAccess::UpdateStatistics(monitor, data);
+}
+BENCHMARK(BM_PowerHistoryUpdate);
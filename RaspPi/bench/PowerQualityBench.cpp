@@ -0,0 +1,64 @@
+#include "../includes/PowerQualityMonitor.h"
+#include "../includes/LoadSimulator.h"
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+// Анализ блока формы 10 периодов в потоке опроса: Urms(1/2), частота по
+// переходам через ноль и 25 гармоник напряжения и тока. Аргумент - отсчётов
+// на период. Для сравнения - путь без формы, по одному показанию датчика.
+
+static void BM_PowerQualityBlock(benchmark::State& state)
+{
+    PQSettings settings;
+    settings.samplesPerCycle = static_cast<int>(state.range(0));
+    PowerQualityMonitor monitor;
+    monitor.Configure(settings);
+    
+    size_t samples;
+    double rate;
+    monitor.GetBlockFormat(samples, rate);
+    
+    LoadSimulator simulator;
+    ApplianceModel drive;
+    drive.name = "drive";
+    drive.power = 800.0f;
+    drive.powerFactor = 0.9f;
+    drive.thirdHarmonic = 0.3f;
+    drive.fifthHarmonic = 0.15f;
+    simulator.AddAppliance(drive);
+    
+    std::vector<float> voltage(samples);
+    std::vector<float> current(samples);
+    simulator.FillWaveform(0, rate, samples, voltage.data(), current.data());
+    
+    uint64_t timestamp = 1700000000000ULL;
+    for (auto _ : state)
+    {
+        monitor.ProcessBlock(voltage.data(), current.data(), samples, rate, timestamp);
+        timestamp += 200;
+    }
+    
+    state.counters["current_thd"] = monitor.GetSnapshot().shortWindow.currentThd;
+}
+BENCHMARK(BM_PowerQualityBlock)->Arg(64)->Arg(128);
+
+static void BM_PowerQualitySample(benchmark::State& state)
+{
+    PQSettings settings;
+    settings.waveform = false;
+    PowerQualityMonitor monitor;
+    monitor.Configure(settings);
+    
+    PowerData data {};
+    data.voltage = 229.5f;
+    data.frequency = 50.01f;
+    data.timestamp = 1700000000000ULL;
+    for (auto _ : state)
+    {
+        monitor.Process(data);
+        data.timestamp += 100;
+    }
+}
+BENCHMARK(BM_PowerQualitySample);
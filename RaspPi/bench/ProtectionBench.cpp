@@ -0,0 +1,73 @@
+#include "BenchAccess.h"
+#include "../includes/OverloadProtection.h"
+#include "../includes/RelayController.h"
+#include "../includes/Logger.h"
+
+#include <benchmark/benchmark.h>
+
+// Защита от перегрузки в потоке опроса: проверка отсчёта без срабатывания и
+// путь от отсчёта до записи в GPIO (реле в режиме симуляции).
+
+static void BM_ProtectionCheck(benchmark::State& state)
+{
+    QuietLogger(LogLevel::INFO);
+    RelayController relay;
+    relay.Initialize(17, true, false, RelayState::ON);
+    
+    OverloadProtection protection;
+    ProtectionSettings settings;
+    settings.enabled = true;
+    protection.Configure(settings);
+    protection.SetRelay(&relay);
+    
+    FakeClock clock(0);
+    PowerData data {};
+    data.voltage = 230.0f;
+    int64_t nowNs = 0;
+    int step = 0;
+    
+    for (auto _ : state)
+    {
+        data.current = 8.0f + static_cast<float>(step++ % 4);
+        data.power = data.current * data.voltage;
+        benchmark::DoNotOptimize(protection.Check(data, nowNs, nowNs, clock));
+        nowNs += 100000000;
+    }
+    
+    relay.Shutdown();
+}
+BENCHMARK(BM_ProtectionCheck);
+
+static void BM_ProtectionTrip(benchmark::State& state)
+{
+    QuietLogger(LogLevel::INFO);
+    RelayController relay;
+    relay.Initialize(17, true);
+    
+    OverloadProtection protection;
+    ProtectionSettings settings;
+    settings.enabled = true;
+    protection.Configure(settings);
+    protection.SetRelay(&relay);
+    
+    SystemClock& clock = SystemClock::GetInstance();
+    PowerData data {};
+    data.voltage = 230.0f;
+    data.current = 60.0f;
+    data.power = data.current * data.voltage;
+    
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        relay.TurnOn();
+        state.ResumeTiming();
+        
+        int64_t nowNs = clock.MonotonicNs();
+        benchmark::DoNotOptimize(protection.Check(data, nowNs, nowNs, clock));
+    }
+    
+    ProtectionStatus status = protection.GetStatus();
+    state.counters["max_latency_ns"] = static_cast<double>(status.maxLatencyNs);
+    relay.Shutdown();
+}
+BENCHMARK(BM_ProtectionTrip);
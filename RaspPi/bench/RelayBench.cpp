@@ -0,0 +1,26 @@
+#include "BenchAccess.h"
+#include "../includes/RelayController.h"
+#include "../includes/Logger.h"
+
+#include <benchmark/benchmark.h>
+
+// Переключение реле в режиме симуляции: мьютекс состояния, GPIO-заглушка,
+// запись в лог и метрики. Вывод логгера отключён.
+
+static void BM_RelayToggleSimulation(benchmark::State& state)
+{
+    QuietLogger(LogLevel::INFO);
+    
+    RelayController relay;
+    if (!relay.Initialize(17, true))
+    {
+        state.SkipWithError("Relay initialization failed");
+        return;
+    }
+    
+    for (auto _ : state)
+        benchmark::DoNotOptimize(relay.Toggle());
+    
+    relay.Shutdown();
+}
+BENCHMARK(BM_RelayToggleSimulation);
@@ -0,0 +1,98 @@
+#include "BenchAccess.h"
+#include "../includes/PowerMonitor.h"
+#include "../includes/PowerTrace.h"
+#include "../includes/Statistics.h"
+#include "../includes/Logger.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <cstdio>
+#include <map>
+#include <string>
+
+// Воспроизведение трассы без пауз через PowerMonitor в Statistics:
+// сколько стоит прогнать сутки и месяц посекундных отсчётов по всему конвейеру.
+// Аргумент - длина трассы в сутках.
+
+static constexpr uint64_t TRACE_START_MS = 1700000000000ULL;
+
+// Фон 60-90 Вт, чайник на 2 кВт по утрам и вечерам
+static const std::string& TracePath(int days, TraceFormat format)
+{
+    static std::map<std::pair<int, int>, std::string> paths;
+    auto key = std::make_pair(days, static_cast<int>(format));
+    auto it = paths.find(key);
+    if (it != paths.end())
+        return it->second;
+    
+    std::string path = "/tmp/smart_plug_bench_" + std::to_string(days) +
+                       (format == TraceFormat::CSV ? "d.csv" : "d.trace");
+    PowerTraceRecorder recorder;
+    recorder.Open(path, format);
+    
+    PowerData data {};
+    for (int64_t second = 0; second < days * 86400LL; ++second)
+    {
+        int64_t secondOfDay = second % 86400;
+        bool kettle = (secondOfDay >= 7 * 3600 && secondOfDay < 7 * 3600 + 180) ||
+                      (secondOfDay >= 19 * 3600 && secondOfDay < 19 * 3600 + 180);
+        
+        data.timestamp = TRACE_START_MS + static_cast<uint64_t>(second) * 1000;
+        data.voltage = 225.0f + 3.0f * std::sin(static_cast<float>(second) * 0.001f);
+        data.power = (kettle ? 2000.0f : 60.0f) + static_cast<float>(second % 30);
+        data.current = data.power / data.voltage;
+        data.power_factor = kettle ? 0.99f : 0.9f;
+        data.frequency = 50.0f;
+        recorder.Write(data);
+    }
+    recorder.Close();
+    
+    return paths.emplace(key, path).first->second;
+}
+
+static void BM_TraceReplayPipeline(benchmark::State& state)
+{
+    QuietLogger(LogLevel::WARNING);
+    int days = static_cast<int>(state.range(0));
+    const std::string& path = TracePath(days, TraceFormat::BINARY);
+    
+    for (auto _ : state)
+    {
+        Statistics statistics;
+        PowerMonitor monitor;
+        monitor.setEnergySink(&statistics.getEnergyQueue());
+        monitor.setReplaySource(path, 0.0);
+        monitor.initialize(PowerMonitor::SENSOR_REPLAY);
+        
+        while (!monitor.isReplayFinished())
+            statistics.drainEnergyQueue();
+        monitor.stop();
+        statistics.drainEnergyQueue(true);
+        
+        benchmark::DoNotOptimize(statistics.getTotalEnergyKWh());
+    }
+    
+    state.SetItemsProcessed(state.iterations() * days * 86400LL);
+}
+BENCHMARK(BM_TraceReplayPipeline)->Arg(1)->Arg(30)->Unit(benchmark::kMillisecond);
+
+static void BM_TraceRead(benchmark::State& state)
+{
+    QuietLogger(LogLevel::WARNING);
+    TraceFormat format = static_cast<TraceFormat>(state.range(0));
+    PowerTraceReader reader;
+    reader.Open(TracePath(1, format));
+    PowerData data;
+    
+    for (auto _ : state)
+    {
+        if (!reader.Next(data))
+        {
+            reader.Rewind();
+            reader.Next(data);
+        }
+        benchmark::DoNotOptimize(data);
+    }
+}
+BENCHMARK(BM_TraceRead)->Arg(static_cast<int>(TraceFormat::CSV))->Arg(static_cast<int>(TraceFormat::BINARY));
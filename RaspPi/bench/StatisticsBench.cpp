@@ -0,0 +1,65 @@
+#include "BenchAccess.h"
+#include "../includes/Statistics.h"
+#include "../includes/Logger.h"
+
+#include <benchmark/benchmark.h>
+
+// Запись поминутных отсчётов и агрегаты за неделю/месяц.
+// Аргумент - число записей в истории перед замером (1440 - сутки, 43200 - 30 дней).
+
+static constexpr uint64_t START_TIMESTAMP = 1700000000;
+
+static void FillStatistics(Statistics& statistics, int64_t records)
+{
+    for (int64_t i = 0; i < records; ++i)
+        statistics.addEnergyReading(0.001f + 0.0001f * static_cast<float>(i % 50), START_TIMESTAMP + i * 60);
+}
+
+static void BM_StatisticsAddEnergyReading(benchmark::State& state)
+{
+    QuietLogger(LogLevel::WARNING);
+    Statistics statistics;
+    FillStatistics(statistics, state.range(0));
+    uint64_t timestamp = START_TIMESTAMP + state.range(0) * 60;
+    
+    for (auto _ : state)
+    {
+        statistics.addEnergyReading(0.002f, timestamp);
+        timestamp += 60;
+    }
+}
+BENCHMARK(BM_StatisticsAddEnergyReading)->Arg(1440)->Arg(43200);
+
+static void BM_StatisticsWeekStats(benchmark::State& state)
+{
+    QuietLogger(LogLevel::WARNING);
+    Statistics statistics;
+    FillStatistics(statistics, state.range(0));
+    
+    for (auto _ : state)
+        benchmark::DoNotOptimize(statistics.getWeekStats());
+}
+BENCHMARK(BM_StatisticsWeekStats)->Arg(1440)->Arg(43200);
+
+static void BM_StatisticsMonthStats(benchmark::State& state)
+{
+    QuietLogger(LogLevel::WARNING);
+    Statistics statistics;
+    FillStatistics(statistics, state.range(0));
+    
+    for (auto _ : state)
+        benchmark::DoNotOptimize(statistics.getMonthStats());
+}
+BENCHMARK(BM_StatisticsMonthStats)->Arg(1440)->Arg(43200);
+
+// Чтение прогноза не зависит от объёма истории
+static void BM_StatisticsForecast(benchmark::State& state)
+{
+    QuietLogger(LogLevel::WARNING);
+    Statistics statistics;
+    FillStatistics(statistics, state.range(0));
+    
+    for (auto _ : state)
+        benchmark::DoNotOptimize(statistics.getForecast());
+}
+BENCHMARK(BM_StatisticsForecast)->Arg(1440)->Arg(43200);
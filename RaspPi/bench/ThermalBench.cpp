@@ -0,0 +1,29 @@
+#include "../includes/ThermalMonitor.h"
+
+#include <benchmark/benchmark.h>
+
+// Чтение опубликованного снимка (так его читает /power) и один цикл опроса
+// всех зон через pread. Без зон в /sys второй тест меряет только публикацию.
+
+static void BM_ThermalSnapshotRead(benchmark::State& state)
+{
+    ThermalMonitor monitor;
+    monitor.Sample();
+    
+    for (auto _ : state)
+        benchmark::DoNotOptimize(monitor.GetCpuTemperature());
+}
+BENCHMARK(BM_ThermalSnapshotRead)->Threads(1)->Threads(4);
+
+static void BM_ThermalSample(benchmark::State& state)
+{
+    ThermalMonitor monitor;
+    monitor.Start(60000);
+    
+    for (auto _ : state)
+        monitor.Sample();
+    
+    state.counters["zones"] = monitor.GetSnapshot().zoneCount;
+    monitor.Stop();
+}
+BENCHMARK(BM_ThermalSample);
@@ -0,0 +1,39 @@
+#!/bin/bash
+
+# Запуск smart_plug_bench с сохранением результатов в bench/results/.
+# Имя файла: <платформа>_<ревизия>_<дата>.json - формат JSON Google Benchmark,
+# ревизия и модель платы лежат в context (smart_plug_revision, smart_plug_platform).
+# Сравнение двух прогонов: compare.py из Google Benchmark:
+#   compare.py benchmarks old.json new.json
+
+BUILD_DIR=${1:-build-bench}
+shift
+
+SCRIPT_DIR=$(cd "$(dirname "$0")" && pwd)
+SOURCE_DIR=$(dirname "$SCRIPT_DIR")
+RESULTS_DIR="$SCRIPT_DIR/results"
+
+echo "Building smart_plug_bench..."
+
+cmake -S "$SOURCE_DIR" -B "$BUILD_DIR" -DCMAKE_BUILD_TYPE=Release -DSMART_PLUG_BUILD_BENCH=ON || exit 1
+cmake --build "$BUILD_DIR" --target smart_plug_bench -j4 || exit 1
+
+if [ -r /proc/device-tree/model ]; then
+    PLATFORM=$(tr -d '\0' < /proc/device-tree/model)
+else
+    PLATFORM=$(uname -m)
+fi
+PLATFORM=$(echo "$PLATFORM" | tr -cs 'A-Za-z0-9' '-' | sed 's/-$//')
+REVISION=$(git -C "$SOURCE_DIR" describe --always --dirty 2>/dev/null || echo unknown)
+
+mkdir -p "$RESULTS_DIR"
+OUTPUT="$RESULTS_DIR/${PLATFORM}_${REVISION}_$(date +%Y%m%d-%H%M%S).json"
+
+"$BUILD_DIR/smart_plug_bench" \
+    --benchmark_repetitions=5 \
+    --benchmark_report_aggregates_only=true \
+    --benchmark_out="$OUTPUT" \
+    --benchmark_out_format=json \
+    "$@" || exit 1
+
+echo "Results: $OUTPUT"
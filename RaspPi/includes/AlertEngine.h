@@ -0,0 +1,148 @@
+#pragma once
+
+#include "PowerMonitor.h"
+#include "SPSCQueue.h"
+#include "SeqLock.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class ConfigSnapshot;
+
+enum class AlertMetric
+{
+    POWER = 0,
+    CURRENT,
+    VOLTAGE,
+    POWER_FACTOR,
+    FREQUENCY,
+    TEMPERATURE
+};
+
+enum class AlertEdge
+{
+    RISING = 0,     // срабатывает при значении выше порога
+    FALLING = 1     // срабатывает при значении ниже порога
+};
+
+struct AlertRule
+{
+    std::string name;
+    AlertMetric metric {AlertMetric::POWER};
+    AlertEdge edge {AlertEdge::RISING};
+    float threshold {0.0f};
+    float hysteresis {0.0f};      // сброс только после выхода за порог на эту величину
+    int minDurationMs {0};        // условие должно держаться столько до срабатывания
+    // Не 0 - правило следит за скоростью изменения (единиц в секунду), а не за значением;
+    // направление задаёт edge
+    float rateOfChange {0.0f};
+    int cooldownMs {0};           // минимальный интервал между срабатываниями
+};
+
+struct AlertEvent
+{
+    char rule[32];
+    AlertMetric metric;
+    bool raised;                  // false - сброс
+    float value;                  // значение или скорость изменения
+    float threshold;
+    uint64_t timestamp;           // мс
+};
+
+using AlertListener = std::function<void(const AlertEvent& event)>;
+
+// Правила проверяются в потоке опроса на каждом отсчёте, без блокировок
+// и выделения памяти. События уходят в очередь, подписчиков вызывает
+// отдельный поток, поэтому медленный обработчик не задерживает опрос.
+class AlertEngine
+{
+private:
+    struct RuleState
+    {
+        bool active {false};
+        int64_t pendingSinceNs {-1};
+        int64_t lastFiredNs {-1};
+        bool hasPrevious {false};
+        float previousValue {0.0f};
+        int64_t previousNs {0};
+    };
+    
+    struct RuleSet
+    {
+        std::vector<AlertRule> rules;
+        std::vector<RuleState> states;
+    };
+    
+    void AdoptPendingRules();
+    void Emit(const std::string& name, AlertMetric metric, bool raised, float value, float threshold, uint64_t timestampMs);
+    void Push(const AlertEvent& event);
+    void Deliver(const AlertEvent& event);
+    void DispatcherLoop();
+    
+public:
+    static constexpr size_t QUEUE_SIZE = 256;
+    
+    AlertEngine() = default;
+    ~AlertEngine();
+    
+    AlertEngine(const AlertEngine&) = delete;
+    AlertEngine& operator=(const AlertEngine&) = delete;
+    
+    void Start();
+    void Stop();
+    
+    // Из любого потока; поток опроса подхватит правила на следующем отсчёте.
+    // Состояние правил с тем же именем сохраняется.
+    void SetRules(std::vector<AlertRule> rules);
+    void Subscribe(AlertListener listener);
+    
+    // Только из потока опроса
+    void Evaluate(const PowerData& data, int64_t monotonicNs);
+    // Событие не из правил, например срабатывание защиты; тоже из потока опроса
+    void Raise(const char* name, AlertMetric metric, float value, float threshold, uint64_t timestampMs);
+    // Событие, которое нельзя потерять (срабатывание защиты): идёт мимо очереди,
+    // последним значением с номером, и доставляется даже при переполненной очереди.
+    // Повторы до следующего прохода рассылки сливаются в последнее.
+    void RaiseCritical(const char* name, AlertMetric metric, float value, float threshold, uint64_t timestampMs);
+    
+    void SetTemperature(float celsius) { temperature.store(celsius, std::memory_order_relaxed); }
+    uint64_t GetDroppedCount() const { return dropped.load(std::memory_order_relaxed); }
+    
+    // Правила из конфигурации: alert.<имя>.metric|edge|threshold|hysteresis|min_duration_ms|rate|cooldown_ms
+    static std::vector<AlertRule> ParseRules(const ConfigSnapshot& config);
+    static bool RulesDiffer(const ConfigSnapshot& previous, const ConfigSnapshot& current);
+    
+private:
+    RuleSet active;
+    std::mutex pendingMutex;
+    std::unique_ptr<RuleSet> pending;
+    std::atomic<bool> hasPending {false};
+    
+    std::atomic<float> temperature {0.0f};
+    
+    struct CriticalEvent
+    {
+        AlertEvent event;
+        uint64_t sequence;
+    };
+    
+    SPSCQueue<AlertEvent, QUEUE_SIZE> queue;
+    std::atomic<uint64_t> dropped {0};
+    SeqLock<CriticalEvent> critical;
+    uint64_t criticalRaised {0};        // поток опроса
+    uint64_t criticalDelivered {0};     // поток рассылки
+    
+    std::mutex listenersMutex;
+    std::vector<AlertListener> listeners;
+    
+    std::thread dispatcher;
+    std::atomic<bool> running {false};
+    std::mutex wakeMutex;
+    std::condition_variable wakeCondition;
+};
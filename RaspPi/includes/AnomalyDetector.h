@@ -0,0 +1,150 @@
+#pragma once
+
+#include "PowerMonitor.h"
+#include "SeqLock.h"
+
+#include <atomic>
+#include <cstdint>
+
+class AlertEngine;
+
+enum class AnomalyChannel
+{
+    POWER = 0,
+    CURRENT,
+    VOLTAGE,
+    FREQUENCY
+};
+
+enum class AnomalyKind
+{
+    SPIKE = 0,      // одиночный выброс за spikeSigmas
+    SHIFT_UP,       // CUSUM: устойчивый сдвиг вверх
+    SHIFT_DOWN,
+    SEASONAL        // средняя мощность за час далека от нормы для этого часа недели
+};
+
+struct AnomalySettings
+{
+    bool enabled {true};
+    float alpha {0.01f};            // вес нового отсчёта в EWMA
+    int warmupSamples {100};        // отсчётов до начала проверок
+    float spikeSigmas {6.0f};
+    float cusumSlack {1.0f};        // k, в СКО: сдвиги меньше 2k не ищутся
+    float cusumLimit {8.0f};        // h, в СКО
+    float seasonalRatio {0.5f};     // допустимое отклонение часа от нормы, доля
+    float seasonalMinWatts {50.0f}; // и не меньше этого
+};
+
+struct AnomalyChannelState
+{
+    float mean;
+    float sigma;
+    bool ready;                     // прогрев закончен
+    bool spike;                     // выброс ещё не закончился
+    uint64_t anomalies;
+};
+
+struct AnomalySnapshot
+{
+    static constexpr int CHANNELS = 4;
+    
+    AnomalyChannelState channels[CHANNELS];
+    float hourMean;                 // средняя мощность текущего часа
+    float hourExpected;             // норма для него, 0 - неизвестна
+    uint64_t lastAnomalyAt;         // мс
+};
+
+// Поиск аномалий на каждом отсчёте в потоке опроса. На канал - EWMA среднего
+// и дисперсии и двусторонний CUSUM по нормированному отклонению: постоянная
+// память и стоимость, без выделений. После сдвига базовая линия
+// перестраивается на новый уровень. Для мощности дополнительно сравнивается
+// средняя за час с нормой для этого часа недели, построенной по свёрткам
+// Statistics (SetSeasonalBaseline).
+//
+// Аномалии уходят событиями через AlertEngine::Raise (anomaly_<канал>_<вид>)
+// и в счётчик smart_plug_anomalies_total.
+class AnomalyDetector
+{
+private:
+    struct Channel
+    {
+        float mean {0.0f};
+        float variance {0.0f};
+        int samples {0};
+        float cusumHigh {0.0f};
+        float cusumLow {0.0f};
+        bool spike {false};
+        float spikePeak {0.0f};
+        uint64_t anomalies {0};
+    };
+    
+    // Настройки, прочитанные один раз на отсчёт
+    struct Limits
+    {
+        float alpha;
+        int warmupSamples;
+        float spikeSigmas;
+        float cusumSlack;
+        float cusumLimit;
+    };
+    
+    void Update(AnomalyChannel id, float value, uint64_t timestamp, const Limits& limits);
+    void UpdateHour(float power, uint64_t timestamp);
+    void Report(AnomalyChannel id, AnomalyKind kind, float value, float expected, uint64_t timestamp);
+    void Publish(uint64_t timestamp);
+    
+public:
+    static constexpr int CHANNELS = AnomalySnapshot::CHANNELS;
+    static constexpr int WEEK_HOURS = 7 * 24;
+    
+    AnomalyDetector() = default;
+    
+    AnomalyDetector(const AnomalyDetector&) = delete;
+    AnomalyDetector& operator=(const AnomalyDetector&) = delete;
+    
+    void Configure(const AnomalySettings& settings);
+    // Задаётся до подключения к PowerMonitor
+    void SetAlertEngine(AlertEngine* engine) { alertEngine = engine; }
+    
+    // Средняя мощность по часам недели, с понедельника 00:00 местного времени;
+    // 0 - нормы нет. Из любого потока.
+    void SetSeasonalBaseline(const float (&watts)[WEEK_HOURS]);
+    // Час недели для времени в секундах
+    static int SeasonalSlot(uint64_t seconds);
+    
+    // Только из потока опроса
+    void Process(const PowerData& data);
+    
+    AnomalySnapshot GetSnapshot() const { return snapshot.Load(); }
+    
+    static const char* ChannelName(AnomalyChannel channel);
+    static const char* KindName(AnomalyKind kind);
+    
+private:
+    std::atomic<bool> enabled {true};
+    std::atomic<float> alpha {0.01f};
+    std::atomic<int> warmupSamples {100};
+    std::atomic<float> spikeSigmas {6.0f};
+    std::atomic<float> cusumSlack {1.0f};
+    std::atomic<float> cusumLimit {8.0f};
+    std::atomic<float> seasonalRatio {0.5f};
+    std::atomic<float> seasonalMinWatts {50.0f};
+    
+    std::atomic<float> seasonal[WEEK_HOURS] {};
+    
+    AlertEngine* alertEngine {nullptr};
+    
+    // Состояние потока опроса
+    Channel channels[CHANNELS];
+    int hourSlot {-1};
+    uint64_t hourEndMs {0};
+    uint64_t hourFirstMs {0};
+    uint64_t hourLastMs {0};
+    double hourSum {0.0};
+    uint32_t hourSamples {0};
+    uint64_t lastAnomalyAt {0};
+    uint64_t lastPublishMs {0};
+    
+    SeqLock<AnomalySnapshot> snapshot;
+};
@@ -0,0 +1,160 @@
+#pragma once
+
+#include "PowerMonitor.h"
+#include "SeqLock.h"
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct ApplianceSignature
+{
+    std::string name;
+    float power {0.0f};           // скачок активной мощности при включении, Вт
+    float reactive {0.0f};        // скачок реактивной, вар
+    bool trained {true};          // false - кластер, найденный на лету
+};
+
+struct NILMSettings
+{
+    bool enabled {true};
+    float edgeThreshold {30.0f};  // минимальный скачок мощности, Вт
+    int settleSamples {3};        // отсчётов в новом установившемся режиме
+    float matchTolerance {0.15f}; // допустимое отклонение от сигнатуры, доля
+    float minMatchWatts {15.0f};  // нижняя граница допуска для малых нагрузок
+};
+
+struct ApplianceState
+{
+    char name[24];
+    float power;
+    float reactive;
+    bool trained;
+    bool on;
+    uint32_t activations;
+    uint64_t changedAt;           // мс
+};
+
+struct ApplianceEvent
+{
+    int appliance;                // -1 - скачок не сопоставлен
+    bool on;
+    float deltaPower;
+    float deltaReactive;
+    uint64_t timestamp;
+};
+
+struct ApplianceSnapshot
+{
+    static constexpr int MAX_APPLIANCES = 32;
+    static constexpr int MAX_EVENTS = 16;
+    
+    ApplianceState appliances[MAX_APPLIANCES];
+    int applianceCount;
+    ApplianceEvent events[MAX_EVENTS];    // кольцо последних скачков
+    int eventCount;
+    int nextEvent;
+    float baseline;                       // мощность, не объяснённая включёнными приборами
+    uint64_t edges;
+    uint64_t unmatched;
+};
+
+// Распознавание приборов по скачкам P/Q (NILM). Process вызывается в потоке
+// опроса на каждом отсчёте: в установившемся режиме это несколько сравнений,
+// при скачке - перебор библиотеки сигнатур, разложенной по массивам (SoA).
+// Несопоставленные скачки собираются в кластеры, которые видны как auto_N и
+// после обучения становятся сигнатурами.
+//
+// Файл сигнатур в формате конфигурации:
+//   signature.kettle.power = 2000
+//   signature.kettle.reactive = 0
+class ApplianceDetector
+{
+private:
+    struct Library
+    {
+        // Горячие данные подряд: перебор при скачке не трогает строки
+        std::vector<float> power;
+        std::vector<float> reactive;
+        std::vector<uint32_t> hits;
+        std::vector<uint8_t> trained;
+        std::vector<std::string> names;
+        
+        // Ёмкость резервируется заранее: новый кластер в потоке опроса не выделяет память
+        Library();
+        size_t size() const { return power.size(); }
+        void add(const ApplianceSignature& signature);
+    };
+    
+    void AdoptPendingLibrary();
+    void OnEdge(float deltaPower, float deltaReactive, uint64_t timestamp);
+    int FindNearest(float deltaPower, float deltaReactive, bool activeOnly) const;
+    void Publish();
+    
+public:
+    ApplianceDetector() = default;
+    
+    ApplianceDetector(const ApplianceDetector&) = delete;
+    ApplianceDetector& operator=(const ApplianceDetector&) = delete;
+    
+    void Configure(const NILMSettings& settings);
+    
+    // Из любого потока; поток опроса подхватит библиотеку на следующем отсчёте
+    void SetSignatures(const std::vector<ApplianceSignature>& signatures);
+    bool LoadSignatures(const std::string& path);
+    static bool SaveSignatures(const std::string& path, const std::vector<ApplianceSignature>& signatures);
+    static std::vector<ApplianceSignature> ParseSignatures(const std::map<std::string, std::string>& values);
+    
+    // Прогон трассы через отдельный детектор: кластеры, встретившиеся не реже
+    // minOccurrences раз (включение и выключение), становятся сигнатурами
+    static std::vector<ApplianceSignature> TrainFromTrace(const std::string& path, const NILMSettings& settings,
+                                                          int minOccurrences = 3);
+    
+    // Только из потока опроса
+    void Process(const PowerData& data);
+    
+    // Текущая библиотека, включая найденные кластеры; из потока опроса или после его остановки
+    std::vector<ApplianceSignature> GetLearnedSignatures(int minOccurrences) const;
+    
+    ApplianceSnapshot GetSnapshot() const { return snapshot.Load(); }
+    
+private:
+    std::atomic<bool> enabled {true};
+    std::atomic<float> edgeThreshold {30.0f};
+    std::atomic<int> settleSamples {3};
+    std::atomic<float> matchTolerance {0.15f};
+    std::atomic<float> minMatchWatts {15.0f};
+    
+    std::mutex pendingMutex;
+    std::unique_ptr<Library> pending;
+    std::atomic<bool> hasPending {false};
+    
+    // Состояние потока опроса
+    Library library;
+    bool on[ApplianceSnapshot::MAX_APPLIANCES] {};
+    uint32_t activations[ApplianceSnapshot::MAX_APPLIANCES] {};
+    uint64_t changedAt[ApplianceSnapshot::MAX_APPLIANCES] {};
+    bool steady {false};
+    float steadyPower {0.0f};
+    float steadyReactive {0.0f};
+    float noiseVariance {0.0f};
+    int refineRemaining {0};
+    float edgeFromPower {0.0f};
+    float edgeFromReactive {0.0f};
+    uint64_t edgeTimestamp {0};
+    int settleCount {0};
+    float settlePower {0.0f};
+    float settleReactive {0.0f};
+    int autoCounter {0};
+    ApplianceEvent events[ApplianceSnapshot::MAX_EVENTS] {};
+    int eventCount {0};
+    int nextEvent {0};
+    uint64_t edges {0};
+    uint64_t unmatched {0};
+    
+    SeqLock<ApplianceSnapshot> snapshot;
+};
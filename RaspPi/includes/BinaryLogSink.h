@@ -0,0 +1,195 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+// Бинарный журнал: строка формата пишется один раз, дальше запись содержит
+// только её номер, дельту монотонного времени и сырые аргументы.
+// Повторяющиеся строковые аргументы (IP, URL) заменяются ссылками.
+//
+// Файл: "SPBL", u8 версия, u64 realtime нс, u64 monotonic нс, затем записи:
+//   0x01 FORMAT  varint id, u8 level, varint line, str function, str format
+//   0x02 STRING  varint id, str value
+//   0x03 RECORD  varint id, varint dt нс, u8 argc, аргументы
+// Аргумент: u8 тег и значение (см. BinaryLogTag). str = varint длина + байты.
+namespace BinaryLog
+{
+    static constexpr char MAGIC[4] = {'S', 'P', 'B', 'L'};
+    static constexpr uint8_t VERSION = 1;
+    
+    enum Entry : uint8_t {
+        ENTRY_FORMAT = 0x01,
+        ENTRY_STRING = 0x02,
+        ENTRY_RECORD = 0x03
+    };
+    
+    enum Tag : uint8_t {
+        TAG_INT = 0x10,         // zigzag varint
+        TAG_UINT = 0x11,        // varint
+        TAG_F32 = 0x12,
+        TAG_F64 = 0x13,
+        TAG_STR = 0x14,
+        TAG_STRREF = 0x15,      // varint id строки из ENTRY_STRING
+        TAG_BOOL = 0x16,
+        TAG_CHAR = 0x17
+    };
+    
+    struct FormatSite
+    {
+        int level;
+        int line;
+        std::string function;
+        std::string format;
+    };
+}
+
+class BinaryLogSink
+{
+private:
+    bool OpenLocked();
+    void WriteHeader();
+    void EnsureFormat(uint32_t formatId);
+    void FlushLocked();
+    
+    void PutByte(uint8_t value) { PutByte(m_Buffer, value); }
+    void PutRaw(const void* data, size_t size) { PutRaw(m_Buffer, data, size); }
+    void PutVarint(uint64_t value) { PutVarint(m_Buffer, value); }
+    void PutString(const char* data, size_t size)
+    {
+        PutVarint(size);
+        PutRaw(data, size);
+    }
+    void PutStringArg(const char* data, size_t size);
+    
+    static void PutByte(std::string& out, uint8_t value) { out.push_back(static_cast<char>(value)); }
+    static void PutRaw(std::string& out, const void* data, size_t size)
+    {
+        out.append(static_cast<const char*>(data), size);
+    }
+    static void PutVarint(std::string& out, uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            PutByte(out, static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        PutByte(out, static_cast<uint8_t>(value));
+    }
+    
+    // Строки кодируются целиком, ссылки на повторы подставляет WriteEncoded
+    static void PutStr(std::string& out, const char* data, size_t size)
+    {
+        PutByte(out, BinaryLog::TAG_STR);
+        PutVarint(out, size);
+        PutRaw(out, data, size);
+    }
+    static void PutArg(std::string& out, const std::string& value) { PutStr(out, value.data(), value.size()); }
+    static void PutArg(std::string& out, const char* value)
+    {
+        PutStr(out, value ? value : "", value ? std::strlen(value) : 0);
+    }
+    static void PutArg(std::string& out, char value)
+    {
+        PutByte(out, BinaryLog::TAG_CHAR);
+        PutByte(out, static_cast<uint8_t>(value));
+    }
+    static void PutArg(std::string& out, bool value)
+    {
+        PutByte(out, BinaryLog::TAG_BOOL);
+        PutByte(out, value ? 1 : 0);
+    }
+    static void PutArg(std::string& out, float value)
+    {
+        PutByte(out, BinaryLog::TAG_F32);
+        PutRaw(out, &value, sizeof(value));
+    }
+    static void PutArg(std::string& out, double value)
+    {
+        PutByte(out, BinaryLog::TAG_F64);
+        PutRaw(out, &value, sizeof(value));
+    }
+    
+    template <typename T>
+    static typename std::enable_if<std::is_integral<T>::value>::type PutArg(std::string& out, T value)
+    {
+        if (std::is_signed<T>::value)
+        {
+            int64_t v = static_cast<int64_t>(value);
+            PutByte(out, BinaryLog::TAG_INT);
+            PutVarint(out, (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63));
+        }
+        else
+        {
+            PutByte(out, BinaryLog::TAG_UINT);
+            PutVarint(out, static_cast<uint64_t>(value));
+        }
+    }
+    
+public:
+    static constexpr size_t FLUSH_THRESHOLD = 32 * 1024;
+    static constexpr size_t MAX_INTERNED_STRINGS = 4096;
+    static constexpr size_t MAX_INTERNED_LENGTH = 64;
+    
+    BinaryLogSink() {};
+    ~BinaryLogSink();
+    
+    BinaryLogSink(const BinaryLogSink&) = delete;
+    BinaryLogSink& operator=(const BinaryLogSink&) = delete;
+    
+    static uint32_t RegisterFormat(int level, const char* function, int line, const char* format);
+    
+    bool Open(const std::string& filename);
+    
+    // Безопасно вызывать из обработчика сигнала (logrotate, SIGHUP)
+    static void RequestReopen() { m_ReopenGeneration.fetch_add(1, std::memory_order_relaxed); }
+    void Close();
+    void Flush();
+    bool IsOpen() const { return m_File != nullptr; }
+    
+    static uint64_t Now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+    
+    // Аргументы записи в потоке вызова: u8 argc, затем значения с тегами.
+    // Буфер свой у каждого потока и живёт до следующего вызова.
+    template <typename... Args>
+    static const std::string& EncodeArgs(const Args&... args)
+    {
+        thread_local std::string encoded;
+        encoded.clear();
+        PutByte(encoded, static_cast<uint8_t>(sizeof...(Args)));
+        int expand[] = {0, (PutArg(encoded, args), 0)...};
+        (void)expand;
+        return encoded;
+    }
+    
+    // Запись из EncodeArgs; monotonicNs - момент вызова лога, а не записи
+    void WriteEncoded(uint32_t formatId, uint64_t monotonicNs, bool flushNow, const char* args, size_t size);
+    
+    uint64_t GetBytesWritten() const { return m_BytesWritten; }
+    
+private:
+    std::mutex m_Mutex;
+    FILE* m_File {nullptr};
+    std::string m_Path;
+    uint32_t m_Generation {0};
+    static std::atomic<uint32_t> m_ReopenGeneration;
+    std::string m_Buffer;
+    size_t m_RecordStart {0};
+    uint64_t m_BytesWritten {0};
+    uint64_t m_LastMonotonicNs {0};
+    uint64_t m_LastFlushNs {0};
+    std::vector<bool> m_FormatWritten;
+    std::unordered_map<std::string, uint32_t> m_Strings;
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "RelayController.h"
+
+#include <string>
+#include <mutex>
+#include <cstdint>
+
+struct CheckpointState
+{
+    int64_t energyNanoWh {0};
+    RelayState relayState {RelayState::UNKNOWN};
+    uint64_t savedAtMs {0};
+};
+
+// Файл из двух слотов фиксированного размера (A/B) с CRC32.
+// Запись идёт в слот со старой версией и завершается fdatasync, поэтому
+// оборванная запись портит только её саму - второй слот остаётся целым.
+// При загрузке берётся корректный слот с наибольшим номером.
+class Checkpoint
+{
+private:
+    bool ReadSlot(int index, CheckpointState& state, uint64_t& sequence) const;
+    bool WriteSlotLocked(const CheckpointState& state);
+    
+public:
+    static constexpr size_t SLOT_SIZE = 64;
+    
+    Checkpoint() = default;
+    ~Checkpoint();
+    
+    Checkpoint(const Checkpoint&) = delete;
+    Checkpoint& operator=(const Checkpoint&) = delete;
+    
+    bool Open(const std::string& path);
+    void Close();
+    
+    // Последнее сохранённое состояние, если в файле есть корректный слот
+    bool GetRestoredState(CheckpointState& state) const;
+    
+    // Пропускает запись, если реле не менялось и энергия выросла меньше minEnergyDeltaNanoWh
+    bool Save(const CheckpointState& state, int64_t minEnergyDeltaNanoWh = 0);
+    
+    uint64_t GetWriteCount() const { return writeCount; }
+
+private:
+    int fd {-1};
+    std::string filePath;
+    uint64_t sequence {0};
+    bool hasState {false};
+    CheckpointState lastState;
+    uint64_t writeCount {0};
+    mutable std::mutex checkpointMutex;
+};
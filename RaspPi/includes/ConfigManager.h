@@ -3,25 +3,98 @@
 #include <string>
 #include <map>
 #include <mutex>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <functional>
+
+struct ConfigValue
+{
+    std::string text;
+    int intValue {0};
+    float floatValue {0.0f};
+    bool boolValue {false};
+    bool isInt {false};
+    bool isFloat {false};
+    
+    static ConfigValue Parse(const std::string& text);
+    
+    std::string As(const std::string&) const { return text; }
+    int As(int defaultValue) const { return isInt ? intValue : defaultValue; }
+    float As(float defaultValue) const { return isFloat ? floatValue : defaultValue; }
+    bool As(bool defaultValue) const { return text.empty() ? defaultValue : boolValue; }
+};
+
+// Неизменяемый разобранный снимок конфигурации. Публикуется целиком,
+// читатели получают его атомарной загрузкой shared_ptr; старый снимок
+// освобождается, когда его отпустит последний читатель.
+class ConfigSnapshot
+{
+public:
+    const ConfigValue* Find(const std::string& key) const;
+    bool Differs(const ConfigSnapshot& other, const std::string& key) const;
+    
+    template <typename T>
+    T Get(const std::string& key, T defaultValue) const
+    {
+        const ConfigValue* value = Find(key);
+        return value ? value->As(defaultValue) : defaultValue;
+    }
+    
+    const ConfigValue* GetSlot(size_t slot) const { return slot < slots.size() ? slots[slot] : nullptr; }
+    const std::map<std::string, ConfigValue>& GetValues() const { return values; }
+    uint64_t GetVersion() const { return version; }
+    
+private:
+    friend class ConfigManager;
+    std::map<std::string, ConfigValue> values;
+    std::vector<const ConfigValue*> slots;
+    uint64_t version {0};
+};
+
+using ConfigListener = std::function<void(const ConfigSnapshot& previous, const ConfigSnapshot& current)>;
+using ConfigValidator = std::function<bool(const ConfigSnapshot& candidate, std::string& error)>;
 
 class ConfigManager
 {
 private:    
     ConfigManager();
-    bool ParseConfigFile();
+    static std::unique_ptr<ConfigSnapshot> BuildSnapshot(const std::map<std::string, std::string>& data);
+    static bool Validate(const ConfigSnapshot& candidate, std::string& error);
+    std::shared_ptr<const ConfigSnapshot> PublishLocked();
+    
+    template <typename T>
+    T GetValue(const std::string& key, T defaultValue) const
+    {
+        return CurrentSnapshot().Get(key, defaultValue);
+    }
     
 public:
     static ConfigManager& GetInstance();
+    // Разбор файла "ключ = значение"; используется и для других файлов в том же формате
+    static bool ParseConfigFile(const std::string& path, std::map<std::string, std::string>& data);
     
     ConfigManager(const ConfigManager&) = delete;
     ConfigManager& operator=(const ConfigManager&) = delete;
     
     bool LoadConfig(const std::string& path);
     bool SaveConfig();
+    // Перечитывает файл: разбор, проверка, подмена снимка, уведомление подписчиков
+    bool ReloadConfig();
+    
+    void Subscribe(ConfigListener listener);
+    void AddValidator(ConfigValidator validator);
+    std::string GetConfigPath();
+    
+    std::shared_ptr<const ConfigSnapshot> GetSnapshot() const { return std::atomic_load(&currentSnapshot); }
+    // Без счётчика ссылок на каждом чтении: снимок закреплён за потоком,
+    // ссылка действительна до следующего вызова в этом же потоке
+    const ConfigSnapshot& CurrentSnapshot() const;
+    size_t ResolveKey(const std::string& key);
     
     std::string GetString(const std::string& key, const std::string& defaultValue = "");
     int GetInt(const std::string& key, int defaultValue = 0);
-    float GetFloat(const std::string& key, int defaultValue = 0.0f);
+    float GetFloat(const std::string& key, float defaultValue = 0.0f);
     bool GetBool(const std::string& key, bool defaultValue = false);
     
     void SetString(const std::string& key, const std::string& value);
@@ -35,10 +108,44 @@ public:
     int GetGPIOPin() const;
     bool GetSimulationMode() const;
     int GetLogLevel() const;
-
+    
 private:
     static ConfigManager* instance;
     std::string configPath;
+    std::map<std::string, std::string> defaultData;
     std::map<std::string, std::string> configData;
     std::mutex configMutex;
-};
\ No newline at end of file
+    std::mutex reloadMutex;
+    
+    std::vector<ConfigListener> listeners;
+    std::vector<ConfigValidator> validators;
+    
+    // Только через std::atomic_load/std::atomic_store
+    std::shared_ptr<const ConfigSnapshot> currentSnapshot;
+    uint64_t snapshotVersion {0};
+    std::atomic<uint64_t> publishedVersion {0};
+    std::map<std::string, size_t> keySlots;
+};
+
+// Ключ разрешается в номер слота один раз; Get() - атомарная загрузка
+// снимка и индекс в массиве, без поиска по строке и разбора значения.
+template <typename T>
+class ConfigHandle
+{
+public:
+    ConfigHandle(const std::string& key, T defaultValue)
+        : manager(ConfigManager::GetInstance()),
+          slot(manager.ResolveKey(key)),
+          defaultValue(defaultValue) {}
+    
+    T Get() const
+    {
+        const ConfigValue* value = manager.CurrentSnapshot().GetSlot(slot);
+        return value ? value->As(defaultValue) : defaultValue;
+    }
+    
+private:
+    ConfigManager& manager;
+    size_t slot;
+    T defaultValue;
+};
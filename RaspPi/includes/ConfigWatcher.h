@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include <thread>
+#include <atomic>
+#include <functional>
+
+// Следит за каталогом конфигурационного файла через inotify.
+// Редакторы обычно пишут во временный файл и переименовывают его,
+// поэтому наблюдаем каталог и фильтруем события по имени файла.
+class ConfigWatcher
+{
+private:
+    void WatchLoop();
+    
+public:
+    ConfigWatcher() = default;
+    ~ConfigWatcher();
+    
+    ConfigWatcher(const ConfigWatcher&) = delete;
+    ConfigWatcher& operator=(const ConfigWatcher&) = delete;
+    
+    // onChange вызывается из потока наблюдателя после паузы debounceMs
+    bool Start(const std::string& path, std::function<void()> onChange, int debounceMs = 200);
+    void Stop();
+    
+    bool IsRunning() const { return running; }
+
+private:
+    std::string directory;
+    std::string fileName;
+    std::function<void()> changeCallback;
+    int debounce {200};
+    
+    int inotifyFd {-1};
+    int stopFd {-1};
+    std::thread watchThread;
+    std::atomic<bool> running {false};
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "SPSCQueue.h"
+
+#include <cstdint>
+#include <cmath>
+
+struct EnergyDelta
+{
+    uint64_t timestamp;     // мс, конец интервала
+    int64_t nanoWh;
+    uint32_t samples;
+};
+
+using EnergyQueue = SPSCQueue<EnergyDelta, 1024>;
+
+// Интегрирует мощность методом трапеций в счётчик с фиксированной точкой
+// (1 единица = 1 нВт*ч). Дробный остаток переносится между отсчётами,
+// поэтому округление не накапливается на любом числе отсчётов.
+class EnergyAccumulator
+{
+public:
+    static constexpr int64_t NANO_WH_PER_KWH = 1000000000000LL;
+    
+    void reset(int64_t nanoWh = 0)
+    {
+        total = nanoWh;
+        pending = 0;
+        residual = 0.0;
+        hasPrevious = false;
+    }
+    
+    void addSample(double power, uint64_t monotonicNs)
+    {
+        if (hasPrevious && monotonicNs > previousNs)
+        {
+            // Вт * нс / 3600 = нВт*ч
+            double exact = 0.5 * (previousPower + power) *
+                           static_cast<double>(monotonicNs - previousNs) / 3600.0 + residual;
+            int64_t whole = static_cast<int64_t>(std::floor(exact));
+            residual = exact - static_cast<double>(whole);
+            total += whole;
+            pending += whole;
+        }
+        
+        previousPower = power;
+        previousNs = monotonicNs;
+        hasPrevious = true;
+        samples++;
+    }
+    
+    int64_t getTotal() const { return total; }
+    int64_t getPending() const { return pending; }
+    uint32_t getPendingSamples() const { return samples; }
+    double getTotalKWh() const { return static_cast<double>(total) / NANO_WH_PER_KWH; }
+    
+    void commitPending()
+    {
+        pending = 0;
+        samples = 0;
+    }
+
+private:
+    int64_t total {0};
+    int64_t pending {0};
+    uint32_t samples {0};
+    double residual {0.0};
+    double previousPower {0.0};
+    uint64_t previousNs {0};
+    bool hasPrevious {false};
+};
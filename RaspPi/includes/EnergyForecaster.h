@@ -0,0 +1,104 @@
+#pragma once
+
+#include "TariffTable.h"
+
+#include <cstdint>
+
+enum class ForecastPeriod
+{
+    DAY = 0,
+    WEEK,
+    MONTH
+};
+
+struct PeriodForecast
+{
+    uint64_t start;                 // секунды, местная полночь
+    uint64_t end;
+    double energy;                  // кВт*ч с начала периода
+    double cost;
+    double projectedEnergy;         // к концу периода
+    double projectedCost;
+};
+
+struct EnergyForecast
+{
+    static constexpr int PERIODS = 3;
+    
+    PeriodForecast periods[PERIODS];
+    float hourEnergy;               // прогноз на текущий час, кВт*ч
+    float averagePower;             // сглаженный уровень, Вт
+    uint32_t hoursObserved;
+    uint64_t hourStart;             // 0 - показаний ещё не было
+};
+
+// Прогноз потребления до конца суток, недели и месяца. Аддитивная модель
+// Холта-Уинтерса на часовых суммах: сглаженный уровень плюс поправка для
+// каждого часа недели (праздники - как воскресенье).
+//
+// Показания приходят поминутными записями Statistics и только складываются;
+// модель обновляется при закрытии часа, тогда же пересчитываются ожидаемые
+// энергия и стоимость оставшихся часов каждого периода по таблице тарифов.
+// Чтение прогноза - постоянное время. Не потокобезопасен: вызывается под
+// мьютексом владельца.
+class EnergyForecaster
+{
+private:
+    void CloseHour(int slot, double energy);
+    void StartHour(uint64_t timestamp, const TariffTable& tariffs);
+    void UpdatePeriods(uint64_t timestamp);
+    void RecomputeRemaining(const TariffTable& tariffs);
+    float ExpectedEnergy(int slot) const;
+    
+public:
+    static constexpr int WEEK_HOURS = TariffTable::HOURS_PER_WEEK;
+    // Пропуск длиннее суток не считается нулевым потреблением
+    static constexpr int MAX_GAP_HOURS = 24;
+    
+    EnergyForecaster() = default;
+    
+    // alpha - вес нового часа в уровне, gamma - в поправке часа недели
+    void Configure(float alpha, float gamma);
+    
+    // Поминутная запись; timestamp в секундах
+    void AddReading(float energy, float cost, uint64_t timestamp, const TariffTable& tariffs);
+    // Закрыть часы без показаний до timestamp. Только из потока данных и только
+    // до момента, раньше которого записей больше не будет.
+    void Advance(uint64_t timestamp, const TariffTable& tariffs);
+    // После смены тарифов: стоимость с начала периода пересчитана владельцем
+    void SetCost(ForecastPeriod period, double cost);
+    void Reprice(const TariffTable& tariffs);
+    
+    uint64_t GetPeriodStart(ForecastPeriod period) const;
+    EnergyForecast GetForecast() const;
+    
+    static const char* PeriodName(ForecastPeriod period);
+    
+private:
+    struct Period
+    {
+        uint64_t start {0};
+        uint64_t end {0};
+        double energy {0.0};
+        double cost {0.0};
+        double remainingEnergy {0.0};   // часы после текущего до конца периода
+        double remainingCost {0.0};
+    };
+    
+    float alpha {0.05f};
+    float gamma {0.3f};
+    
+    float level {0.0f};                 // кВт*ч за час
+    float seasonal[WEEK_HOURS] {};
+    bool seen[WEEK_HOURS] {};
+    bool modelReady {false};
+    uint32_t hoursObserved {0};
+    
+    uint64_t hourStart {0};
+    uint64_t hourEnd {0};
+    int hourSlot {0};
+    float hourPrice {0.0f};
+    double hourEnergy {0.0};
+    
+    Period periods[EnergyForecast::PERIODS];
+};
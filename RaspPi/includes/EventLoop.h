@@ -0,0 +1,55 @@
+#pragma once
+
+#include <functional>
+#include <unordered_map>
+#include <initializer_list>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Однопоточный реактор на epoll. Таймеры - timerfd, сигналы - signalfd,
+// пробуждение из других потоков - eventfd. Без событий поток спит в epoll_wait.
+class EventLoop
+{
+private:
+    bool AddHandler(int fd, uint32_t events, std::function<void(uint32_t)> handler);
+    void RunPosted();
+    
+public:
+    EventLoop();
+    ~EventLoop();
+    
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+    
+    // Блокирует сигналы для вызывающего потока и всех потоков, созданных после;
+    // вызывать в начале main до запуска любых потоков
+    static bool BlockSignals(std::initializer_list<int> signals);
+    
+    bool IsValid() const { return epollFd >= 0 && wakeFd >= 0; }
+    
+    // Возвращают дескриптор регистрации или -1
+    int AddTimer(std::chrono::milliseconds interval, std::function<void()> handler);
+    int AddSignals(std::initializer_list<int> signals, std::function<void(int)> handler);
+    int AddFd(int fd, uint32_t events, std::function<void(uint32_t)> handler);
+    void Remove(int fd);
+    
+    // Потокобезопасные
+    void Post(std::function<void()> task);
+    void Stop();
+    
+    void Run();
+
+private:
+    int epollFd {-1};
+    int wakeFd {-1};
+    std::atomic<bool> stopped {false};
+    
+    std::unordered_map<int, std::function<void(uint32_t)>> handlers;
+    std::vector<int> ownedFds;
+    
+    std::mutex postMutex;
+    std::vector<std::function<void()>> posted;
+};
@@ -1,6 +1,9 @@
 #pragma once
 
 #include <string>
+#include <memory>
+
+#include "HAL.h"
 
 namespace Pins
 {
@@ -12,26 +15,19 @@ namespace Pins
 
 class GPIOController
 {
-private:
-    bool InitializeRealGPIO();
-    bool SetPinModeReal(int pin, int mode);
-    bool WritePinReal(int pin, int value);
-    int ReadPinReal(int pin);
-    
-    bool InitializeSimulation();
-    bool SetPinModeSim(int pin, int mode);
-    bool WritePinSim(int pin, int value);
-    int ReadPinSim(int pin);
-    
 public:
     GPIOController() {};
     ~GPIOController();
     
     bool Initialize(int pin, bool simulation = false);
+    // Готовая реализация GPIO, например заглушка для стенда
+    bool Initialize(int pin, std::unique_ptr<IGPIO> backend);
     void Cleanup();
     
     bool SetPinMode(int pin, int mode);
     bool WritePin(int pin, int value);
+    // Для аварийного отключения: без журнала, ошибка - только false
+    bool WritePinRaw(int pin, int value) noexcept;
     int ReadPin(int pin);
     
     bool DigitalWrite(int pin, bool state);
@@ -45,6 +41,7 @@ public:
     bool GetInitialized() const { return m_IsInitialized; }
 
 private:
+    std::unique_ptr<IGPIO> m_Backend;
     int m_PinNumber {-1};
     bool m_IsSimulation {false};
     bool m_IsInitialized {false};
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+
+// Слой абстракции оборудования: ядро работает с GPIO, шиной датчика и часами
+// только через эти интерфейсы, поэтому сервер целиком собирается и работает
+// на обычном Linux без Raspberry Pi
+
+class IGPIO
+{
+public:
+    virtual ~IGPIO() = default;
+    
+    virtual bool Setup() = 0;
+    virtual bool SetPinMode(int pin, int mode) = 0;
+    virtual bool Write(int pin, int value) = 0;
+    // Без журнала, блокировок и выделений - для аварийного отключения из потока опроса
+    virtual bool WriteRaw(int pin, int value) noexcept = 0;
+    virtual int Read(int pin) = 0;          // -1 при ошибке
+    virtual const char* GetName() const = 0;
+};
+
+// Хранит уровни выводов в памяти: Read возвращает последнее записанное значение
+class SimulatedGPIO : public IGPIO
+{
+public:
+    bool Setup() override;
+    bool SetPinMode(int pin, int mode) override;
+    bool Write(int pin, int value) override;
+    bool WriteRaw(int pin, int value) noexcept override;
+    int Read(int pin) override;
+    const char* GetName() const override { return "simulation"; }
+    
+    static constexpr int MAX_PINS = 64;
+    
+private:
+    // Без блокировок: WriteRaw вызывается из аварийного отключения в потоке опроса
+    std::atomic<int> levels[MAX_PINS] {};
+};
+
+// nullptr, если сборка без wiringPi
+std::unique_ptr<IGPIO> CreateHardwareGPIO();
+
+// Шина датчика с 16-битными регистрами (старший байт первым)
+class ISensorBus
+{
+public:
+    virtual ~ISensorBus() = default;
+    
+    virtual bool Open(int bus, int address) = 0;
+    virtual void Close() = 0;
+    virtual bool IsOpen() const = 0;
+    virtual bool ReadRegister(uint8_t reg, uint16_t& value) = 0;
+    virtual bool WriteRegister(uint8_t reg, uint16_t value) = 0;
+};
+
+// /dev/i2c-N через ioctl(I2C_SLAVE), без libi2c
+class LinuxI2CBus : public ISensorBus
+{
+public:
+    ~LinuxI2CBus() override { Close(); }
+    
+    bool Open(int bus, int address) override;
+    void Close() override;
+    bool IsOpen() const override { return fd >= 0; }
+    bool ReadRegister(uint8_t reg, uint16_t& value) override;
+    bool WriteRegister(uint8_t reg, uint16_t value) override;
+    
+private:
+    int fd {-1};
+};
+
+// Регистры в памяти для тестов и стендов; SetFailing имитирует обрыв шины
+class FakeSensorBus : public ISensorBus
+{
+public:
+    bool Open(int bus, int address) override;
+    void Close() override { open = false; }
+    bool IsOpen() const override { return open; }
+    bool ReadRegister(uint8_t reg, uint16_t& value) override;
+    bool WriteRegister(uint8_t reg, uint16_t value) override;
+    
+    void SetRegister(uint8_t reg, uint16_t value);
+    void SetFailing(bool fail) { failing = fail; }
+    
+private:
+    std::mutex mutex;
+    std::map<uint8_t, uint16_t> registers;
+    std::atomic<bool> open {false};
+    std::atomic<bool> failing {false};
+};
+
+class IClock
+{
+public:
+    virtual ~IClock() = default;
+    
+    virtual int64_t MonotonicNs() = 0;
+    virtual int64_t WallTimeMs() = 0;
+    virtual void SleepUntilNs(int64_t monotonicNs) = 0;
+};
+
+class SystemClock : public IClock
+{
+public:
+    static SystemClock& GetInstance();
+    
+    int64_t MonotonicNs() override;
+    int64_t WallTimeMs() override;
+    void SleepUntilNs(int64_t monotonicNs) override;
+};
+
+// Время идёт только по Advance или SleepUntilNs, который переводит часы
+// сразу на заданный момент: цикл опроса прокручивается без реальных пауз
+class FakeClock : public IClock
+{
+public:
+    explicit FakeClock(int64_t startWallMs = 0) : wallOffsetMs(startWallMs) {}
+    
+    int64_t MonotonicNs() override { return nowNs.load(std::memory_order_acquire); }
+    int64_t WallTimeMs() override { return wallOffsetMs + MonotonicNs() / 1000000; }
+    void SleepUntilNs(int64_t monotonicNs) override;
+    
+    void Advance(int64_t ns) { nowNs.fetch_add(ns, std::memory_order_acq_rel); }
+    
+private:
+    std::atomic<int64_t> nowNs {0};
+    int64_t wallOffsetMs;
+};
@@ -1,24 +1,31 @@
 #pragma once
 
-#ifdef RASPBERRY_PI
 #include <microhttpd.h>
-#endif
 
 #include <string>
 #include <map>
 #include <functional>
+#include <memory>
+#include <mutex>
 
 #include "RelayController.h"
 #include "SensorManager.h"
 #include "Statistics.h"
 
+// С libmicrohttpd 0.9.71 обработчик запроса возвращает enum MHD_Result
+#if MHD_VERSION >= 0x00097002
+using MHDResult = enum MHD_Result;
+#else
+using MHDResult = int;
+#endif
+
 class HTTPServer
 {
 private:
-    static int HandleRequest(void* cls, struct MHD_Connection* connection,
-                           const char* url, const char* method,
-                           const char* version, const char* upload_data,
-                           size_t* upload_data_size, void** con_cls);
+    static MHDResult HandleRequest(void* cls, struct MHD_Connection* connection,
+                                 const char* url, const char* method,
+                                 const char* version, const char* upload_data,
+                                 size_t* upload_data_size, void** con_cls);
     
     int ProcessRequest(struct MHD_Connection* connection,
                       const std::string& url, const std::string& method);
@@ -28,6 +35,7 @@ private:
                                   const std::string& relayState = "");
     
     bool CheckAuthentication(struct MHD_Connection* connection);
+    void PublishAPIKeysLocked();
     std::string GetClientIP(struct MHD_Connection* connection);
     
     void LogRequest(const std::string& clientIP, 
@@ -39,6 +47,12 @@ private:
     std::string handleStatsRequest(const std::string& period);
     std::string handleSensorConfigRequest();
     std::string handleCalibrationRequest(const std::string& params);
+    std::string handleAppliancesRequest();
+    std::string handlePowerQualityRequest(struct MHD_Connection* connection);
+    int handleExportRequest(struct MHD_Connection* connection, const std::string& clientIP);
+    int handleMetricsRequest(struct MHD_Connection* connection, const std::string& clientIP);
+    std::string handleHistoryRequest(struct MHD_Connection* connection,
+                                     std::string& contentType, int& responseCode);
     
 public:
     HTTPServer(RelayController& relayController, SensorManager& sensorMgr, Statistics& stats)
@@ -53,15 +67,25 @@ public:
     std::string GetAddress() const { return address; }
     
     void AddAPIKey(const std::string& key, const std::string& clientName = "");
+    // Ключи из конфигурации: "key[:client],key[:client]"; заменяют прежние ключи из конфигурации
+    void SetConfigAPIKeys(const std::string& keyList);
 
 private:
+    friend struct BenchAccess;
+    
     struct MHD_Daemon* daemon {nullptr};
     RelayController& relay;
     std::string address {"0.0.0.0"};
     int port {5000};
     bool running {false};
     
-    std::map<std::string, std::string> apiKeys;
+    using APIKeyMap = std::map<std::string, std::string>;
+    
+    // Обработчики читают неизменяемую копию, запись - копирование с подменой
+    std::shared_ptr<const APIKeyMap> apiKeys {std::make_shared<APIKeyMap>()};
+    APIKeyMap manualKeys;
+    APIKeyMap configKeys;
+    std::mutex apiKeysMutex;
 
     SensorManager& sensorManager;
     Statistics& statistics;
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+// Модель одного прибора. Модели складываются: суммарная нагрузка - сумма
+// всех приборов плюс постоянная нагрузка и кратковременные выбросы.
+struct ApplianceModel
+{
+    std::string name;
+    float power {0.0f};           // Вт в установившемся режиме
+    float powerFactor {1.0f};     // косинус фи основной гармоники
+    float onSeconds {0.0f};       // 0 - прибор включён постоянно
+    float offSeconds {0.0f};
+    float phaseSeconds {0.0f};    // сдвиг начала цикла
+    float rampSeconds {0.0f};     // плавный набор мощности после включения
+    float inrushFactor {1.0f};    // кратность пускового тока
+    float inrushMs {0.0f};        // постоянная затухания пускового тока
+    float thirdHarmonic {0.0f};   // доли тока основной гармоники
+    float fifthHarmonic {0.0f};
+    float noise {0.0f};           // относительный шум мощности (СКО)
+};
+
+struct LoadSample
+{
+    float power {0.0f};           // активная, Вт
+    float reactive {0.0f};        // реактивная, вар
+    float apparent {0.0f};        // полная с учётом гармоник, ВА
+    float current {0.0f};         // действующий ток, А
+};
+
+// Генератор нагрузки для режима симуляции. Время - монотонные наносекунды
+// (IClock), поэтому отсчёты можно получать с любой частотой и без реальных пауз.
+//
+// Файл профиля в формате конфигурации, по ключу на параметр прибора:
+//   appliance.fridge.power = 120
+//   appliance.fridge.on = 900
+//   appliance.fridge.off = 1800
+//   appliance.fridge.inrush = 6
+//   base_load = 40
+// Параметры: power, pf, on, off, phase, ramp, inrush, inrush_ms, h3, h5, noise.
+class LoadSimulator
+{
+private:
+    float ApplianceFactor(const ApplianceModel& model, double seconds) const;
+    
+public:
+    static constexpr float NOMINAL_VOLTAGE = 230.0f;
+    static constexpr float NOMINAL_FREQUENCY = 50.0f;
+    
+    bool LoadProfile(const std::string& path);
+    void AddAppliance(const ApplianceModel& model);
+    void ClearAppliances();
+    size_t GetApplianceCount() const;
+    
+    void Seed(uint32_t seed);
+    
+    // Постоянная резистивная нагрузка (simulateLoad)
+    void SetBaseLoad(float power);
+    // Выброс мощности поверх профиля на durationMs (simulatePowerSpike)
+    void AddSpike(float power, int durationMs, int64_t nowNs);
+    
+    LoadSample Sample(int64_t nowNs);
+    
+    // Мгновенные напряжение и ток с частотой sampleRateHz; гармоники 3 и 5
+    // задаются моделями приборов. voltageRms - действующее напряжение сети,
+    // например с учётом просадки от нагрузки
+    void FillWaveform(int64_t startTimeNs, double sampleRateHz, size_t count, float* voltage, float* current,
+                      float voltageRms = NOMINAL_VOLTAGE);
+    
+private:
+    struct Spike
+    {
+        float power;
+        int64_t endNs;
+    };
+    
+    mutable std::mutex simulatorMutex;
+    std::vector<ApplianceModel> appliances;
+    std::vector<Spike> spikes;
+    float baseLoad {100.0f};
+    int64_t startNs {-1};
+    std::mt19937 rng {5489u};
+};
@@ -7,6 +7,17 @@
 #include <chrono>
 #include <iomanip>
 #include <sstream>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+#include <charconv>
+#include <cstring>
+#include <type_traits>
+#include <functional>
+#include <vector>
+
+#include "MPSCQueue.h"
+#include "BinaryLogSink.h"
 
 enum class LogLevel
 {
@@ -16,6 +27,55 @@ enum class LogLevel
     ERROR = 3
 };
 
+// Минимальный уровень, оставляемый в бинарнике: вызовы ниже него
+// превращаются в мёртвый код и удаляются компилятором (0 - DEBUG ... 3 - ERROR)
+#ifndef SMART_PLUG_MIN_LOG_LEVEL
+#define SMART_PLUG_MIN_LOG_LEVEL 0
+#endif
+
+enum class LogOverflowPolicy
+{
+    DROP = 0,
+    BLOCK = 1
+};
+
+struct AsyncLogConfig
+{
+    size_t queueSize {4096};
+    LogOverflowPolicy overflow {LogOverflowPolicy::DROP};
+    int flushIntervalMs {1000};       // максимальная задержка записи в файл
+    size_t flushEveryRecords {256};   // сброс после стольких записей в пачке
+    bool flushOnError {true};         // ERROR сбрасывается сразу
+};
+
+struct LogRotationConfig
+{
+    uint64_t maxBytes {10 * 1024 * 1024};  // 0 - без ротации по размеру
+    int maxAgeSeconds {0};                  // 0 - без ротации по времени
+    int keepFiles {5};
+    bool compress {false};                  // gzip в фоне после ротации
+};
+
+struct LogRecord
+{
+    static constexpr size_t MAX_FUNCTION = 48;
+    static constexpr size_t MAX_MESSAGE = 432;
+    static constexpr size_t MAX_ARGS = 256;
+    
+    int64_t timestampNs;
+    uint64_t monotonicNs;           // время для бинарного журнала
+    LogLevel level;
+    int line;
+    uint32_t formatId;
+    bool text;                      // есть текстовое сообщение
+    uint16_t functionLength;
+    uint16_t messageLength;
+    uint16_t argsLength;            // 0 - без бинарной записи
+    char function[MAX_FUNCTION];
+    char message[MAX_MESSAGE];
+    char args[MAX_ARGS];            // BinaryLogSink::EncodeArgs
+};
+
 class Logger
 {
 private:    
@@ -23,10 +83,84 @@ private:
     std::string GetCurrentTime();
     std::string LevelToString(LogLevel level);
     
+    void Submit(LogLevel level, const std::string* message, const char* function, int line,
+                uint32_t formatId, const std::string* binaryArgs);
+    bool EnqueueAsync(LogLevel level, const std::string* message, const char* function, int line,
+                      uint32_t formatId, uint64_t monotonicNs, const std::string* binaryArgs);
+    void WriterLoop();
+    void DrainQueue();
+    void WriteRecord(const LogRecord& record, std::string& batch);
+    void FormatRecord(const LogRecord& record, std::string& out);
+    void WriteBatch(std::string& batch, bool flush);
+    
+    void WriteToFileLocked(const char* data, size_t size);
+    void OpenLogFileLocked();
+    void RotateLocked();
+    void StartBackgroundWorkLocked();
+    static bool IsRotatedName(const std::string& name, const std::string& baseName);
+    static void CompressAndPrune(std::vector<std::string> rotatedFiles, std::string baseFile, bool compress, int keepFiles);
+    static void CountRecord(LogLevel level);
+    
+    static void AppendArg(std::string& out, const std::string& value) { out += value; }
+    static void AppendArg(std::string& out, const char* value) { out += value ? value : "(null)"; }
+    static void AppendArg(std::string& out, char value) { out += value; }
+    static void AppendArg(std::string& out, bool value) { out += value ? "true" : "false"; }
+    
+    template <typename T>
+    static typename std::enable_if<std::is_arithmetic<T>::value>::type AppendArg(std::string& out, T value)
+    {
+        char buffer[32];
+        auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        out.append(buffer, result.ptr);
+    }
+    
+    static void AppendFormat(std::string& out, const char* format)
+    {
+        out += format;
+    }
+    
+    template <typename T, typename... Rest>
+    static void AppendFormat(std::string& out, const char* format, const T& value, const Rest&... rest)
+    {
+        const char* placeholder = std::strstr(format, "{}");
+        if (!placeholder)
+        {
+            out += format;
+            return;
+        }
+        
+        out.append(format, placeholder);
+        AppendArg(out, value);
+        AppendFormat(out, placeholder + 2, rest...);
+    }
+    
 public:
     static Logger& GetInstance();
     ~Logger();
     
+    static bool IsEnabled(LogLevel level)
+    {
+        return level >= m_CurrentLevel.load(std::memory_order_relaxed);
+    }
+    
+    static uint32_t RegisterFormat(LogLevel level, const char* function, int line, const char* format)
+    {
+        return BinaryLogSink::RegisterFormat(static_cast<int>(level), function, line, format);
+    }
+    
+    template <typename... Args>
+    static const char* FormatString(const char* format, const Args&...) { return format; }
+    
+    // Подставляет аргументы вместо "{}" по порядку
+    template <typename... Args>
+    static std::string Format(const char* format, const Args&... args)
+    {
+        std::string out;
+        out.reserve(std::strlen(format) + 16 * sizeof...(Args));
+        AppendFormat(out, format, args...);
+        return out;
+    }
+    
     Logger(const Logger&) = delete;
     Logger& operator=(const Logger&) = delete;
     
@@ -34,22 +168,125 @@ public:
     void EnableConsoleOutput(bool enable);
     void EnableFileOutput(bool enable, const std::string& filename = "");
     
-    void Log(LogLevel level, const std::string& message, const std::string& function = "", int line = 0);
-    void Debug(const std::string& message, const std::string& function = "", int line = 0);
-    void Info(const std::string& message, const std::string& function = "", int line = 0);
-    void Warning(const std::string& message, const std::string& function = "", int line = 0);
-    void Error(const std::string& message, const std::string& function = "", int line = 0);
-
+    void EnableBinaryOutput(bool enable, const std::string& filename = "");
+    void SetRotation(const LogRotationConfig& config);
+    // Пока возвращает true, сжатие и удаление старых файлов откладываются.
+    // Вызывается под мьютексом логгера, поэтому сама писать в лог не должна.
+    void SetBackgroundWorkGate(std::function<bool()> shouldDefer);
+    
+    // Безопасно вызывать из обработчика сигнала: файл переоткроется писателем
+    static void RequestReopen()
+    {
+        m_ReopenRequested.store(true, std::memory_order_relaxed);
+        BinaryLogSink::RequestReopen();
+    }
+    
+    void EnableAsyncMode(const AsyncLogConfig& config = AsyncLogConfig());
+    void DisableAsyncMode();
+    bool IsAsync() const { return m_Async.load(std::memory_order_acquire); }
+    uint64_t GetDroppedCount() const { return m_Dropped.load(std::memory_order_relaxed); }
+    void Flush();
+    
+    void Log(LogLevel level, const std::string& message, const char* function = "", int line = 0);
+    void Debug(const std::string& message, const char* function = "", int line = 0);
+    void Info(const std::string& message, const char* function = "", int line = 0);
+    void Warning(const std::string& message, const char* function = "", int line = 0);
+    void Error(const std::string& message, const char* function = "", int line = 0);
+    
+    bool HasTextOutput() const
+    {
+        return m_WriteToConsole.load(std::memory_order_relaxed) || m_WriteToFile.load(std::memory_order_relaxed);
+    }
+    
+    // Бинарная запись кодируется здесь, а пишется тем же потоком, что и текст
+    void LogMessage(LogLevel level, uint32_t formatId, const std::string& message, const char* function, int line)
+    {
+        const std::string* binaryArgs = m_WriteBinary.load(std::memory_order_relaxed)
+            ? &BinaryLogSink::EncodeArgs(message) : nullptr;
+        Submit(level, HasTextOutput() ? &message : nullptr, function, line, formatId, binaryArgs);
+    }
+    
+    template <typename... Args>
+    void LogFormat(LogLevel level, uint32_t formatId, const char* function, int line,
+                   const char* format, const Args&... args)
+    {
+        const std::string* binaryArgs = m_WriteBinary.load(std::memory_order_relaxed)
+            ? &BinaryLogSink::EncodeArgs(args...) : nullptr;
+        if (HasTextOutput())
+        {
+            std::string message = Format(format, args...);
+            Submit(level, &message, function, line, formatId, binaryArgs);
+        }
+        else
+            Submit(level, nullptr, function, line, formatId, binaryArgs);
+    }
+    
 private:
     static Logger* m_Instance;
     std::ofstream m_LogFile;
     std::mutex m_Mutex;
-    LogLevel m_CurrentLevel {LogLevel::INFO};
-    bool m_WriteToConsole {true};
-    bool m_WriteToFile {false};
+    static std::atomic<LogLevel> m_CurrentLevel;
+    std::atomic<bool> m_WriteToConsole {true};
+    std::atomic<bool> m_WriteToFile {false};
+    std::atomic<bool> m_WriteBinary {false};
+    std::string m_LogFileName;
+    uint64_t m_FileBytes {0};
+    std::chrono::steady_clock::time_point m_FileOpenedAt;
+    LogRotationConfig m_Rotation;
+    bool m_RotationFailed {false};          // об ошибке ротации пишется один раз
+    std::function<bool()> m_DeferBackgroundWork;
+    std::vector<std::string> m_PendingRotated;  // ещё не сжаты: фон был отложен
+    std::chrono::steady_clock::time_point m_DeferredCheckAt;
+    static std::atomic<bool> m_ReopenRequested;
+    BinaryLogSink m_BinarySink;
+    
+    std::atomic<bool> m_Async {false};
+    std::atomic<bool> m_WriterRunning {false};
+    std::atomic<bool> m_WriterIdle {false};
+    std::atomic<bool> m_FlushRequested {false};
+    std::atomic<uint64_t> m_Dropped {0};
+    std::atomic<int> m_Producers {0};       // потоки, которые сейчас пишут в очередь
+    std::unique_ptr<MPSCQueue<LogRecord>> m_Queue;
+    AsyncLogConfig m_AsyncConfig;           // читает только писатель
+    std::atomic<LogOverflowPolicy> m_Overflow {LogOverflowPolicy::DROP};
+    std::atomic<bool> m_FlushOnError {true};
+    std::thread m_WriterThread;
+    std::mutex m_WakeMutex;
+    std::condition_variable m_WakeCondition;
+    std::condition_variable m_FlushedCondition;
+    
+    int64_t m_CachedSecond {-1};
+    char m_CachedTime[24] {};
 };
 
-#define LOG_DEBUG(msg) Logger::GetInstance().Debug(msg, __FUNCTION__, __LINE__)
-#define LOG_INFO(msg) Logger::GetInstance().Info(msg, __FUNCTION__, __LINE__)
-#define LOG_WARNING(msg) Logger::GetInstance().Warning(msg, __FUNCTION__, __LINE__)
-#define LOG_ERROR(msg) Logger::GetInstance().Error(msg, __FUNCTION__, __LINE__)
\ No newline at end of file
+// Уровень проверяется до вычисления msg, поэтому отключённые вызовы
+// не строят строку сообщения. Каждое место вызова один раз регистрирует
+// свою строку формата для бинарного журнала.
+#define LOG_AT(level, msg) \
+    do { \
+        if (static_cast<int>(level) >= SMART_PLUG_MIN_LOG_LEVEL && Logger::IsEnabled(level)) \
+        { \
+            static const uint32_t logFormatId = Logger::RegisterFormat(level, __FUNCTION__, __LINE__, "{}"); \
+            Logger::GetInstance().LogMessage(level, logFormatId, msg, __FUNCTION__, __LINE__); \
+        } \
+    } while (0)
+
+#define LOG_AT_FORMAT(level, ...) \
+    do { \
+        if (static_cast<int>(level) >= SMART_PLUG_MIN_LOG_LEVEL && Logger::IsEnabled(level)) \
+        { \
+            static const uint32_t logFormatId = Logger::RegisterFormat(level, __FUNCTION__, __LINE__, \
+                                                                       Logger::FormatString(__VA_ARGS__)); \
+            Logger::GetInstance().LogFormat(level, logFormatId, __FUNCTION__, __LINE__, __VA_ARGS__); \
+        } \
+    } while (0)
+
+#define LOG_DEBUG(msg) LOG_AT(LogLevel::DEBUG, msg)
+#define LOG_INFO(msg) LOG_AT(LogLevel::INFO, msg)
+#define LOG_WARNING(msg) LOG_AT(LogLevel::WARNING, msg)
+#define LOG_ERROR(msg) LOG_AT(LogLevel::ERROR, msg)
+
+#define LOG_DEBUGF(...) LOG_AT_FORMAT(LogLevel::DEBUG, __VA_ARGS__)
+#define LOG_INFOF(...) LOG_AT_FORMAT(LogLevel::INFO, __VA_ARGS__)
+#define LOG_WARNINGF(...) LOG_AT_FORMAT(LogLevel::WARNING, __VA_ARGS__)
+#define LOG_ERRORF(...) LOG_AT_FORMAT(LogLevel::ERROR, __VA_ARGS__)
\ No newline at end of file
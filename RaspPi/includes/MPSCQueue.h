@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Ограниченная очередь на много писателей и одного читателя (схема Вьюкова):
+// у каждой ячейки свой счётчик последовательности, писатели резервируют
+// ячейку через CAS на хвосте, читатель забирает без блокировок.
+template <typename T>
+class MPSCQueue
+{
+private:
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+    
+public:
+    explicit MPSCQueue(size_t requestedCapacity)
+    {
+        capacity = 2;
+        while (capacity < requestedCapacity)
+            capacity <<= 1;
+        mask = capacity - 1;
+        
+        cells.reset(new Cell[capacity]);
+        for (size_t i = 0; i < capacity; i++)
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    
+    MPSCQueue(const MPSCQueue&) = delete;
+    MPSCQueue& operator=(const MPSCQueue&) = delete;
+    
+    // Возвращает ячейку для заполнения или nullptr, если очередь полна
+    T* beginPush(size_t& ticket)
+    {
+        size_t pos = tail.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Cell& cell = cells[pos & mask];
+            size_t seq = cell.sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            
+            if (diff == 0)
+            {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    ticket = pos;
+                    return &cell.data;
+                }
+            }
+            else if (diff < 0)
+                return nullptr;
+            else
+                pos = tail.load(std::memory_order_relaxed);
+        }
+    }
+    
+    void commitPush(size_t ticket)
+    {
+        cells[ticket & mask].sequence.store(ticket + 1, std::memory_order_release);
+    }
+    
+    // Возвращает готовую ячейку для чтения или nullptr, если очередь пуста
+    T* front()
+    {
+        Cell& cell = cells[head & mask];
+        size_t seq = cell.sequence.load(std::memory_order_acquire);
+        return seq == head + 1 ? &cell.data : nullptr;
+    }
+    
+    void pop()
+    {
+        cells[head & mask].sequence.store(head + capacity, std::memory_order_release);
+        head++;
+    }
+    
+    bool empty() const
+    {
+        return cells[head & mask].sequence.load(std::memory_order_acquire) != head + 1;
+    }
+    
+    size_t getCapacity() const { return capacity; }
+
+private:
+    std::unique_ptr<Cell[]> cells;
+    size_t capacity {0};
+    size_t mask {0};
+    alignas(64) std::atomic<size_t> tail {0};
+    alignas(64) size_t head {0};
+};
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <deque>
+#include <initializer_list>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Метрики для /metrics в текстовом формате Prometheus.
+// Горячие пути (Add/Set/Observe) - только relaxed-атомики без блокировок;
+// счётчики и гистограммы разнесены по шардам, чтобы потоки не делили кэш-линии.
+
+constexpr size_t METRIC_SHARDS = 8;
+
+inline size_t MetricShardIndex()
+{
+    static std::atomic<size_t> nextShard {0};
+    static thread_local size_t shard = nextShard.fetch_add(1, std::memory_order_relaxed) % METRIC_SHARDS;
+    return shard;
+}
+
+class Counter
+{
+public:
+    void Add(uint64_t value = 1)
+    {
+        shards[MetricShardIndex()].value.fetch_add(value, std::memory_order_relaxed);
+    }
+    
+    uint64_t Value() const;
+
+private:
+    struct alignas(64) Shard
+    {
+        std::atomic<uint64_t> value {0};
+    };
+    
+    Shard shards[METRIC_SHARDS];
+};
+
+class Gauge
+{
+public:
+    void Set(double value) { gaugeValue.store(value, std::memory_order_relaxed); }
+    void Add(double delta);
+    double Value() const { return gaugeValue.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<double> gaugeValue {0.0};
+};
+
+class Histogram
+{
+public:
+    static constexpr size_t MAX_BUCKETS = 16;
+    
+    explicit Histogram(std::initializer_list<double> upperBounds);
+    
+    void Observe(double value);
+    
+    size_t GetBucketCount() const { return boundCount; }
+    double GetBound(size_t index) const { return bounds[index]; }
+    // cumulative: boundCount + 1 элементов, последний - корзина +Inf
+    void Collect(uint64_t* cumulative, double& sum) const;
+
+private:
+    struct alignas(64) Shard
+    {
+        std::atomic<uint64_t> counts[MAX_BUCKETS + 1] {};
+        std::atomic<double> sum {0.0};
+    };
+    
+    double bounds[MAX_BUCKETS] {};
+    size_t boundCount {0};
+    Shard shards[METRIC_SHARDS];
+};
+
+class MetricsRegistry
+{
+private:
+    enum class MetricType
+    {
+        COUNTER,
+        GAUGE,
+        HISTOGRAM
+    };
+    
+    // Все строки вывода готовятся при регистрации, рендер только копирует их и числа
+    struct Series
+    {
+        std::string labels;
+        std::string prefix;
+        std::vector<std::string> bucketPrefixes;
+        std::string sumPrefix;
+        std::string countPrefix;
+        void* metric;
+    };
+    
+    struct Family
+    {
+        std::string name;
+        MetricType type;
+        std::string header;
+        std::vector<Series> series;
+    };
+    
+    MetricsRegistry() = default;
+    Family& GetFamilyLocked(const std::string& name, const std::string& help, MetricType type);
+    static const Series* FindSeries(const Family& family, const std::string& labels);
+    
+public:
+    static MetricsRegistry& GetInstance();
+    
+    MetricsRegistry(const MetricsRegistry&) = delete;
+    MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+    
+    // Регистрация редкая (обычно через static-ссылки); повторный вызов возвращает ту же метрику.
+    // labels - готовая строка вида: route="/power",code="200"
+    Counter& GetCounter(const std::string& name, const std::string& help, const std::string& labels = "");
+    Gauge& GetGauge(const std::string& name, const std::string& help, const std::string& labels = "");
+    Histogram& GetHistogram(const std::string& name, const std::string& help,
+                            std::initializer_list<double> upperBounds, const std::string& labels = "");
+    
+    // Пишет в buffer без выделения памяти и возвращает полный размер вывода.
+    // Если он больше capacity, вывод обрезан и нужен буфер побольше.
+    size_t Render(char* buffer, size_t capacity) const;
+
+private:
+    static MetricsRegistry* instance;
+    mutable std::mutex registryMutex;
+    std::deque<Family> families;
+    std::deque<Counter> counters;
+    std::deque<Gauge> gauges;
+    std::deque<Histogram> histograms;
+};
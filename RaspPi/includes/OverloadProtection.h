@@ -0,0 +1,90 @@
+#pragma once
+
+#include "PowerMonitor.h"
+#include "HAL.h"
+
+#include <atomic>
+#include <cstdint>
+
+class RelayController;
+class AlertEngine;
+
+struct ProtectionSettings
+{
+    bool enabled {false};
+    float ratedCurrent {10.0f};       // А, длительно допустимый ток
+    float instantCurrent {40.0f};     // А, мгновенное отключение; 0 - выключено
+    float instantPower {0.0f};        // Вт, мгновенное отключение; 0 - выключено
+    float i2t {500.0f};               // А²·с сверх номинала до отключения; 0 - выключено
+};
+
+enum class TripReason
+{
+    NONE = 0,
+    INSTANT_CURRENT,
+    INSTANT_POWER,
+    I2T
+};
+
+struct ProtectionStatus
+{
+    uint64_t trips;
+    TripReason lastReason;
+    float lastValue;
+    int64_t lastLatencyNs;            // от готовности отсчёта до записи в GPIO
+    int64_t maxLatencyNs;
+    float thermalLoad;                // накопленный I²t относительно порога, 0..1
+};
+
+// Защита от перегрузки. Check вызывается в потоке опроса на каждом отсчёте и при
+// срабатывании сразу отключает реле через RelayController::EmergencyOff, без
+// мьютексов, логов и выделения памяти. Время срабатывания по I²t при токе I > Iном:
+// t = i2t / (I² - Iном²); ниже номинала накопленное тепло так же остывает.
+// Остальное (лог, контрольная точка) - через событие TRIP_RULE в AlertEngine.
+class OverloadProtection
+{
+private:
+    void Trip(TripReason reason, float value, float limit, const PowerData& data, int64_t acquiredNs, IClock& clock);
+    
+public:
+    static constexpr const char* TRIP_RULE = "overload_trip";
+    
+    OverloadProtection() = default;
+    
+    OverloadProtection(const OverloadProtection&) = delete;
+    OverloadProtection& operator=(const OverloadProtection&) = delete;
+    
+    // Из любого потока; поток опроса подхватит значения на следующем отсчёте
+    void Configure(const ProtectionSettings& settings);
+    void SetRelay(RelayController* relayController) { relay.store(relayController, std::memory_order_release); }
+    void SetAlertEngine(AlertEngine* engine) { alerts.store(engine, std::memory_order_release); }
+    RelayController* GetRelay() const { return relay.load(std::memory_order_acquire); }
+    
+    // Только из потока опроса. monotonicNs - время отсчёта для интегрирования I²t,
+    // acquiredNs - начало чтения датчика; задержка до записи в GPIO, включая
+    // время шины, отсчитывается по тем же часам clock.
+    bool Check(const PowerData& data, int64_t monotonicNs, int64_t acquiredNs, IClock& clock);
+    
+    ProtectionStatus GetStatus() const;
+    
+private:
+    std::atomic<bool> enabled {false};
+    std::atomic<float> ratedCurrent {10.0f};
+    std::atomic<float> instantCurrent {40.0f};
+    std::atomic<float> instantPower {0.0f};
+    std::atomic<float> i2tLimit {500.0f};
+    
+    std::atomic<RelayController*> relay {nullptr};
+    std::atomic<AlertEngine*> alerts {nullptr};
+    
+    // Состояние потока опроса
+    double heat {0.0};
+    int64_t lastSampleNs {-1};
+    
+    std::atomic<float> thermalLoad {0.0f};
+    std::atomic<uint64_t> trips {0};
+    std::atomic<TripReason> lastReason {TripReason::NONE};
+    std::atomic<float> lastValue {0.0f};
+    std::atomic<int64_t> lastLatencyNs {0};
+    std::atomic<int64_t> maxLatencyNs {0};
+};
@@ -6,6 +6,21 @@
 #include <chrono>
 #include <string>
 #include <vector>
+#include <memory>
+#include <random>
+
+#include "EnergyAccumulator.h"
+#include "HAL.h"
+#include "LoadSimulator.h"
+
+class PowerTraceReader;
+class PowerTraceRecorder;
+class AlertEngine;
+class OverloadProtection;
+class SamplingGovernor;
+class ApplianceDetector;
+class AnomalyDetector;
+class PowerQualityMonitor;
 
 struct PowerData
 {
@@ -30,7 +45,7 @@ private:
     PowerData readFromI2C();
     PowerData readFromAnalog();
     PowerData readFromPZEM();
-    PowerData simulateData();
+    PowerData simulateData(int64_t nowNs);
     
     void monitoringLoop();
     void updateStatistics(const PowerData& data);
@@ -41,7 +56,8 @@ public:
         SENSOR_I2C,
         SENSOR_ANALOG,
         SENSOR_PZEM,
-        SENSOR_SIMULATION
+        SENSOR_SIMULATION,
+        SENSOR_REPLAY
     };
     
     PowerMonitor();
@@ -61,6 +77,7 @@ public:
     float getCurrent() const;
     float getPower() const;
     float getEnergy() const;
+    int64_t getEnergyNanoWh() const { return energyTotalNanoWh.load(std::memory_order_relaxed); }
     float getPowerFactor() const;
     
     float getAveragePower(int seconds = 60);
@@ -68,11 +85,40 @@ public:
     float getMinPower(int seconds = 60);
     
     void resetEnergy();
+    // Восстановление счётчика из контрольной точки; безопасно и при работающем потоке
+    void restoreEnergy(int64_t nanoWh);
+    
+    void setEnergySink(EnergyQueue* queue) { energySink.store(queue, std::memory_order_release); }
+    // Правила проверяются на каждом отсчёте в потоке опроса
+    void setAlertEngine(AlertEngine* engine) { alertEngine.store(engine, std::memory_order_release); }
+    // Проверяется первым на каждом отсчёте, до учёта энергии и правил
+    void setProtection(OverloadProtection* guard) { protection.store(guard, std::memory_order_release); }
+    // Интервал опроса выбирает регулятор; без него - setSampleRate
+    void setGovernor(SamplingGovernor* samplingGovernor) { governor.store(samplingGovernor, std::memory_order_release); }
+    void setApplianceDetector(ApplianceDetector* detector) { applianceDetector.store(detector, std::memory_order_release); }
+    void setAnomalyDetector(AnomalyDetector* detector) { anomalyDetector.store(detector, std::memory_order_release); }
+    // В симуляции получает блоки формы, иначе показания датчика
+    void setPowerQuality(PowerQualityMonitor* monitor) { powerQuality.store(monitor, std::memory_order_release); }
+    // Вызывать до initialize: по умолчанию системные часы и /dev/i2c-N
+    void setClock(IClock* source) { clock = source ? source : &SystemClock::GetInstance(); }
+    void setSensorBus(std::unique_ptr<ISensorBus> bus) { sensorBus = std::move(bus); }
+    void setSampleRate(int hz);
     
     bool isInitialized() const;
     bool isDataValid() const;
     
     void simulateLoad(float power);
+    void simulatePowerSpike(float power, int durationMs);
+    void setSimulationSeed(uint32_t seed);
+    LoadSimulator& getLoadSimulator() { return loadSimulator; }
+    
+    // Источник для SENSOR_REPLAY, задаётся до initialize.
+    // speed: 1 - реальное время, 1000 - ускорение, 0 - без пауз
+    bool setReplaySource(const std::string& path, double speed = 1.0);
+    bool isReplayFinished() const { return replayFinished; }
+    
+    // Каждый отсчёт дописывается в трассу; recorder должен пережить stop()
+    void setRecorder(PowerTraceRecorder* traceRecorder) { recorder.store(traceRecorder, std::memory_order_release); }
 
 private:
     std::atomic<bool> running {false};
@@ -82,11 +128,40 @@ private:
     PowerData currentData;
     PowerData lastValidData;
     
+    IClock* clock {&SystemClock::GetInstance()};
+    std::unique_ptr<ISensorBus> sensorBus;
+    
     int i2cAddress {0x40};
     int i2cBus {1};
     bool simulationMode {true};
     float calibrationFactor {1.0};
     
+    friend struct BenchAccess;
+    
     std::vector<float> powerHistory;
     size_t historySize {3600}; 
+    
+    EnergyAccumulator energyAccumulator;
+    std::atomic<int64_t> energyTotalNanoWh {0};
+    std::atomic<bool> energyResetRequested {false};
+    std::atomic<int64_t> energyResetValue {0};
+    std::atomic<EnergyQueue*> energySink {nullptr};
+    std::atomic<AlertEngine*> alertEngine {nullptr};
+    std::atomic<OverloadProtection*> protection {nullptr};
+    std::atomic<SamplingGovernor*> governor {nullptr};
+    std::atomic<ApplianceDetector*> applianceDetector {nullptr};
+    std::atomic<AnomalyDetector*> anomalyDetector {nullptr};
+    std::atomic<PowerQualityMonitor*> powerQuality {nullptr};
+    std::atomic<int64_t> sampleIntervalUs {100000};
+    
+    // Фиксированное зерно по умолчанию: прогоны в режиме симуляции воспроизводимы
+    std::mt19937 simulationRng {5489u};
+    LoadSimulator loadSimulator;
+    std::unique_ptr<float[]> waveformVoltage;
+    std::unique_ptr<float[]> waveformCurrent;
+    
+    std::unique_ptr<PowerTraceReader> replaySource;
+    double replaySpeed {1.0};
+    std::atomic<bool> replayFinished {false};
+    std::atomic<PowerTraceRecorder*> recorder {nullptr};
 };
\ No newline at end of file
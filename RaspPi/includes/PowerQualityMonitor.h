@@ -0,0 +1,174 @@
+#pragma once
+
+#include "PowerMonitor.h"
+#include "SeqLock.h"
+
+#include <cstddef>
+#include <cstdint>
+
+class AlertEngine;
+
+enum class PQEventType : uint8_t
+{
+    SAG = 0,
+    SWELL,
+    INTERRUPTION,
+    FREQUENCY
+};
+
+struct PQSettings
+{
+    bool enabled {true};
+    float nominalVoltage {230.0f};      // Udin, В
+    float nominalFrequency {50.0f};     // 50 - окна 10/150 периодов, 60 - 12/180
+    float sagThreshold {0.90f};         // доли Udin
+    float swellThreshold {1.10f};
+    float interruptionThreshold {0.05f};
+    float hysteresis {0.02f};           // доли Udin
+    float frequencyTolerance {0.5f};    // Гц от номинала
+    bool waveform {true};               // анализ формы, если источник её даёт
+    int samplesPerCycle {64};
+};
+
+struct PQEvent
+{
+    uint64_t start;                     // мс
+    uint32_t durationMs;
+    float extreme;                      // остаточное или наибольшее напряжение, крайняя частота
+    PQEventType type;
+};
+
+struct PQAggregate
+{
+    float voltage;                      // действующее за окно, В
+    float frequency;                    // 0 - не измерена
+    float voltageThd;                   // доли основной гармоники; 0 без формы
+    float currentThd;
+    uint64_t timestamp;                 // конец окна, мс
+};
+
+struct PQSnapshot
+{
+    static constexpr int MAX_EVENTS = 64;
+    static constexpr int MAX_HARMONIC = 25;
+    
+    PQEvent events[MAX_EVENTS];         // кольцо завершённых событий
+    int eventCount;
+    int nextEvent;
+    uint64_t totalEvents;
+    
+    bool voltageActive;                 // событие ещё идёт; durationMs - на момент снимка
+    PQEvent voltageEvent;
+    bool frequencyActive;
+    PQEvent frequencyEvent;
+    
+    PQAggregate shortWindow;            // 10/12 периодов
+    PQAggregate longWindow;             // 150/180 периодов
+    bool waveform;                      // последнее окно посчитано по форме
+    // [0] - действующее значение основной гармоники, дальше доли от неё
+    float voltageHarmonics[MAX_HARMONIC];
+    float currentHarmonics[MAX_HARMONIC];
+};
+
+// Качество электроэнергии в стиле IEC 61000-4-30: провалы, перенапряжения
+// и прерывания по действующему значению за период, обновляемому каждые
+// полпериода, и отклонения частоты по окну 150/180 периодов.
+//
+// Если источник даёт форму (в симуляции), блок 10/12 периодов обрабатывается
+// целиком в потоке опроса: Urms(1/2), частота по переходам через ноль и
+// гармоники до 25-й алгоритмом Гёрцеля, откуда THD. Иначе каждое показание
+// датчика считается одним коротким окном, а THD не вычисляется.
+//
+// Завершённые события хранятся в кольце фиксированного размера и
+// публикуются снимком; начало события уходит в AlertEngine (pq_*).
+class PowerQualityMonitor
+{
+private:
+    // Пороги в вольтах и герцах, пересчитываются при смене настроек
+    struct Limits
+    {
+        bool enabled;
+        bool waveform;
+        float nominalFrequency;
+        float sagStart;
+        float sagEnd;
+        float swellStart;
+        float swellEnd;
+        float interruption;
+        float frequencyTolerance;
+        int samplesPerCycle;
+        int shortCycles;
+        uint64_t longWindowMs;
+    };
+    
+    void RefreshLimits();
+    void UpdateVoltage(float rms, uint64_t timestamp);
+    void UpdateFrequency(float frequency, uint64_t timestamp);
+    void AddShortWindow(const PQAggregate& window, bool fromWaveform);
+    void CloseLongWindow(uint64_t timestamp);
+    void FinishEvent(PQEvent& event, bool& active, uint64_t timestamp);
+    void Publish();
+    
+public:
+    // 12 периодов по 128 отсчётов
+    static constexpr size_t MAX_BLOCK_SAMPLES = 12 * 128;
+    
+    PowerQualityMonitor() = default;
+    
+    PowerQualityMonitor(const PowerQualityMonitor&) = delete;
+    PowerQualityMonitor& operator=(const PowerQualityMonitor&) = delete;
+    
+    // Из одного управляющего потока
+    void Configure(const PQSettings& settings);
+    // Задаётся до подключения к PowerMonitor
+    void SetAlertEngine(AlertEngine* engine) { alertEngine = engine; }
+    
+    // Размер блока формы (10/12 периодов) и частота дискретизации;
+    // false - форма не нужна
+    bool GetBlockFormat(size_t& samples, double& sampleRateHz);
+    
+    // Только из потока опроса: блок формы, начинающийся в timestamp (мс),
+    // или одно показание датчика, когда формы нет
+    void ProcessBlock(const float* voltage, const float* current, size_t count, double sampleRateHz,
+                      uint64_t timestamp);
+    void Process(const PowerData& data);
+    
+    PQSnapshot GetSnapshot() const { return snapshot.Load(); }
+    
+    static const char* EventTypeName(PQEventType type);
+    
+private:
+    SeqLock<PQSettings> settings;
+    uint64_t settingsVersion {0};
+    Limits limits {};
+    
+    AlertEngine* alertEngine {nullptr};
+    
+    // Состояние потока опроса
+    bool voltageActive {false};
+    PQEvent voltageEvent {};
+    bool frequencyActive {false};
+    PQEvent frequencyEvent {};
+    
+    PQEvent events[PQSnapshot::MAX_EVENTS] {};
+    int eventCount {0};
+    int nextEvent {0};
+    uint64_t totalEvents {0};
+    
+    PQAggregate shortWindow {};
+    PQAggregate longWindow {};
+    bool lastFromWaveform {false};
+    uint64_t longStartMs {0};
+    double longVoltageSquares {0.0};
+    double longFrequency {0.0};
+    uint32_t longFrequencyCount {0};
+    double longVoltageThdSquares {0.0};
+    double longCurrentThdSquares {0.0};
+    uint32_t longThdCount {0};
+    uint32_t longCount {0};
+    
+    float voltageHarmonics[PQSnapshot::MAX_HARMONIC] {};
+    float currentHarmonics[PQSnapshot::MAX_HARMONIC] {};
+    
+    SeqLock<PQSnapshot> snapshot;
+};
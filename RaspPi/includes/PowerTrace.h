@@ -0,0 +1,88 @@
+#pragma once
+
+#include "PowerMonitor.h"
+
+#include <cstdio>
+#include <cstdint>
+#include <string>
+
+enum class TraceFormat
+{
+    CSV = 0,
+    BINARY = 1
+};
+
+// Запись трассы датчика: метка времени и то, что датчик измеряет сам.
+// Полная и реактивная мощность при чтении вычисляются заново.
+//
+// CSV: строка заголовка, затем "timestamp_ms,voltage,current,power,power_factor,frequency".
+// BINARY (little-endian, как на Raspberry Pi): "SPTR", версия (uint32), затем записи
+// по 28 байт: 0 timestamp_ms (int64), 8 voltage, 12 current, 16 power, 20 power_factor,
+// 24 frequency (float).
+namespace PowerTrace
+{
+    static constexpr size_t RECORD_SIZE = 28;
+    static constexpr size_t HEADER_SIZE = 8;
+    
+    // ".csv" - текстовый формат, всё остальное - двоичный
+    TraceFormat FormatFromPath(const std::string& path);
+}
+
+class PowerTraceReader
+{
+private:
+    bool ReadCSV(PowerData& data);
+    bool ReadBinary(PowerData& data);
+    
+public:
+    PowerTraceReader() = default;
+    ~PowerTraceReader();
+    
+    PowerTraceReader(const PowerTraceReader&) = delete;
+    PowerTraceReader& operator=(const PowerTraceReader&) = delete;
+    
+    // Формат определяется по содержимому, а не по расширению
+    bool Open(const std::string& path);
+    void Close();
+    bool IsOpen() const { return file != nullptr; }
+    
+    // false в конце файла; повреждённые строки CSV пропускаются
+    bool Next(PowerData& data);
+    bool Rewind();
+    
+    TraceFormat GetFormat() const { return format; }
+    uint64_t GetRecordCount() const { return records; }
+    uint64_t GetSkippedCount() const { return skipped; }
+    
+private:
+    FILE* file {nullptr};
+    TraceFormat format {TraceFormat::BINARY};
+    long dataOffset {0};
+    uint64_t records {0};
+    uint64_t skipped {0};
+};
+
+// Пишет отсчёты в буфер stdio; вызывается из одного потока опроса
+class PowerTraceRecorder
+{
+public:
+    PowerTraceRecorder() = default;
+    ~PowerTraceRecorder();
+    
+    PowerTraceRecorder(const PowerTraceRecorder&) = delete;
+    PowerTraceRecorder& operator=(const PowerTraceRecorder&) = delete;
+    
+    bool Open(const std::string& path, TraceFormat traceFormat);
+    void Close();
+    bool IsOpen() const { return file != nullptr; }
+    
+    bool Write(const PowerData& data);
+    void Flush();
+    
+    uint64_t GetRecordCount() const { return records; }
+    
+private:
+    FILE* file {nullptr};
+    TraceFormat format {TraceFormat::BINARY};
+    uint64_t records {0};
+};
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+
+// Поля бинарных записей (чекпоинт, трасса) по смещению, без требований к выравниванию.
+// Порядок байт - родной, little-endian на Raspberry Pi и x86.
+template <typename T>
+inline void PutRaw(unsigned char* buffer, size_t offset, T value)
+{
+    std::memcpy(buffer + offset, &value, sizeof(value));
+}
+
+template <typename T>
+inline T GetRaw(const unsigned char* buffer, size_t offset)
+{
+    T value;
+    std::memcpy(&value, buffer + offset, sizeof(value));
+    return value;
+}
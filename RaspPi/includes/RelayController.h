@@ -4,6 +4,8 @@
 
 #include <string>
 #include <mutex>
+#include <atomic>
+#include <functional>
 
 enum class RelayState
 {
@@ -21,13 +23,20 @@ private:
 public:
     RelayController() {};
     
-    bool Initialize(int pin, bool simulation = false, bool activeLow = false);
+    // initialState выставляется первой же записью в GPIO, без промежуточного OFF
+    bool Initialize(int pin, bool simulation = false, bool activeLow = false,
+                    RelayState initialState = RelayState::OFF);
     void Shutdown();
     
     bool TurnOn();
     bool TurnOff();
     bool Toggle();
     
+    // Аварийное отключение из потока опроса: без мьютекса, логов и выделения памяти.
+    // Лог, метрики и обратный вызов выполняет позже CompleteEmergencyOff.
+    bool EmergencyOff() noexcept;
+    void CompleteEmergencyOff();
+    
     RelayState GetState() const;
     std::string GetStateString();
     
@@ -35,11 +44,14 @@ public:
     bool IsOff() const;
     
     void SetActiveLow(bool activeLowMode);
+    void SetStateChangeCallback(std::function<void(RelayState)> callback);
 
 private:
     GPIOController m_Gpio;
     int m_RelayPin {-1};
-    RelayState m_CurrentState {RelayState::UNKNOWN};
+    std::atomic<RelayState> m_CurrentState {RelayState::UNKNOWN};
+    std::atomic<bool> m_EmergencyPending {false};
     std::mutex m_StateMutex;
-    bool m_ActiveLow {false};
+    std::atomic<bool> m_ActiveLow {false};
+    std::function<void(RelayState)> m_StateChangeCallback;
 };
\ No newline at end of file
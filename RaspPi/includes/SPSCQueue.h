@@ -0,0 +1,59 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+// Кольцевой буфер на одного писателя и одного читателя без блокировок.
+// Capacity должна быть степенью двойки.
+template <typename T, size_t Capacity>
+class SPSCQueue
+{
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+    
+public:
+    bool push(const T& item)
+    {
+        size_t tail = tailIndex.load(std::memory_order_relaxed);
+        if (tail - cachedHead == Capacity)
+        {
+            cachedHead = headIndex.load(std::memory_order_acquire);
+            if (tail - cachedHead == Capacity)
+                return false;
+        }
+        
+        buffer[tail & (Capacity - 1)] = item;
+        tailIndex.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+    
+    bool pop(T& item)
+    {
+        size_t head = headIndex.load(std::memory_order_relaxed);
+        if (head == cachedTail)
+        {
+            cachedTail = tailIndex.load(std::memory_order_acquire);
+            if (head == cachedTail)
+                return false;
+        }
+        
+        item = buffer[head & (Capacity - 1)];
+        headIndex.store(head + 1, std::memory_order_release);
+        return true;
+    }
+    
+    size_t size() const
+    {
+        return tailIndex.load(std::memory_order_acquire) - headIndex.load(std::memory_order_acquire);
+    }
+    
+    bool empty() const { return size() == 0; }
+    static constexpr size_t capacity() { return Capacity; }
+
+private:
+    alignas(64) std::atomic<size_t> headIndex {0};
+    size_t cachedTail {0};
+    alignas(64) std::atomic<size_t> tailIndex {0};
+    size_t cachedHead {0};
+    alignas(64) std::array<T, Capacity> buffer {};
+};
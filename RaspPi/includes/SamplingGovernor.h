@@ -0,0 +1,102 @@
+#pragma once
+
+#include "PowerMonitor.h"
+#include "ThermalMonitor.h"
+
+#include <atomic>
+#include <cstdint>
+
+struct GovernorSettings
+{
+    bool enabled {true};
+    int minRateHz {2};                // при перегреве
+    int boostRateHz {50};             // у порога или при резком изменении нагрузки
+    float warmTemperature {65.0f};    // °C: частота вдвое ниже, фоновая работа откладывается
+    float hotTemperature {75.0f};     // °C: минимальная частота
+    float highLoad {0.85f};           // занятость CPU, 0..1
+    float nearThreshold {0.9f};       // доля порога, с которой частота повышается
+    float transientWatts {200.0f};    // скачок мощности между отсчётами
+    int boostHoldMs {5000};
+};
+
+enum class GovernorMode
+{
+    NORMAL = 0,
+    BOOST,        // у порога: не ниже базовой частоты даже в перегреве
+    REDUCED,
+    MINIMUM
+};
+
+// Регулятор частоты опроса. Температура, троттлинг и загрузка CPU приходят из
+// потока ThermalMonitor; близость к порогам и скачки мощности проверяются в
+// потоке опроса на каждом отсчёте, без блокировок. Защита от перегрузки
+// поэтому не теряет разрешение именно тогда, когда оно нужно.
+class SamplingGovernor
+{
+private:
+    enum ThermalLevel
+    {
+        COOL = 0,
+        WARM,
+        HOT
+    };
+    
+    float ReadCpuLoad();
+    
+public:
+    static constexpr int MODE_COUNT = 4;
+    static const char* ModeName(GovernorMode mode);
+    
+    SamplingGovernor();
+    ~SamplingGovernor();
+    
+    SamplingGovernor(const SamplingGovernor&) = delete;
+    SamplingGovernor& operator=(const SamplingGovernor&) = delete;
+    
+    void Configure(const GovernorSettings& settings);
+    void SetBaseRate(int hz);
+    // Пороги, у которых частота повышается; 0 - не следить
+    void SetWatchLimits(float powerWatts, float currentAmps);
+    
+    // Из потока ThermalMonitor
+    void UpdateConditions(const ThermalSnapshot& thermal);
+    
+    // Из потока опроса: интервал до следующего отсчёта, мкс
+    int64_t OnSample(const PowerData& data, int64_t monotonicNs);
+    
+    // true, если свёртки и выгрузки стоит отложить; каждый отказ учитывается в метриках
+    bool ShouldDeferBackgroundWork();
+    
+    GovernorMode GetMode() const { return mode.load(std::memory_order_relaxed); }
+    int GetRate() const { return currentRate.load(std::memory_order_relaxed); }
+    float GetCpuLoad() const { return cpuLoad.load(std::memory_order_relaxed); }
+    
+private:
+    std::atomic<bool> enabled {true};
+    std::atomic<int> baseRate {10};
+    std::atomic<int> minRate {2};
+    std::atomic<int> boostRate {50};
+    std::atomic<float> warmTemperature {65.0f};
+    std::atomic<float> hotTemperature {75.0f};
+    std::atomic<float> highLoad {0.85f};
+    std::atomic<float> nearThreshold {0.9f};
+    std::atomic<float> transientWatts {200.0f};
+    std::atomic<int> boostHoldMs {5000};
+    std::atomic<float> watchPower {0.0f};
+    std::atomic<float> watchCurrent {0.0f};
+    
+    // Поток ThermalMonitor
+    std::atomic<int> thermalLevel {COOL};
+    std::atomic<float> cpuLoad {0.0f};
+    int statFd {-1};
+    uint64_t lastBusy {0};
+    uint64_t lastTotal {0};
+    
+    // Поток опроса
+    bool hasPrevious {false};
+    float previousPower {0.0f};
+    int64_t boostUntilNs {-1};
+    
+    std::atomic<GovernorMode> mode {GovernorMode::NORMAL};
+    std::atomic<int> currentRate {10};
+};
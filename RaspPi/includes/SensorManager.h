@@ -1,11 +1,21 @@
 #pragma once
 
 #include "PowerMonitor.h"
+#include "PowerTrace.h"
+#include "AlertEngine.h"
+#include "OverloadProtection.h"
+#include "ThermalMonitor.h"
+#include "SamplingGovernor.h"
+#include "ApplianceDetector.h"
+#include "AnomalyDetector.h"
+#include "PowerQualityMonitor.h"
 
 #include <functional>
 #include <vector>
 #include <map>
 #include <string>
+#include <atomic>
+#include <mutex>
 
 struct SensorConfig
 {
@@ -15,13 +25,22 @@ struct SensorConfig
     float calibration;
     std::string name;
     bool enabled;
+    
+    std::string replayFile;         // для SENSOR_REPLAY
+    double replaySpeed {1.0};
+    std::string recordFile;         // запись отсчётов; формат по расширению
+    uint32_t simulationSeed {5489u};
+    std::string loadProfile;        // приборы для режима симуляции
+    std::string applianceSignatures;    // сигнатуры для распознавания приборов
+    int thermalIntervalMs {2000};
 };
 
 class SensorManager
 {
 private:    
-    void updateCpuTemperature();
-    void checkThresholds(const PowerData& data);
+    void publishAlertRules();
+    void updateGovernorLimits();
+    void onAlert(const AlertEvent& event);
     
 public:
     SensorManager() {};
@@ -31,17 +50,52 @@ public:
     
     void setPowerThresholds(float warning, float critical);
     void setTemperatureThreshold(float warning);
+    // Гистерезис (Вт), выдержка и пауза между повторами для порогов мощности
+    void setThresholdTuning(float hysteresis, int minDurationMs, int cooldownMs);
+    // Дополнительные правила, например из секции alert.* конфигурации
+    void setAlertRules(std::vector<AlertRule> rules);
+    void subscribeAlerts(AlertListener listener);
+    // Защита отключает relay прямо из потока опроса
+    void setProtectionRelay(RelayController* relay);
+    void setProtectionSettings(const ProtectionSettings& settings);
+    ProtectionStatus getProtectionStatus() const;
     
     PowerData getPowerData();
-    float getCpuTemperature();
+    float getCpuTemperature() const;
+    ThermalSnapshot getThermalSnapshot() const;
+    void setThermalInterval(int intervalMs);
+    
+    void setGovernorSettings(const GovernorSettings& settings);
+    // Свёртки и выгрузки откладываются при перегреве или высокой загрузке CPU
+    bool shouldDeferBackgroundWork();
+    GovernorMode getSamplingMode() const;
+    int getCurrentSampleRate() const;
+    
+    void setApplianceDetection(const NILMSettings& settings);
+    ApplianceSnapshot getAppliances() const;
+    
+    void setAnomalyDetection(const AnomalySettings& settings);
+    // Норма мощности по часам недели из свёрток Statistics
+    void setSeasonalBaseline(const float (&watts)[AnomalyDetector::WEEK_HOURS]);
+    AnomalySnapshot getAnomalies() const;
+    
+    void setPowerQualitySettings(const PQSettings& settings);
+    PQSnapshot getPowerQuality() const;
     
     std::map<std::string, float> getStatistics(int periodSeconds = 300);
     
     void resetEnergyCounter();
+    void restoreEnergyCounter(int64_t nanoWh);
+    int64_t getEnergyNanoWh() const;
+    void setEnergySink(EnergyQueue* queue);
+    void setSampleRate(int hz);
     void calibrate(float referenceValue);
+    const SensorConfig& getConfig() const { return currentConfig; }
     
     void setPowerThresholdCallback(std::function<void(float, float)> callback);
     void setTemperatureCallback(std::function<void(float)> callback);
+    // Вызывается из потока рассылки оповещений после того, как реле уже отключено
+    void setTripCallback(std::function<void(float, float)> callback);
     
     bool isPowerSensorActive() const;
     std::string getSensorStatus() const;
@@ -50,14 +104,31 @@ public:
 
 private:
     PowerMonitor powerMonitor;
+    PowerTraceRecorder recorder;
     SensorConfig currentConfig;
     
-    float cpuTemperature {0.0f};
+    ThermalMonitor thermalMonitor;
+    SamplingGovernor governor;
+    ApplianceDetector applianceDetector;
+    AnomalyDetector anomalyDetector;
+    PowerQualityMonitor powerQuality;
+    
+    // Пороги меняются на лету при перечитывании конфигурации
+    std::atomic<float> powerWarningThreshold {2000.0f};
+    std::atomic<float> powerCriticalThreshold {3000.0f};
+    std::atomic<float> temperatureWarningThreshold {70.0f};
     
-    float powerWarningThreshold {2000.0f};
-    float powerCriticalThreshold {3000.0f};
-    float temperatureWarningThreshold {70.0f};
+    AlertEngine alertEngine;
+    OverloadProtection protection;
+    ProtectionSettings protectionSettings;
+    std::mutex rulesMutex;
+    std::vector<AlertRule> customRules;
+    float thresholdHysteresis {50.0f};
+    int thresholdMinDurationMs {1000};
+    int thresholdCooldownMs {60000};
     
+    std::mutex callbackMutex;
     std::function<void(float, float)> powerThresholdCallback;
     std::function<void(float)> temperatureCallback;
+    std::function<void(float, float)> tripCallback;
 };
\ No newline at end of file
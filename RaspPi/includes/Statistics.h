@@ -5,6 +5,12 @@
 #include <string>
 #include <chrono>
 #include <mutex>
+#include <functional>
+#include <memory>
+
+#include "TariffTable.h"
+#include "EnergyAccumulator.h"
+#include "EnergyForecaster.h"
 
 struct EnergyRecord
 {
@@ -13,6 +19,14 @@ struct EnergyRecord
     float cost;
 };
 
+struct HistoryBucket
+{
+    uint64_t timestamp;
+    float energy;
+    float cost;
+    uint32_t samples;
+};
+
 struct DailyStats
 {
     std::string date;
@@ -23,30 +37,76 @@ struct DailyStats
     int usage_hours;
 };
 
+class StatisticsExport
+{
+private:
+    void fillPending(size_t want);
+    void appendCSVRow(const DailyStats& stats);
+    void appendBinary();
+    
+public:
+    enum Format {
+        FORMAT_CSV = 0,
+        FORMAT_BINARY
+    };
+    
+    StatisticsExport(std::vector<DailyStats> rows, Format format);
+    
+    size_t read(char* buffer, size_t size);
+    bool finished() const { return nextRow >= rows.size() && pendingOffset >= pending.size(); }
+    
+    Format getFormat() const { return format; }
+    size_t getRowCount() const { return rows.size(); }
+
+private:
+    std::vector<DailyStats> rows;
+    Format format;
+    size_t nextRow {0};
+    std::string pending;
+    size_t pendingOffset {0};
+};
+
 class Statistics
 {
 private:    
     void updateDailyStats(const EnergyRecord& record);
-    float calculateCost(float energy, int hour);
+    float calculateCost(float energy, uint64_t timestamp);
+    void recalculateCostsLocked();
     
 public:
     Statistics();
     
     void setTariffs(float peak, float offpeak);
     void setPeakHours(int start, int end);
+    void setTariffTable(const TariffTable& table);
+    void recalculateCosts();
+    void setForecastSmoothing(float alpha, float gamma);
     
     void addEnergyReading(float energy);
+    void addEnergyReading(float energy, uint64_t timestamp);
     void addPowerReading(float power, int durationSeconds);
     
     std::map<std::string, float> getTodayStats();
     std::map<std::string, float> getYesterdayStats();
     std::map<std::string, float> getWeekStats();
     std::map<std::string, float> getMonthStats();
+    EnergyForecast getForecast();
+    
+    EnergyQueue& getEnergyQueue() { return energyQueue; }
+    size_t drainEnergyQueue(bool flush = false);
+    double getTotalEnergyKWh();
+    void restoreTotalEnergy(int64_t nanoWh);
     
     EnergyRecord getLatestRecord();
     std::vector<EnergyRecord> getHistory(int hours = 24);
+    size_t forEachHistoryBucket(uint64_t from, uint64_t to, uint64_t step,
+                                const std::function<void(const HistoryBucket&)>& visitor);
     
+    std::vector<DailyStats> snapshotDailyStats(int days = 30);
+    std::unique_ptr<StatisticsExport> createExport(int days, StatisticsExport::Format format);
+    bool exportToFile(const std::string& filename, int days, StatisticsExport::Format format);
     bool exportToCSV(const std::string& filename, int days = 30);
+    bool exportToBinary(const std::string& filename, int days = 30);
     std::string getJSONReport(int days = 7);
     
     void clearHistory();
@@ -64,4 +124,11 @@ private:
     float tariffPeak {5.0f};
     float tariffOffpeak {2.0f};
     std::pair<int, int> peakHours;
+    TariffTable tariffTable;
+    EnergyForecaster forecaster;
+    
+    EnergyQueue energyQueue;
+    int64_t totalEnergyNanoWh {0};
+    int64_t pendingEnergyNanoWh {0};
+    uint64_t pendingMinute {0};
 };
\ No newline at end of file
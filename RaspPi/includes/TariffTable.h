@@ -0,0 +1,72 @@
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct TariffBand
+{
+    uint8_t daysMask;       // бит 0 - понедельник ... бит 6 - воскресенье
+    uint8_t seasonsMask;    // бит на каждый сезон
+    int startHour;
+    int endHour;            // не включительно, может переходить через полночь
+    float price;
+};
+
+struct LocalHour
+{
+    uint64_t hourStart;
+    int slot;               // season * HOURS_PER_WEEK + hour of week
+    int hour;
+    int weekday;            // 0 - понедельник
+    bool holiday;
+    char date[11];
+};
+
+class TariffTable
+{
+private:
+    void resolveSlow(uint64_t timestamp) const;
+    static bool parseDays(const std::string& spec, uint8_t& mask);
+    
+public:
+    static constexpr int HOURS_PER_WEEK = 168;
+    static constexpr int MAX_SEASONS = 4;
+    
+    TariffTable();
+    
+    void clear(float defaultPrice);
+    void setSeasons(const std::array<uint8_t, 12>& monthToSeason);
+    void addBand(const TariffBand& band);
+    void addHoliday(int month, int day);
+    void compile();
+    
+    static bool parseBand(const std::string& spec, TariffBand& band);
+    bool parseBands(const std::string& specs);
+    bool parseSeasons(const std::string& spec);
+    bool parseHolidays(const std::string& spec);
+    
+    static TariffTable TwoRate(float peak, float offpeak, int peakStart, int peakEnd);
+    
+    const LocalHour& resolve(uint64_t timestamp) const;
+    float priceAt(uint64_t timestamp) const { return prices[resolve(timestamp).slot]; }
+    float priceOfSlot(int slot) const { return prices[slot]; }
+    bool isPeakSlot(int slot) const { return peak[slot] != 0; }
+    
+    size_t getBandCount() const { return bands.size(); }
+    float getMinPrice() const;
+    float getMaxPrice() const;
+
+private:
+    float defaultPrice {0.0f};
+    std::vector<TariffBand> bands;
+    std::array<uint8_t, 12> seasonOfMonth {};
+    std::bitset<12 * 32> holidays;
+    
+    std::array<float, MAX_SEASONS * HOURS_PER_WEEK> prices {};
+    std::array<uint8_t, MAX_SEASONS * HOURS_PER_WEEK> peak {};
+    
+    mutable LocalHour cached {UINT64_MAX, 0, 0, 0, false, {}};
+};
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "SeqLock.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Биты get_throttled прошивки Raspberry Pi (то же, что vcgencmd get_throttled)
+namespace Throttle
+{
+    static constexpr uint32_t UNDER_VOLTAGE = 0x1;
+    static constexpr uint32_t FREQUENCY_CAPPED = 0x2;
+    static constexpr uint32_t THROTTLED = 0x4;
+    static constexpr uint32_t SOFT_TEMP_LIMIT = 0x8;
+    // Те же события с момента загрузки
+    static constexpr uint32_t UNDER_VOLTAGE_OCCURRED = 0x10000;
+    static constexpr uint32_t FREQUENCY_CAPPED_OCCURRED = 0x20000;
+    static constexpr uint32_t THROTTLED_OCCURRED = 0x40000;
+    static constexpr uint32_t SOFT_TEMP_LIMIT_OCCURRED = 0x80000;
+}
+
+struct ThermalZone
+{
+    char type[24];
+    float celsius;
+    bool valid;
+};
+
+struct ThermalSnapshot
+{
+    static constexpr int MAX_ZONES = 8;
+    
+    ThermalZone zones[MAX_ZONES];
+    int zoneCount;
+    float cpuTemperature;             // зона процессора или первая зона
+    bool throttleAvailable;
+    uint32_t throttled;               // биты Throttle
+    uint32_t cpuFrequencyKHz;         // 0 - неизвестно
+    uint64_t timestamp;               // мс
+};
+
+// Периодический опрос температуры. Файлы sysfs открываются один раз и читаются
+// через pread; результат публикуется через SeqLock, так что чтение из HTTP
+// обработчиков не касается файловой системы и не блокируется.
+class ThermalMonitor
+{
+private:
+    void OpenSources();
+    void CloseSources();
+    void SamplerLoop();
+    
+public:
+    ThermalMonitor() = default;
+    ~ThermalMonitor();
+    
+    ThermalMonitor(const ThermalMonitor&) = delete;
+    ThermalMonitor& operator=(const ThermalMonitor&) = delete;
+    
+    // sysfsRoot подменяется на стенде каталогом с такой же структурой
+    bool Start(int intervalMs, const std::string& sysfsRoot = "/sys");
+    void Stop();
+    void SetInterval(int intervalMs);
+    
+    // Вызывается из потока опроса после каждой публикации; задаётся до Start
+    void SetListener(std::function<void(const ThermalSnapshot&)> callback) { listener = std::move(callback); }
+    
+    // Одно чтение всех источников и публикация снимка
+    void Sample();
+    
+    ThermalSnapshot GetSnapshot() const { return snapshot.Load(); }
+    float GetCpuTemperature() const { return snapshot.Load().cpuTemperature; }
+    bool IsRunning() const { return running.load(std::memory_order_acquire); }
+    
+private:
+    std::string root {"/sys"};
+    int zoneFds[ThermalSnapshot::MAX_ZONES] {};
+    ThermalZone zoneInfo[ThermalSnapshot::MAX_ZONES] {};
+    int zoneCount {0};
+    int cpuZone {0};
+    int throttleFd {-1};
+    int frequencyFd {-1};
+    
+    SeqLock<ThermalSnapshot> snapshot;
+    std::function<void(const ThermalSnapshot&)> listener;
+    
+    std::thread sampler;
+    std::atomic<bool> running {false};
+    std::atomic<int> interval {2000};
+    std::mutex wakeMutex;
+    std::condition_variable wakeCondition;
+};
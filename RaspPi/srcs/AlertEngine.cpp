@@ -0,0 +1,333 @@
+#include "../includes/AlertEngine.h"
+#include "../includes/ConfigManager.h"
+#include "../includes/Logger.h"
+#include "../includes/Metrics.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <map>
+
+namespace
+{
+    const char* METRIC_NAMES[] = {"power", "current", "voltage", "power_factor", "frequency", "temperature"};
+    
+    float MetricValue(AlertMetric metric, const PowerData& data, float temperature)
+    {
+        switch (metric)
+        {
+            case AlertMetric::POWER: return data.power;
+            case AlertMetric::CURRENT: return data.current;
+            case AlertMetric::VOLTAGE: return data.voltage;
+            case AlertMetric::POWER_FACTOR: return data.power_factor;
+            case AlertMetric::FREQUENCY: return data.frequency;
+            case AlertMetric::TEMPERATURE: return temperature;
+        }
+        return 0.0f;
+    }
+    
+    Counter& RaisedCounter()
+    {
+        static Counter& counter = MetricsRegistry::GetInstance().GetCounter(
+            "smart_plug_alerts_raised_total", "Alert rules that fired");
+        return counter;
+    }
+    
+    Counter& DroppedCounter()
+    {
+        static Counter& counter = MetricsRegistry::GetInstance().GetCounter(
+            "smart_plug_alert_queue_drops_total", "Alert events dropped because the dispatch queue was full");
+        return counter;
+    }
+}
+
+AlertEngine::~AlertEngine()
+{
+    Stop();
+}
+
+void AlertEngine::Start()
+{
+    if (running.exchange(true))
+        return;
+    
+    dispatcher = std::thread(&AlertEngine::DispatcherLoop, this);
+}
+
+void AlertEngine::Stop()
+{
+    if (!running.exchange(false))
+        return;
+    
+    wakeCondition.notify_one();
+    if (dispatcher.joinable())
+        dispatcher.join();
+}
+
+void AlertEngine::SetRules(std::vector<AlertRule> rules)
+{
+    auto ruleSet = std::make_unique<RuleSet>();
+    ruleSet->states.resize(rules.size());
+    ruleSet->rules = std::move(rules);
+    
+    std::lock_guard<std::mutex> lock(pendingMutex);
+    pending = std::move(ruleSet);
+    hasPending.store(true, std::memory_order_release);
+}
+
+void AlertEngine::Subscribe(AlertListener listener)
+{
+    std::lock_guard<std::mutex> lock(listenersMutex);
+    listeners.push_back(std::move(listener));
+}
+
+void AlertEngine::AdoptPendingRules()
+{
+    std::unique_ptr<RuleSet> next;
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        next = std::move(pending);
+        hasPending.store(false, std::memory_order_relaxed);
+    }
+    if (!next)
+        return;
+    
+    for (size_t i = 0; i < next->rules.size(); ++i)
+        for (size_t j = 0; j < active.rules.size(); ++j)
+            if (active.rules[j].name == next->rules[i].name)
+            {
+                next->states[i] = active.states[j];
+                break;
+            }
+    
+    // Старый набор освобождается здесь, но правила меняются редко
+    active = std::move(*next);
+}
+
+void AlertEngine::Evaluate(const PowerData& data, int64_t monotonicNs)
+{
+    if (hasPending.load(std::memory_order_acquire))
+        AdoptPendingRules();
+    
+    float currentTemperature = temperature.load(std::memory_order_relaxed);
+    
+    for (size_t i = 0; i < active.rules.size(); ++i)
+    {
+        const AlertRule& rule = active.rules[i];
+        RuleState& state = active.states[i];
+        float value = MetricValue(rule.metric, data, currentTemperature);
+        
+        bool rising = rule.edge == AlertEdge::RISING;
+        float observed = value;
+        float threshold = rule.threshold;
+        bool measurable = true;
+        if (rule.rateOfChange != 0.0f)
+        {
+            // Для спада порог скорости отрицательный
+            threshold = rising ? std::fabs(rule.rateOfChange) : -std::fabs(rule.rateOfChange);
+            measurable = state.hasPrevious && monotonicNs > state.previousNs;
+            if (measurable)
+                observed = (value - state.previousValue) * 1e9f / static_cast<float>(monotonicNs - state.previousNs);
+            state.hasPrevious = true;
+            state.previousValue = value;
+            state.previousNs = monotonicNs;
+        }
+        if (!measurable)
+            continue;
+        
+        // Внутри полосы гистерезиса активное правило остаётся активным
+        bool condition;
+        if (!state.active)
+            condition = rising ? observed >= threshold : observed <= threshold;
+        else
+            condition = rising ? observed > threshold - rule.hysteresis : observed < threshold + rule.hysteresis;
+        
+        if (!state.active)
+        {
+            if (!condition)
+            {
+                state.pendingSinceNs = -1;
+                continue;
+            }
+            
+            if (state.pendingSinceNs < 0)
+                state.pendingSinceNs = monotonicNs;
+            
+            bool held = monotonicNs - state.pendingSinceNs >= static_cast<int64_t>(rule.minDurationMs) * 1000000;
+            bool cooled = state.lastFiredNs < 0 ||
+                          monotonicNs - state.lastFiredNs >= static_cast<int64_t>(rule.cooldownMs) * 1000000;
+            if (held && cooled)
+            {
+                state.active = true;
+                state.lastFiredNs = monotonicNs;
+                Emit(rule.name, rule.metric, true, observed, threshold, data.timestamp);
+            }
+        }
+        else if (!condition)
+        {
+            state.active = false;
+            state.pendingSinceNs = -1;
+            Emit(rule.name, rule.metric, false, observed, threshold, data.timestamp);
+        }
+    }
+}
+
+void AlertEngine::Raise(const char* name, AlertMetric metric, float value, float threshold, uint64_t timestampMs)
+{
+    AlertEvent event;
+    std::strncpy(event.rule, name, sizeof(event.rule) - 1);
+    event.rule[sizeof(event.rule) - 1] = '\0';
+    event.metric = metric;
+    event.raised = true;
+    event.value = value;
+    event.threshold = threshold;
+    event.timestamp = timestampMs;
+    Push(event);
+}
+
+void AlertEngine::RaiseCritical(const char* name, AlertMetric metric, float value, float threshold, uint64_t timestampMs)
+{
+    CriticalEvent next {};
+    std::strncpy(next.event.rule, name, sizeof(next.event.rule) - 1);
+    next.event.metric = metric;
+    next.event.raised = true;
+    next.event.value = value;
+    next.event.threshold = threshold;
+    next.event.timestamp = timestampMs;
+    next.sequence = ++criticalRaised;
+    critical.Store(next);
+    
+    RaisedCounter().Add();
+    wakeCondition.notify_one();
+}
+
+void AlertEngine::Emit(const std::string& name, AlertMetric metric, bool raised, float value, float threshold, uint64_t timestampMs)
+{
+    AlertEvent event;
+    size_t length = std::min(name.size(), sizeof(event.rule) - 1);
+    std::memcpy(event.rule, name.data(), length);
+    event.rule[length] = '\0';
+    event.metric = metric;
+    event.raised = raised;
+    event.value = value;
+    event.threshold = threshold;
+    event.timestamp = timestampMs;
+    
+    Push(event);
+}
+
+void AlertEngine::Push(const AlertEvent& event)
+{
+    if (event.raised)
+        RaisedCounter().Add();
+    
+    if (!queue.push(event))
+    {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        DroppedCounter().Add();
+        return;
+    }
+    
+    // Без мьютекса: пропущенное пробуждение подберёт таймаут ожидания
+    wakeCondition.notify_one();
+}
+
+void AlertEngine::DispatcherLoop()
+{
+    AlertEvent event;
+    while (true)
+    {
+        bool stopping = !running.load(std::memory_order_acquire);
+        
+        // Критичное событие - раньше очереди
+        CriticalEvent latest = critical.Load();
+        if (latest.sequence != criticalDelivered)
+        {
+            if (latest.sequence - criticalDelivered > 1)
+                LOG_WARNINGF("{} critical alerts coalesced", latest.sequence - criticalDelivered - 1);
+            criticalDelivered = latest.sequence;
+            Deliver(latest.event);
+        }
+        
+        while (queue.pop(event))
+            Deliver(event);
+        
+        if (stopping)
+            break;
+        
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        wakeCondition.wait_for(lock, std::chrono::milliseconds(100));
+    }
+}
+
+void AlertEngine::Deliver(const AlertEvent& event)
+{
+    LOG_INFOF("Alert {} {}: {} (threshold {})", event.rule,
+              event.raised ? "raised" : "cleared", event.value, event.threshold);
+    
+    std::lock_guard<std::mutex> lock(listenersMutex);
+    for (const AlertListener& listener : listeners)
+        listener(event);
+}
+
+std::vector<AlertRule> AlertEngine::ParseRules(const ConfigSnapshot& config)
+{
+    std::map<std::string, AlertRule> rules;
+    
+    for (const auto& [key, value] : config.GetValues())
+    {
+        if (key.compare(0, 6, "alert.") != 0)
+            continue;
+        
+        size_t dot = key.find('.', 6);
+        if (dot == std::string::npos)
+            continue;
+        
+        std::string name = key.substr(6, dot - 6);
+        std::string field = key.substr(dot + 1);
+        AlertRule& rule = rules[name];
+        rule.name = name;
+        
+        if (field == "metric")
+        {
+            auto it = std::find(std::begin(METRIC_NAMES), std::end(METRIC_NAMES), value.text);
+            if (it != std::end(METRIC_NAMES))
+                rule.metric = static_cast<AlertMetric>(it - std::begin(METRIC_NAMES));
+            else
+                LOG_WARNING("Unknown alert metric: " + key + " = " + value.text);
+        }
+        else if (field == "edge")
+            rule.edge = value.text == "falling" ? AlertEdge::FALLING : AlertEdge::RISING;
+        else if (field == "threshold")
+            rule.threshold = value.As(0.0f);
+        else if (field == "hysteresis")
+            rule.hysteresis = value.As(0.0f);
+        else if (field == "min_duration_ms")
+            rule.minDurationMs = value.As(0);
+        else if (field == "rate")
+            rule.rateOfChange = value.As(0.0f);
+        else if (field == "cooldown_ms")
+            rule.cooldownMs = value.As(0);
+        else
+            LOG_WARNING("Unknown alert setting: " + key);
+    }
+    
+    std::vector<AlertRule> result;
+    for (auto& entry : rules)
+        result.push_back(std::move(entry.second));
+    return result;
+}
+
+bool AlertEngine::RulesDiffer(const ConfigSnapshot& previous, const ConfigSnapshot& current)
+{
+    auto alertValues = [](const ConfigSnapshot& config) {
+        std::map<std::string, std::string> values;
+        for (const auto& [key, value] : config.GetValues())
+            if (key.compare(0, 6, "alert.") == 0)
+                values[key] = value.text;
+        return values;
+    };
+    
+    return alertValues(previous) != alertValues(current);
+}
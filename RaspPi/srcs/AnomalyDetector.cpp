@@ -0,0 +1,298 @@
+#include "../includes/AnomalyDetector.h"
+#include "../includes/AlertEngine.h"
+#include "../includes/Metrics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+
+namespace
+{
+    // Вклад одного отсчёта в CUSUM ограничен: одиночный выброс не считается сдвигом
+    constexpr float CUSUM_CLIP = 4.0f;
+    // Выброс закончился, когда отклонение вернулось ниже половины порога
+    constexpr float SPIKE_CLEAR_RATIO = 0.5f;
+    // Час сравнивается с нормой, только если отсчёты покрывают хотя бы половину его
+    constexpr uint64_t MIN_HOUR_COVERAGE_MS = 30 * 60 * 1000;
+    
+    const char* CHANNEL_NAMES[] = {"power", "current", "voltage", "frequency"};
+    const char* KIND_NAMES[] = {"spike", "shift_up", "shift_down", "seasonal"};
+    
+    const char* EVENT_NAMES[AnomalySnapshot::CHANNELS][4] = {
+        {"anomaly_power_spike", "anomaly_power_shift_up", "anomaly_power_shift_down", "anomaly_power_seasonal"},
+        {"anomaly_current_spike", "anomaly_current_shift_up", "anomaly_current_shift_down", "anomaly_current_seasonal"},
+        {"anomaly_voltage_spike", "anomaly_voltage_shift_up", "anomaly_voltage_shift_down", "anomaly_voltage_seasonal"},
+        {"anomaly_frequency_spike", "anomaly_frequency_shift_up", "anomaly_frequency_shift_down",
+         "anomaly_frequency_seasonal"}
+    };
+    
+    const AlertMetric CHANNEL_METRICS[] = {
+        AlertMetric::POWER, AlertMetric::CURRENT, AlertMetric::VOLTAGE, AlertMetric::FREQUENCY
+    };
+    
+    // Нижняя граница СКО: абсолютная и доля от среднего. Без неё ровный
+    // сигнал (реле выключено, стабильная сеть) даёт аномалию на любом шуме.
+    struct SigmaFloor
+    {
+        float absolute;
+        float relative;
+    };
+    
+    const SigmaFloor SIGMA_FLOORS[] = {
+        {1.0f, 0.01f},      // Вт
+        {0.01f, 0.01f},     // А
+        {0.2f, 0.001f},     // В
+        {0.005f, 0.0002f}   // Гц
+    };
+    
+    struct AnomalyMetrics
+    {
+        Counter* anomalies[AnomalySnapshot::CHANNELS][4];
+        Gauge* baseline[AnomalySnapshot::CHANNELS];
+        Gauge* sigma[AnomalySnapshot::CHANNELS];
+    };
+    
+    AnomalyMetrics& Metrics()
+    {
+        static AnomalyMetrics metrics = [] {
+            MetricsRegistry& registry = MetricsRegistry::GetInstance();
+            AnomalyMetrics created;
+            for (int channel = 0; channel < AnomalySnapshot::CHANNELS; ++channel)
+            {
+                std::string label = std::string("channel=\"") + CHANNEL_NAMES[channel] + "\"";
+                for (int kind = 0; kind < 4; ++kind)
+                    created.anomalies[channel][kind] = &registry.GetCounter("smart_plug_anomalies_total",
+                        "Anomalies found by the streaming detector", label + ",kind=\"" + KIND_NAMES[kind] + "\"");
+                created.baseline[channel] = &registry.GetGauge("smart_plug_anomaly_baseline",
+                    "EWMA baseline of the series", label);
+                created.sigma[channel] = &registry.GetGauge("smart_plug_anomaly_sigma",
+                    "EWMA standard deviation of the series", label);
+            }
+            return created;
+        }();
+        return metrics;
+    }
+    
+    bool LocalTime(uint64_t seconds, std::tm& local)
+    {
+        std::time_t time = static_cast<std::time_t>(seconds);
+        return localtime_r(&time, &local) != nullptr;
+    }
+}
+
+void AnomalyDetector::Configure(const AnomalySettings& settings)
+{
+    Metrics();
+    
+    alpha.store(std::clamp(settings.alpha, 0.0001f, 1.0f), std::memory_order_relaxed);
+    warmupSamples.store(std::max(1, settings.warmupSamples), std::memory_order_relaxed);
+    spikeSigmas.store(std::max(1.0f, settings.spikeSigmas), std::memory_order_relaxed);
+    cusumSlack.store(std::max(0.0f, settings.cusumSlack), std::memory_order_relaxed);
+    cusumLimit.store(std::max(1.0f, settings.cusumLimit), std::memory_order_relaxed);
+    seasonalRatio.store(std::max(0.0f, settings.seasonalRatio), std::memory_order_relaxed);
+    seasonalMinWatts.store(std::max(0.0f, settings.seasonalMinWatts), std::memory_order_relaxed);
+    enabled.store(settings.enabled, std::memory_order_release);
+}
+
+void AnomalyDetector::SetSeasonalBaseline(const float (&watts)[WEEK_HOURS])
+{
+    for (int slot = 0; slot < WEEK_HOURS; ++slot)
+        seasonal[slot].store(std::max(0.0f, watts[slot]), std::memory_order_relaxed);
+}
+
+int AnomalyDetector::SeasonalSlot(uint64_t seconds)
+{
+    std::tm local {};
+    if (!LocalTime(seconds, local))
+        return 0;
+    
+    // Неделя с понедельника, как в TariffTable
+    return ((local.tm_wday + 6) % 7) * 24 + local.tm_hour;
+}
+
+const char* AnomalyDetector::ChannelName(AnomalyChannel channel)
+{
+    return CHANNEL_NAMES[static_cast<int>(channel)];
+}
+
+const char* AnomalyDetector::KindName(AnomalyKind kind)
+{
+    return KIND_NAMES[static_cast<int>(kind)];
+}
+
+void AnomalyDetector::Process(const PowerData& data)
+{
+    if (!enabled.load(std::memory_order_acquire))
+        return;
+    
+    // Отсчёты с ошибкой чтения не портят базовые линии
+    if (!(data.voltage > 0 && data.current >= 0))
+        return;
+    
+    Limits limits;
+    limits.alpha = alpha.load(std::memory_order_relaxed);
+    limits.warmupSamples = warmupSamples.load(std::memory_order_relaxed);
+    limits.spikeSigmas = spikeSigmas.load(std::memory_order_relaxed);
+    limits.cusumSlack = cusumSlack.load(std::memory_order_relaxed);
+    limits.cusumLimit = cusumLimit.load(std::memory_order_relaxed);
+    
+    Update(AnomalyChannel::POWER, data.power, data.timestamp, limits);
+    Update(AnomalyChannel::CURRENT, data.current, data.timestamp, limits);
+    Update(AnomalyChannel::VOLTAGE, data.voltage, data.timestamp, limits);
+    // Не все датчики измеряют частоту
+    if (data.frequency > 0)
+        Update(AnomalyChannel::FREQUENCY, data.frequency, data.timestamp, limits);
+    
+    UpdateHour(data.power, data.timestamp);
+    
+    if (data.timestamp - lastPublishMs >= 1000 || data.timestamp < lastPublishMs)
+        Publish(data.timestamp);
+}
+
+void AnomalyDetector::Update(AnomalyChannel id, float value, uint64_t timestamp, const Limits& limits)
+{
+    Channel& channel = channels[static_cast<int>(id)];
+    
+    // Прогрев: вес не меньше 1/n, среднее набирается так же быстро, как обычное
+    if (channel.samples < limits.warmupSamples)
+    {
+        channel.samples++;
+        float weight = std::max(limits.alpha, 1.0f / static_cast<float>(channel.samples));
+        float diff = value - channel.mean;
+        channel.mean += weight * diff;
+        channel.variance = (1.0f - weight) * (channel.variance + weight * diff * diff);
+        return;
+    }
+    
+    const SigmaFloor& floor = SIGMA_FLOORS[static_cast<int>(id)];
+    float sigma = std::max({std::sqrt(channel.variance), floor.absolute, floor.relative * std::fabs(channel.mean)});
+    float z = (value - channel.mean) / sigma;
+    float clipped = std::clamp(z, -CUSUM_CLIP, CUSUM_CLIP);
+    
+    channel.cusumHigh = std::max(0.0f, channel.cusumHigh + clipped - limits.cusumSlack);
+    channel.cusumLow = std::max(0.0f, channel.cusumLow - clipped - limits.cusumSlack);
+    
+    if (channel.cusumHigh > limits.cusumLimit || channel.cusumLow > limits.cusumLimit)
+    {
+        // Устойчивый сдвиг, а не выброс: базовая линия строится заново с нового уровня
+        AnomalyKind kind = channel.cusumHigh > limits.cusumLimit ? AnomalyKind::SHIFT_UP : AnomalyKind::SHIFT_DOWN;
+        Report(id, kind, value, channel.mean, timestamp);
+        channel.samples = 0;
+        channel.cusumHigh = 0.0f;
+        channel.cusumLow = 0.0f;
+        channel.spike = false;
+        Update(id, value, timestamp, limits);
+        return;
+    }
+    
+    float deviation = std::fabs(z);
+    if (deviation > limits.spikeSigmas)
+    {
+        // Выброс фиксируется, когда значение вернулось; если не вернулось, сработает CUSUM
+        if (!channel.spike || deviation > std::fabs(channel.spikePeak - channel.mean) / sigma)
+            channel.spikePeak = value;
+        channel.spike = true;
+        return;
+    }
+    
+    if (channel.spike)
+    {
+        if (deviation >= limits.spikeSigmas * SPIKE_CLEAR_RATIO)
+            return;
+        channel.spike = false;
+        Report(id, AnomalyKind::SPIKE, channel.spikePeak, channel.mean, timestamp);
+    }
+    
+    float diff = value - channel.mean;
+    channel.mean += limits.alpha * diff;
+    channel.variance = (1.0f - limits.alpha) * (channel.variance + limits.alpha * diff * diff);
+}
+
+void AnomalyDetector::UpdateHour(float power, uint64_t timestamp)
+{
+    if (timestamp >= hourFirstMs && timestamp < hourEndMs)
+    {
+        hourSum += power;
+        hourSamples++;
+        hourLastMs = timestamp;
+        return;
+    }
+    
+    // Час закончился; при скачке часов назад он просто начинается заново
+    if (timestamp >= hourEndMs && hourSlot >= 0 && hourSamples > 0 &&
+        hourLastMs - hourFirstMs >= MIN_HOUR_COVERAGE_MS)
+    {
+        float expected = seasonal[hourSlot].load(std::memory_order_relaxed);
+        float mean = static_cast<float>(hourSum / hourSamples);
+        float tolerance = std::max(seasonalMinWatts.load(std::memory_order_relaxed),
+                                   seasonalRatio.load(std::memory_order_relaxed) * expected);
+        if (expected > 0.0f && std::fabs(mean - expected) > tolerance)
+            Report(AnomalyChannel::POWER, AnomalyKind::SEASONAL, mean, expected, timestamp);
+    }
+    
+    // localtime_r раз в час, а не на каждом отсчёте
+    uint64_t seconds = timestamp / 1000;
+    std::tm local {};
+    if (LocalTime(seconds, local))
+    {
+        hourSlot = ((local.tm_wday + 6) % 7) * 24 + local.tm_hour;
+        hourEndMs = (seconds - static_cast<uint64_t>(local.tm_min * 60 + local.tm_sec) + 3600) * 1000;
+    }
+    else
+    {
+        hourSlot = -1;
+        hourEndMs = (seconds / 3600 + 1) * 3600 * 1000;
+    }
+    
+    hourFirstMs = timestamp;
+    hourLastMs = timestamp;
+    hourSum = power;
+    hourSamples = 1;
+}
+
+void AnomalyDetector::Report(AnomalyChannel id, AnomalyKind kind, float value, float expected, uint64_t timestamp)
+{
+    int channel = static_cast<int>(id);
+    int type = static_cast<int>(kind);
+    
+    channels[channel].anomalies++;
+    lastAnomalyAt = timestamp;
+    Metrics().anomalies[channel][type]->Add();
+    
+    if (alertEngine)
+        alertEngine->Raise(EVENT_NAMES[channel][type], CHANNEL_METRICS[channel], value, expected, timestamp);
+    
+    // Снимок сразу, не дожидаясь секундного обновления
+    lastPublishMs = 0;
+}
+
+void AnomalyDetector::Publish(uint64_t timestamp)
+{
+    AnomalyMetrics& metrics = Metrics();
+    AnomalySnapshot current {};
+    
+    for (int i = 0; i < CHANNELS; ++i)
+    {
+        const Channel& channel = channels[i];
+        float sigma = std::sqrt(channel.variance);
+        
+        current.channels[i].mean = channel.mean;
+        current.channels[i].sigma = sigma;
+        current.channels[i].ready = channel.samples > 0 && channel.samples >= warmupSamples.load(std::memory_order_relaxed);
+        current.channels[i].spike = channel.spike;
+        current.channels[i].anomalies = channel.anomalies;
+        
+        if (channel.samples > 0)
+        {
+            metrics.baseline[i]->Set(channel.mean);
+            metrics.sigma[i]->Set(sigma);
+        }
+    }
+    
+    current.hourMean = hourSamples > 0 ? static_cast<float>(hourSum / hourSamples) : 0.0f;
+    current.hourExpected = hourSlot >= 0 ? seasonal[hourSlot].load(std::memory_order_relaxed) : 0.0f;
+    current.lastAnomalyAt = lastAnomalyAt;
+    
+    snapshot.Store(current);
+    lastPublishMs = timestamp;
+}
@@ -0,0 +1,404 @@
+#include "../includes/ApplianceDetector.h"
+#include "../includes/ConfigManager.h"
+#include "../includes/PowerTrace.h"
+#include "../includes/Logger.h"
+#include "../includes/Metrics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+    // Медленный дрейф установившегося режима без скачка
+    constexpr float DRIFT_RATE = 0.1f;
+    // Порог скачка не ниже стольких СКО шума установившегося режима
+    constexpr float NOISE_SIGMAS = 4.0f;
+    // Уточнение уровня после скачка перед классификацией
+    constexpr int REFINE_SAMPLES = 10;
+    constexpr float REFINE_RATE = 0.3f;
+    
+    Counter& EdgeCounter(bool matched)
+    {
+        static MetricsRegistry& registry = MetricsRegistry::GetInstance();
+        static Counter& matchedEdges = registry.GetCounter("smart_plug_nilm_edges_total",
+            "Load steps seen by the appliance detector", "matched=\"true\"");
+        static Counter& unmatchedEdges = registry.GetCounter("smart_plug_nilm_edges_total",
+            "Load steps seen by the appliance detector", "matched=\"false\"");
+        return matched ? matchedEdges : unmatchedEdges;
+    }
+}
+
+ApplianceDetector::Library::Library()
+{
+    power.reserve(ApplianceSnapshot::MAX_APPLIANCES);
+    reactive.reserve(ApplianceSnapshot::MAX_APPLIANCES);
+    hits.reserve(ApplianceSnapshot::MAX_APPLIANCES);
+    trained.reserve(ApplianceSnapshot::MAX_APPLIANCES);
+    names.reserve(ApplianceSnapshot::MAX_APPLIANCES);
+}
+
+void ApplianceDetector::Library::add(const ApplianceSignature& signature)
+{
+    power.push_back(signature.power);
+    reactive.push_back(signature.reactive);
+    hits.push_back(0);
+    trained.push_back(signature.trained ? 1 : 0);
+    names.push_back(signature.name);
+}
+
+void ApplianceDetector::Configure(const NILMSettings& settings)
+{
+    EdgeCounter(true);
+    
+    edgeThreshold.store(std::max(1.0f, settings.edgeThreshold), std::memory_order_relaxed);
+    settleSamples.store(std::max(1, settings.settleSamples), std::memory_order_relaxed);
+    matchTolerance.store(std::max(0.01f, settings.matchTolerance), std::memory_order_relaxed);
+    minMatchWatts.store(std::max(0.0f, settings.minMatchWatts), std::memory_order_relaxed);
+    enabled.store(settings.enabled, std::memory_order_release);
+}
+
+void ApplianceDetector::SetSignatures(const std::vector<ApplianceSignature>& signatures)
+{
+    auto next = std::make_unique<Library>();
+    for (const ApplianceSignature& signature : signatures)
+    {
+        if (next->size() == ApplianceSnapshot::MAX_APPLIANCES)
+        {
+            LOG_WARNINGF("Only the first {} appliance signatures are used", ApplianceSnapshot::MAX_APPLIANCES);
+            break;
+        }
+        next->add(signature);
+    }
+    
+    std::lock_guard<std::mutex> lock(pendingMutex);
+    pending = std::move(next);
+    hasPending.store(true, std::memory_order_release);
+}
+
+std::vector<ApplianceSignature> ApplianceDetector::ParseSignatures(const std::map<std::string, std::string>& values)
+{
+    // Ключи отсортированы, поэтому параметры одной сигнатуры идут подряд
+    std::vector<ApplianceSignature> signatures;
+    for (const auto& [key, text] : values)
+    {
+        if (key.compare(0, 10, "signature.") != 0)
+            continue;
+        
+        size_t dot = key.find('.', 10);
+        if (dot == std::string::npos)
+            continue;
+        
+        std::string name = key.substr(10, dot - 10);
+        if (signatures.empty() || signatures.back().name != name)
+        {
+            signatures.emplace_back();
+            signatures.back().name = name;
+        }
+        
+        std::string field = key.substr(dot + 1);
+        ConfigValue value = ConfigValue::Parse(text);
+        if (field == "power")
+            signatures.back().power = value.floatValue;
+        else if (field == "reactive")
+            signatures.back().reactive = value.floatValue;
+        else
+            LOG_WARNING("Ignoring signature key " + key);
+    }
+    return signatures;
+}
+
+bool ApplianceDetector::LoadSignatures(const std::string& path)
+{
+    std::map<std::string, std::string> values;
+    if (!ConfigManager::ParseConfigFile(path, values))
+    {
+        LOG_ERROR("Failed to read appliance signatures: " + path);
+        return false;
+    }
+    
+    std::vector<ApplianceSignature> signatures = ParseSignatures(values);
+    SetSignatures(signatures);
+    LOG_INFO("Appliance signatures " + path + ": " + std::to_string(signatures.size()));
+    return true;
+}
+
+bool ApplianceDetector::SaveSignatures(const std::string& path, const std::vector<ApplianceSignature>& signatures)
+{
+    std::ofstream file(path);
+    if (!file.is_open())
+    {
+        LOG_ERROR("Failed to write appliance signatures: " + path);
+        return false;
+    }
+    
+    for (const ApplianceSignature& signature : signatures)
+    {
+        file << "signature." << signature.name << ".power = " << signature.power << "\n";
+        file << "signature." << signature.name << ".reactive = " << signature.reactive << "\n";
+    }
+    return file.good();
+}
+
+std::vector<ApplianceSignature> ApplianceDetector::TrainFromTrace(const std::string& path, const NILMSettings& settings,
+                                                                  int minOccurrences)
+{
+    PowerTraceReader reader;
+    if (!reader.Open(path))
+        return {};
+    
+    ApplianceDetector detector;
+    detector.Configure(settings);
+    
+    PowerData data;
+    while (reader.Next(data))
+        detector.Process(data);
+    
+    // Имена auto_N заняты кластерами, найденными на лету
+    std::vector<ApplianceSignature> signatures = detector.GetLearnedSignatures(minOccurrences);
+    for (size_t i = 0; i < signatures.size(); ++i)
+    {
+        signatures[i].name = "appliance_" + std::to_string(i + 1);
+        signatures[i].trained = true;
+    }
+    
+    LOG_INFOF("Trained {} appliance signatures from {} samples ({} steps)", signatures.size(),
+              reader.GetRecordCount(), detector.edges);
+    return signatures;
+}
+
+std::vector<ApplianceSignature> ApplianceDetector::GetLearnedSignatures(int minOccurrences) const
+{
+    std::vector<ApplianceSignature> signatures;
+    for (size_t i = 0; i < library.size(); ++i)
+    {
+        if (!library.trained[i] && library.hits[i] < static_cast<uint32_t>(minOccurrences))
+            continue;
+        
+        ApplianceSignature signature;
+        signature.name = library.names[i];
+        signature.power = library.power[i];
+        signature.reactive = library.reactive[i];
+        signature.trained = library.trained[i] != 0;
+        signatures.push_back(signature);
+    }
+    return signatures;
+}
+
+void ApplianceDetector::AdoptPendingLibrary()
+{
+    std::unique_ptr<Library> next;
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        next = std::move(pending);
+        hasPending.store(false, std::memory_order_relaxed);
+    }
+    if (!next)
+        return;
+    
+    // Состояние приборов с теми же именами сохраняется
+    bool nextOn[ApplianceSnapshot::MAX_APPLIANCES] {};
+    uint32_t nextActivations[ApplianceSnapshot::MAX_APPLIANCES] {};
+    uint64_t nextChanged[ApplianceSnapshot::MAX_APPLIANCES] {};
+    for (size_t i = 0; i < next->size(); ++i)
+        for (size_t j = 0; j < library.size(); ++j)
+            if (library.names[j] == next->names[i])
+            {
+                nextOn[i] = on[j];
+                nextActivations[i] = activations[j];
+                nextChanged[i] = changedAt[j];
+                break;
+            }
+    
+    library = std::move(*next);
+    std::memcpy(on, nextOn, sizeof(on));
+    std::memcpy(activations, nextActivations, sizeof(activations));
+    std::memcpy(changedAt, nextChanged, sizeof(changedAt));
+    eventCount = 0;
+    nextEvent = 0;
+    Publish();
+}
+
+int ApplianceDetector::FindNearest(float deltaPower, float deltaReactive, bool activeOnly) const
+{
+    float tolerance = matchTolerance.load(std::memory_order_relaxed);
+    float minimum = minMatchWatts.load(std::memory_order_relaxed);
+    const float* power = library.power.data();
+    const float* reactive = library.reactive.data();
+    
+    int best = -1;
+    float bestScore = 1.0f;
+    for (size_t i = 0; i < library.size(); ++i)
+    {
+        if (activeOnly && !on[i])
+            continue;
+        
+        float dp = deltaPower - power[i];
+        float dq = deltaReactive - reactive[i];
+        float allowed = std::max(minimum, tolerance * std::sqrt(power[i] * power[i] + reactive[i] * reactive[i]));
+        // Квадрат расстояния относительно допуска: 1 - на границе
+        float score = (dp * dp + dq * dq) / (allowed * allowed);
+        if (score <= bestScore)
+        {
+            bestScore = score;
+            best = static_cast<int>(i);
+        }
+    }
+    return best;
+}
+
+void ApplianceDetector::OnEdge(float deltaPower, float deltaReactive, uint64_t timestamp)
+{
+    ++edges;
+    bool rising = deltaPower > 0;
+    // Сигнатура хранится в направлении включения
+    float power = std::fabs(deltaPower);
+    float reactive = rising ? deltaReactive : -deltaReactive;
+    
+    int index = rising ? FindNearest(power, reactive, false) : FindNearest(power, reactive, true);
+    if (index < 0 && !rising)
+        index = FindNearest(power, reactive, false);
+    
+    if (index < 0 && library.size() < ApplianceSnapshot::MAX_APPLIANCES)
+    {
+        ApplianceSignature cluster;
+        cluster.name = "auto_" + std::to_string(++autoCounter);
+        cluster.power = power;
+        cluster.reactive = reactive;
+        cluster.trained = false;
+        library.add(cluster);
+        index = static_cast<int>(library.size()) - 1;
+        // Новый кластер выключения не знает, был ли прибор включён
+        on[index] = false;
+        activations[index] = 0;
+        changedAt[index] = 0;
+    }
+    else if (index >= 0 && !library.trained[index])
+    {
+        // Центр кластера - среднее всех его скачков
+        float weight = 1.0f / static_cast<float>(library.hits[index] + 2);
+        library.power[index] += (power - library.power[index]) * weight;
+        library.reactive[index] += (reactive - library.reactive[index]) * weight;
+    }
+    
+    if (index >= 0)
+    {
+        ++library.hits[index];
+        if (rising && !on[index])
+            ++activations[index];
+        on[index] = rising;
+        changedAt[index] = timestamp;
+    }
+    else
+        ++unmatched;
+    EdgeCounter(index >= 0).Add();
+    
+    ApplianceEvent& event = events[nextEvent];
+    event.appliance = index;
+    event.on = rising;
+    event.deltaPower = deltaPower;
+    event.deltaReactive = deltaReactive;
+    event.timestamp = timestamp;
+    nextEvent = (nextEvent + 1) % ApplianceSnapshot::MAX_EVENTS;
+    eventCount = std::min(eventCount + 1, ApplianceSnapshot::MAX_EVENTS);
+    
+    Publish();
+}
+
+void ApplianceDetector::Process(const PowerData& data)
+{
+    if (hasPending.load(std::memory_order_acquire))
+        AdoptPendingLibrary();
+    if (!enabled.load(std::memory_order_acquire))
+        return;
+    
+    float power = data.power;
+    float reactive = data.reactive_power;
+    if (!steady)
+    {
+        steadyPower = power;
+        steadyReactive = reactive;
+        steady = true;
+        return;
+    }
+    
+    // Шумный прибор (чайник, обогреватель) поднимает порог, иначе его шум даёт ложные скачки
+    float threshold = std::max(edgeThreshold.load(std::memory_order_relaxed), NOISE_SIGMAS * std::sqrt(noiseVariance));
+    float step = power - steadyPower;
+    if (std::fabs(step) < threshold)
+    {
+        // После скачка уровень уточняется быстрее, пока затухает пусковой ток
+        float rate = refineRemaining > 0 ? REFINE_RATE : DRIFT_RATE;
+        noiseVariance += (step * step - noiseVariance) * rate;
+        steadyPower += step * rate;
+        steadyReactive += (reactive - steadyReactive) * rate;
+        settleCount = 0;
+        
+        if (refineRemaining > 0 && --refineRemaining == 0)
+            OnEdge(steadyPower - edgeFromPower, steadyReactive - edgeFromReactive, edgeTimestamp);
+        return;
+    }
+    
+    // Новый уровень засчитывается, когда держится settleSamples отсчётов;
+    // пусковой ток и другие переходные процессы начинают отсчёт заново
+    float settleTolerance = std::max(threshold * 0.5f, matchTolerance.load(std::memory_order_relaxed) * 0.5f * std::fabs(step));
+    if (settleCount == 0 || std::fabs(power - settlePower) >= settleTolerance)
+    {
+        settleCount = 1;
+        settlePower = power;
+        settleReactive = reactive;
+    }
+    else
+    {
+        ++settleCount;
+        settlePower += (power - settlePower) / static_cast<float>(settleCount);
+        settleReactive += (reactive - settleReactive) / static_cast<float>(settleCount);
+    }
+    
+    if (settleCount >= settleSamples.load(std::memory_order_relaxed))
+    {
+        // Скачок классифицируется после уточнения нового уровня; следующий скачок
+        // раньше срока закрывает предыдущий с тем уровнем, что успели измерить
+        if (refineRemaining > 0)
+            OnEdge(steadyPower - edgeFromPower, steadyReactive - edgeFromReactive, edgeTimestamp);
+        edgeFromPower = steadyPower;
+        edgeFromReactive = steadyReactive;
+        edgeTimestamp = data.timestamp;
+        refineRemaining = REFINE_SAMPLES;
+        
+        steadyPower = settlePower;
+        steadyReactive = settleReactive;
+        noiseVariance = 0.0f;
+        settleCount = 0;
+    }
+}
+
+void ApplianceDetector::Publish()
+{
+    ApplianceSnapshot next {};
+    
+    float explained = 0.0f;
+    next.applianceCount = static_cast<int>(library.size());
+    for (int i = 0; i < next.applianceCount; ++i)
+    {
+        ApplianceState& state = next.appliances[i];
+        std::strncpy(state.name, library.names[i].c_str(), sizeof(state.name) - 1);
+        state.power = library.power[i];
+        state.reactive = library.reactive[i];
+        state.trained = library.trained[i] != 0;
+        state.on = on[i];
+        state.activations = activations[i];
+        state.changedAt = changedAt[i];
+        if (on[i])
+            explained += library.power[i];
+    }
+    
+    std::memcpy(next.events, events, sizeof(events));
+    next.eventCount = eventCount;
+    next.nextEvent = nextEvent;
+    next.baseline = std::max(0.0f, steadyPower - explained);
+    next.edges = edges;
+    next.unmatched = unmatched;
+    snapshot.Store(next);
+}
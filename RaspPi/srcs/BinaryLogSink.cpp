@@ -0,0 +1,234 @@
+#include "../includes/BinaryLogSink.h"
+
+#include <iostream>
+
+static std::mutex g_FormatMutex;
+static std::vector<BinaryLog::FormatSite> g_Formats;
+
+std::atomic<uint32_t> BinaryLogSink::m_ReopenGeneration {0};
+
+uint32_t BinaryLogSink::RegisterFormat(int level, const char* function, int line, const char* format)
+{
+    std::lock_guard<std::mutex> lock(g_FormatMutex);
+    g_Formats.push_back(BinaryLog::FormatSite{level, line, function ? function : "", format ? format : ""});
+    return static_cast<uint32_t>(g_Formats.size() - 1);
+}
+
+BinaryLogSink::~BinaryLogSink()
+{
+    Close();
+}
+
+bool BinaryLogSink::Open(const std::string& filename)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Path = filename;
+    return OpenLocked();
+}
+
+bool BinaryLogSink::OpenLocked()
+{
+    m_Generation = m_ReopenGeneration.load(std::memory_order_relaxed);
+    
+    if (m_File)
+    {
+        FlushLocked();
+        std::fclose(m_File);
+    }
+    
+    m_File = std::fopen(m_Path.c_str(), "ab");
+    if (!m_File)
+    {
+        std::cerr << "Failed to open binary log file: " << m_Path << std::endl;
+        return false;
+    }
+    
+    // Каждое открытие начинает самодостаточный сегмент со своим заголовком
+    m_Buffer.clear();
+    m_Buffer.reserve(FLUSH_THRESHOLD * 2);
+    m_FormatWritten.clear();
+    m_Strings.clear();
+    WriteHeader();
+    FlushLocked();
+    return true;
+}
+
+// Вход приходит из EncodeArgs, поэтому без проверок границ
+static uint64_t ReadVarint(const char* data, size_t& pos)
+{
+    uint64_t value = 0;
+    for (int shift = 0;; shift += 7)
+    {
+        uint8_t byte = static_cast<uint8_t>(data[pos++]);
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+            return value;
+    }
+}
+
+void BinaryLogSink::WriteEncoded(uint32_t formatId, uint64_t monotonicNs, bool flushNow, const char* args, size_t size)
+{
+    if (size == 0)
+        return;
+    
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if (m_Generation != m_ReopenGeneration.load(std::memory_order_relaxed) && !m_Path.empty())
+        OpenLocked();
+    if (!m_File)
+        return;
+    
+    EnsureFormat(formatId);
+    
+    // Строковые аргументы объявляются до записи, чтобы запись была непрерывной
+    size_t recordStart = m_Buffer.size();
+    PutByte(BinaryLog::ENTRY_RECORD);
+    PutVarint(formatId);
+    PutVarint(monotonicNs > m_LastMonotonicNs ? monotonicNs - m_LastMonotonicNs : 0);
+    PutByte(static_cast<uint8_t>(args[0]));
+    m_RecordStart = recordStart;
+    
+    size_t pos = 1;
+    while (pos < size)
+    {
+        size_t argStart = pos;
+        switch (static_cast<uint8_t>(args[pos++]))
+        {
+            case BinaryLog::TAG_STR:
+            {
+                size_t length = ReadVarint(args, pos);
+                PutStringArg(args + pos, length);
+                pos += length;
+                continue;
+            }
+            case BinaryLog::TAG_INT:
+            case BinaryLog::TAG_UINT:
+                ReadVarint(args, pos);
+                break;
+            case BinaryLog::TAG_F32:
+                pos += sizeof(float);
+                break;
+            case BinaryLog::TAG_F64:
+                pos += sizeof(double);
+                break;
+            default:
+                pos += 1;
+                break;
+        }
+        PutRaw(args + argStart, pos - argStart);
+    }
+    
+    m_LastMonotonicNs = std::max(monotonicNs, m_LastMonotonicNs);
+    
+    if (flushNow || m_Buffer.size() >= FLUSH_THRESHOLD || monotonicNs >= m_LastFlushNs + 1000000000ULL)
+    {
+        m_LastFlushNs = monotonicNs;
+        FlushLocked();
+    }
+}
+
+void BinaryLogSink::Close()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if (!m_File)
+        return;
+    
+    FlushLocked();
+    std::fclose(m_File);
+    m_File = nullptr;
+    m_Path.clear();
+}
+
+void BinaryLogSink::Flush()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    FlushLocked();
+}
+
+void BinaryLogSink::FlushLocked()
+{
+    if (!m_File || m_Buffer.empty())
+        return;
+    
+    std::fwrite(m_Buffer.data(), 1, m_Buffer.size(), m_File);
+    std::fflush(m_File);
+    m_BytesWritten += m_Buffer.size();
+    m_Buffer.clear();
+}
+
+void BinaryLogSink::WriteHeader()
+{
+    uint64_t realtime = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    uint64_t monotonic = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    
+    PutRaw(BinaryLog::MAGIC, sizeof(BinaryLog::MAGIC));
+    PutByte(BinaryLog::VERSION);
+    PutRaw(&realtime, sizeof(realtime));
+    PutRaw(&monotonic, sizeof(monotonic));
+    m_LastMonotonicNs = monotonic;
+    m_LastFlushNs = monotonic;
+}
+
+void BinaryLogSink::EnsureFormat(uint32_t formatId)
+{
+    if (formatId < m_FormatWritten.size() && m_FormatWritten[formatId])
+        return;
+    
+    BinaryLog::FormatSite site;
+    {
+        std::lock_guard<std::mutex> lock(g_FormatMutex);
+        if (formatId >= g_Formats.size())
+            return;
+        site = g_Formats[formatId];
+    }
+    
+    if (formatId >= m_FormatWritten.size())
+        m_FormatWritten.resize(formatId + 1, false);
+    m_FormatWritten[formatId] = true;
+    
+    PutByte(BinaryLog::ENTRY_FORMAT);
+    PutVarint(formatId);
+    PutByte(static_cast<uint8_t>(site.level));
+    PutVarint(static_cast<uint64_t>(site.line));
+    PutString(site.function.data(), site.function.size());
+    PutString(site.format.data(), site.format.size());
+}
+
+void BinaryLogSink::PutStringArg(const char* data, size_t size)
+{
+    if (size > MAX_INTERNED_LENGTH)
+    {
+        PutByte(BinaryLog::TAG_STR);
+        PutString(data, size);
+        return;
+    }
+    
+    std::string key(data, size);
+    auto it = m_Strings.find(key);
+    if (it == m_Strings.end())
+    {
+        if (m_Strings.size() >= MAX_INTERNED_STRINGS)
+        {
+            PutByte(BinaryLog::TAG_STR);
+            PutString(data, size);
+            return;
+        }
+        
+        uint32_t id = static_cast<uint32_t>(m_Strings.size());
+        it = m_Strings.emplace(std::move(key), id).first;
+        
+        // Объявление строки вставляется перед текущей записью
+        std::string record = m_Buffer.substr(m_RecordStart);
+        m_Buffer.resize(m_RecordStart);
+        
+        PutByte(BinaryLog::ENTRY_STRING);
+        PutVarint(id);
+        PutString(data, size);
+        m_RecordStart = m_Buffer.size();
+        m_Buffer += record;
+    }
+    
+    PutByte(BinaryLog::TAG_STRREF);
+    PutVarint(it->second);
+}
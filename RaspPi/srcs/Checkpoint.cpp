@@ -0,0 +1,185 @@
+#include "../includes/Checkpoint.h"
+#include "../includes/Logger.h"
+#include "../includes/RawBytes.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <array>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+
+namespace
+{
+    // Раскладка слота (little-endian, как на Raspberry Pi):
+    // 0 magic, 4 version, 8 sequence, 16 savedAtMs, 24 energyNanoWh, 32 relayState, 60 crc32
+    constexpr char CHECKPOINT_MAGIC[4] = {'S', 'P', 'C', 'K'};
+    constexpr uint32_t CHECKPOINT_VERSION = 1;
+    constexpr size_t CRC_OFFSET = Checkpoint::SLOT_SIZE - sizeof(uint32_t);
+    
+    uint32_t Crc32(const unsigned char* data, size_t size)
+    {
+        static const std::array<uint32_t, 256> table = []() {
+            std::array<uint32_t, 256> result {};
+            for (uint32_t i = 0; i < 256; ++i)
+            {
+                uint32_t crc = i;
+                for (int bit = 0; bit < 8; ++bit)
+                    crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+                result[i] = crc;
+            }
+            return result;
+        }();
+        
+        uint32_t crc = 0xFFFFFFFFu;
+        for (size_t i = 0; i < size; ++i)
+            crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        return crc ^ 0xFFFFFFFFu;
+    }
+}
+
+Checkpoint::~Checkpoint()
+{
+    Close();
+}
+
+bool Checkpoint::Open(const std::string& path)
+{
+    std::lock_guard<std::mutex> lock(checkpointMutex);
+    
+    filePath = path;
+    fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        LOG_ERROR("Failed to open checkpoint " + path + ": " + std::string(strerror(errno)));
+        return false;
+    }
+    
+    hasState = false;
+    sequence = 0;
+    for (int index = 0; index < 2; ++index)
+    {
+        CheckpointState state;
+        uint64_t slotSequence;
+        if (ReadSlot(index, state, slotSequence) && (!hasState || slotSequence > sequence))
+        {
+            lastState = state;
+            sequence = slotSequence;
+            hasState = true;
+        }
+    }
+    
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size == 0)
+    {
+        // Новый файл: сразу фиксируем размер и запись в каталоге
+        if (ftruncate(fd, 2 * SLOT_SIZE) < 0 || fsync(fd) < 0)
+            LOG_ERROR("Failed to prepare checkpoint " + path + ": " + std::string(strerror(errno)));
+        
+        size_t slash = path.find_last_of('/');
+        std::string directory = slash == std::string::npos ? "." : path.substr(0, slash + 1);
+        int dirFd = open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (dirFd >= 0)
+        {
+            fsync(dirFd);
+            close(dirFd);
+        }
+    }
+    
+    if (hasState)
+        LOG_INFO("Checkpoint restored from " + path + " (sequence " + std::to_string(sequence) + ")");
+    else
+        LOG_INFO("No valid checkpoint in " + path);
+    return true;
+}
+
+void Checkpoint::Close()
+{
+    std::lock_guard<std::mutex> lock(checkpointMutex);
+    if (fd >= 0)
+    {
+        close(fd);
+        fd = -1;
+    }
+}
+
+bool Checkpoint::GetRestoredState(CheckpointState& state) const
+{
+    std::lock_guard<std::mutex> lock(checkpointMutex);
+    if (hasState)
+        state = lastState;
+    return hasState;
+}
+
+bool Checkpoint::ReadSlot(int index, CheckpointState& state, uint64_t& slotSequence) const
+{
+    unsigned char slot[SLOT_SIZE];
+    if (pread(fd, slot, SLOT_SIZE, index * SLOT_SIZE) != static_cast<ssize_t>(SLOT_SIZE))
+        return false;
+    
+    if (std::memcmp(slot, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != 0 ||
+        GetRaw<uint32_t>(slot, 4) != CHECKPOINT_VERSION ||
+        GetRaw<uint32_t>(slot, CRC_OFFSET) != Crc32(slot, CRC_OFFSET))
+        return false;
+    
+    slotSequence = GetRaw<uint64_t>(slot, 8);
+    state.savedAtMs = GetRaw<uint64_t>(slot, 16);
+    state.energyNanoWh = GetRaw<int64_t>(slot, 24);
+    
+    uint8_t relay = slot[32];
+    state.relayState = relay <= static_cast<uint8_t>(RelayState::UNKNOWN)
+        ? static_cast<RelayState>(relay) : RelayState::UNKNOWN;
+    return true;
+}
+
+bool Checkpoint::WriteSlotLocked(const CheckpointState& state)
+{
+    unsigned char slot[SLOT_SIZE] = {};
+    uint64_t nextSequence = sequence + 1;
+    
+    std::memcpy(slot, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+    PutRaw<uint32_t>(slot, 4, CHECKPOINT_VERSION);
+    PutRaw<uint64_t>(slot, 8, nextSequence);
+    PutRaw<uint64_t>(slot, 16, state.savedAtMs);
+    PutRaw<int64_t>(slot, 24, state.energyNanoWh);
+    slot[32] = static_cast<uint8_t>(state.relayState);
+    PutRaw<uint32_t>(slot, CRC_OFFSET, Crc32(slot, CRC_OFFSET));
+    
+    off_t offset = static_cast<off_t>((nextSequence & 1) * SLOT_SIZE);
+    if (pwrite(fd, slot, SLOT_SIZE, offset) != static_cast<ssize_t>(SLOT_SIZE) || fdatasync(fd) < 0)
+    {
+        LOG_ERROR("Failed to write checkpoint " + filePath + ": " + std::string(strerror(errno)));
+        return false;
+    }
+    
+    sequence = nextSequence;
+    writeCount++;
+    return true;
+}
+
+bool Checkpoint::Save(const CheckpointState& state, int64_t minEnergyDeltaNanoWh)
+{
+    std::lock_guard<std::mutex> lock(checkpointMutex);
+    if (fd < 0)
+        return false;
+    
+    // Пакетирование ради ресурса SD-карты: мелкие приросты энергии ждут следующего раза
+    if (hasState && state.relayState == lastState.relayState)
+    {
+        int64_t delta = state.energyNanoWh - lastState.energyNanoWh;
+        if (delta == 0 || (delta > 0 && delta < minEnergyDeltaNanoWh))
+            return true;
+    }
+    
+    CheckpointState stamped = state;
+    stamped.savedAtMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    
+    if (!WriteSlotLocked(stamped))
+        return false;
+    
+    lastState = stamped;
+    hasState = true;
+    return true;
+}
@@ -5,6 +5,7 @@
 #include <sstream>
 #include <algorithm>
 #include <cctype>
+#include <cstdlib>
 
 ConfigManager* ConfigManager::instance = nullptr;
 
@@ -15,11 +16,102 @@ ConfigManager::ConfigManager() : configPath("config/config.cfg")
     configData["gpio.pin"] = "17";
     configData["gpio.simulation"] = "false";
     configData["log.level"] = "1";
+    configData["log.file_enabled"] = "false";
     configData["log.file"] = "logs/smart_plug.log";
     configData["log.console"] = "true";
     configData["relay.default_state"] = "off";
     configData["security.api_key"] = "";
     configData["security.enable_auth"] = "false";
+    
+    defaultData = configData;
+    PublishLocked();
+}
+
+ConfigValue ConfigValue::Parse(const std::string& text)
+{
+    ConfigValue value;
+    value.text = text;
+    
+    if (text.empty())
+        return value;
+    
+    const char* begin = text.c_str();
+    char* end = nullptr;
+    long parsedInt = std::strtol(begin, &end, 10);
+    value.isInt = end != begin;
+    value.intValue = static_cast<int>(parsedInt);
+    
+    float parsedFloat = std::strtof(begin, &end);
+    value.isFloat = end != begin;
+    value.floatValue = parsedFloat;
+    
+    std::string lower = text;
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    value.boolValue = (lower == "true" || lower == "1" || lower == "yes");
+    
+    return value;
+}
+
+const ConfigValue* ConfigSnapshot::Find(const std::string& key) const
+{
+    auto it = values.find(key);
+    return it != values.end() ? &it->second : nullptr;
+}
+
+bool ConfigSnapshot::Differs(const ConfigSnapshot& other, const std::string& key) const
+{
+    const ConfigValue* mine = Find(key);
+    const ConfigValue* theirs = other.Find(key);
+    
+    if (!mine || !theirs)
+        return mine != theirs;
+    return mine->text != theirs->text;
+}
+
+std::unique_ptr<ConfigSnapshot> ConfigManager::BuildSnapshot(const std::map<std::string, std::string>& data)
+{
+    auto snapshot = std::make_unique<ConfigSnapshot>();
+    for (const auto& pair : data)
+        snapshot->values.emplace(pair.first, ConfigValue::Parse(pair.second));
+    return snapshot;
+}
+
+std::shared_ptr<const ConfigSnapshot> ConfigManager::PublishLocked()
+{
+    std::shared_ptr<ConfigSnapshot> snapshot = BuildSnapshot(configData);
+    snapshot->version = ++snapshotVersion;
+    
+    snapshot->slots.resize(keySlots.size(), nullptr);
+    for (const auto& pair : keySlots)
+        snapshot->slots[pair.second] = snapshot->Find(pair.first);
+    
+    std::shared_ptr<const ConfigSnapshot> published = std::move(snapshot);
+    std::atomic_store(&currentSnapshot, published);
+    publishedVersion.store(published->version, std::memory_order_release);
+    return published;
+}
+
+const ConfigSnapshot& ConfigManager::CurrentSnapshot() const
+{
+    // Каждый поток держит не больше одного устаревшего снимка
+    thread_local std::shared_ptr<const ConfigSnapshot> cached;
+    if (!cached || cached->version != publishedVersion.load(std::memory_order_acquire))
+        cached = GetSnapshot();
+    return *cached;
+}
+
+size_t ConfigManager::ResolveKey(const std::string& key)
+{
+    std::lock_guard<std::mutex> lock(configMutex);
+    
+    auto it = keySlots.find(key);
+    if (it != keySlots.end())
+        return it->second;
+    
+    size_t slot = keySlots.size();
+    keySlots.emplace(key, slot);
+    PublishLocked();
+    return slot;
 }
 
 ConfigManager& ConfigManager::GetInstance()
@@ -31,26 +123,18 @@ ConfigManager& ConfigManager::GetInstance()
     return *instance;
 }
 
-bool ConfigManager::LoadConfig(const std::string& path)
+bool ConfigManager::ParseConfigFile(const std::string& path, std::map<std::string, std::string>& data)
 {
-    std::lock_guard<std::mutex> lock(configMutex);
-    
-    if (!path.empty())
-        configPath = path;
-
-    std::ifstream file(configPath);
+    std::ifstream file(path);
     if (!file.is_open()) 
-    {
-        LOG_WARNING("Config file not found: " + configPath + ", using defaults");
         return false;
-    }
     
     std::string line;
     while (std::getline(file, line))
     {
         line.erase(std::remove_if(line.begin(), line.end(), ::isspace), 
                   line.end());
-    
+        
         if (line.empty() || line[0] == '#')
             continue;
         
@@ -60,18 +144,163 @@ bool ConfigManager::LoadConfig(const std::string& path)
         
         std::string key = line.substr(0, delimiterPos);
         std::string value = line.substr(delimiterPos + 1);
-    
+        
         if (!value.empty() && value.front() == '"' && value.back() == '"')
             value = value.substr(1, value.length() - 2);
         
-        configData[key] = value;
+        data[key] = value;
     }
     
-    file.close();
+    return true;
+}
+
+bool ConfigManager::Validate(const ConfigSnapshot& candidate, std::string& error)
+{
+    auto checkInt = [&](const std::string& key, int minValue, int maxValue) {
+        const ConfigValue* value = candidate.Find(key);
+        if (!value || value->text.empty())
+            return true;
+        if (!value->isInt || value->intValue < minValue || value->intValue > maxValue)
+        {
+            error = key + " must be an integer in [" + std::to_string(minValue) + 
+                    ", " + std::to_string(maxValue) + "]";
+            return false;
+        }
+        return true;
+    };
+    
+    auto checkFloat = [&](const std::string& key) {
+        const ConfigValue* value = candidate.Find(key);
+        if (!value || value->text.empty())
+            return true;
+        if (!value->isFloat || value->floatValue < 0.0f)
+        {
+            error = key + " must be a non-negative number";
+            return false;
+        }
+        return true;
+    };
+    
+    if (!checkInt("server.port", 1, 65535) ||
+        !checkInt("gpio.pin", 0, 63) ||
+        !checkInt("log.level", 0, 3) ||
+        !checkInt("sensor.sample_rate", 1, 10000) ||
+        !checkFloat("sensor.warning_threshold") ||
+        !checkFloat("sensor.critical_threshold") ||
+        !checkFloat("tariff.peak") ||
+        !checkFloat("tariff.offpeak"))
+        return false;
+    
+    float warning = candidate.Get("sensor.warning_threshold", 2000.0f);
+    float critical = candidate.Get("sensor.critical_threshold", 3000.0f);
+    if (warning >= critical)
+    {
+        error = "sensor.warning_threshold must be below sensor.critical_threshold";
+        return false;
+    }
+    
+    return true;
+}
+
+bool ConfigManager::LoadConfig(const std::string& path)
+{
+    std::lock_guard<std::mutex> lock(configMutex);
+    
+    if (!path.empty())
+        configPath = path;
+    
+    if (!ParseConfigFile(configPath, configData))
+    {
+        LOG_WARNING("Config file not found: " + configPath + ", using defaults");
+        return false;
+    }
+    
+    PublishLocked();
     LOG_INFO("Config loaded from: " + configPath);
     return true;
 }
 
+bool ConfigManager::ReloadConfig()
+{
+    // Перечитывания идут строго по одному, читатели при этом не блокируются
+    std::lock_guard<std::mutex> reloadLock(reloadMutex);
+    
+    std::string path;
+    std::map<std::string, std::string> data;
+    std::vector<ConfigValidator> currentValidators;
+    {
+        std::lock_guard<std::mutex> lock(configMutex);
+        path = configPath;
+        data = defaultData;
+        currentValidators = validators;
+    }
+    
+    if (!ParseConfigFile(path, data))
+    {
+        LOG_ERROR("Config reload failed, cannot read: " + path);
+        return false;
+    }
+    
+    auto candidate = BuildSnapshot(data);
+    std::string error;
+    bool valid = Validate(*candidate, error);
+    for (size_t i = 0; valid && i < currentValidators.size(); ++i)
+        valid = currentValidators[i](*candidate, error);
+    
+    if (!valid)
+    {
+        LOG_ERROR("Config reload rejected, keeping previous configuration: " + error);
+        return false;
+    }
+    
+    std::shared_ptr<const ConfigSnapshot> previous;
+    std::shared_ptr<const ConfigSnapshot> current;
+    std::vector<ConfigListener> currentListeners;
+    {
+        std::lock_guard<std::mutex> lock(configMutex);
+        previous = GetSnapshot();
+        configData = std::move(data);
+        current = PublishLocked();
+        currentListeners = listeners;
+    }
+    
+    static const char* restartKeys[] = {
+        "server.port", "server.address", "gpio.pin", "gpio.simulation",
+        "sensor.type", "sensor.bus", "sensor.address", "sensor.replay_file", "sensor.record_file",
+        "log.file_enabled", "log.file", "log.binary_file", "log.async",
+        "nilm.signatures", "nilm.train_trace"
+    };
+    for (const char* key : restartKeys)
+    {
+        if (current->Differs(*previous, key))
+            LOG_WARNING(std::string("Config key ") + key + " changed, takes effect after restart");
+    }
+    
+    for (const auto& listener : currentListeners)
+        listener(*previous, *current);
+    
+    LOG_INFO("Config reloaded from: " + path + " (version " + std::to_string(current->GetVersion()) + ")");
+    return true;
+}
+
+void ConfigManager::Subscribe(ConfigListener listener)
+{
+    std::lock_guard<std::mutex> lock(configMutex);
+    listeners.push_back(std::move(listener));
+}
+
+void ConfigManager::AddValidator(ConfigValidator validator)
+{
+    std::lock_guard<std::mutex> lock(configMutex);
+    validators.push_back(std::move(validator));
+}
+
+std::string ConfigManager::GetConfigPath()
+{
+    std::lock_guard<std::mutex> lock(configMutex);
+    return configPath;
+}
+
 bool ConfigManager::SaveConfig()
 {
     std::lock_guard<std::mutex> lock(configMutex);
@@ -89,6 +318,7 @@ bool ConfigManager::SaveConfig()
     file << "gpio.simulation=" << configData["gpio.simulation"] << "\n\n";
     
     file << "log.level=" << configData["log.level"] << "\n";
+    file << "log.file_enabled=" << configData["log.file_enabled"] << "\n";
     file << "log.file=\"" << configData["log.file"] << "\"\n";
     file << "log.console=" << configData["log.console"] << "\n\n";
     
@@ -104,60 +334,29 @@ bool ConfigManager::SaveConfig()
 
 std::string ConfigManager::GetString(const std::string& key, const std::string& defaultValue)
 {
-    std::lock_guard<std::mutex> lock(configMutex);
-    auto it = configData.find(key);
-    if (it != configData.end())
-        return it->second;
-
-    return defaultValue;
+    return GetValue<std::string>(key, defaultValue);
 }
 
 int ConfigManager::GetInt(const std::string& key, int defaultValue)
 {
-    std::string value = GetString(key, "");
-    if (value.empty())
-        return defaultValue;
-
-    try
-    {
-        return std::stoi(value);
-    }
-    catch (...)
-    {
-        return defaultValue;
-    }
+    return GetValue(key, defaultValue);
 }
 
-float ConfigManager::GetFloat(const std::string& key, int defaultValue)
+float ConfigManager::GetFloat(const std::string& key, float defaultValue)
 {
-    std::string value = GetString(key, "");
-    if (value.empty())
-        return defaultValue;
-
-    try
-    {
-        return std::stof(value);
-    }
-    catch (...)
-    {
-        return defaultValue;
-    }
+    return GetValue(key, defaultValue);
 }
 
 bool ConfigManager::GetBool(const std::string& key, bool defaultValue)
 {
-    std::string value = GetString(key, "");
-    if (value.empty())
-        return defaultValue;
-
-    std::transform(value.begin(), value.end(), value.begin(), ::tolower);
-    return (value == "true" || value == "1" || value == "yes");
+    return GetValue(key, defaultValue);
 }
 
 void ConfigManager::SetString(const std::string& key, const std::string& value)
 {
     std::lock_guard<std::mutex> lock(configMutex);
     configData[key] = value;
+    PublishLocked();
 }
 
 void ConfigManager::SetInt(const std::string& key, int value)
@@ -173,33 +372,31 @@ void ConfigManager::SetBool(const std::string& key, bool value)
 void ConfigManager::PrintConfig() const
 {
     LOG_INFO("Current configuration:");
-    for (const auto& pair : configData)
-        LOG_INFO("  " + pair.first + " = " + pair.second);
+    for (const auto& pair : CurrentSnapshot().GetValues())
+        LOG_INFO("  " + pair.first + " = " + pair.second.text);
 }
 
 int ConfigManager::GetServerPort() const
 {
-    return std::stoi(configData.at("server.port"));
+    return GetValue("server.port", 5000);
 }
 
 std::string ConfigManager::GetServerAddress() const
 {
-    return configData.at("server.address");
+    return GetValue<std::string>("server.address", "0.0.0.0");
 }
 
 int ConfigManager::GetGPIOPin() const
 {
-    return std::stoi(configData.at("gpio.pin"));
+    return GetValue("gpio.pin", 17);
 }
 
 bool ConfigManager::GetSimulationMode() const 
 {
-    std::string value = configData.at("gpio.simulation");
-    std::transform(value.begin(), value.end(), value.begin(), ::tolower);
-    return (value == "true");
+    return GetValue("gpio.simulation", false);
 }
 
 int ConfigManager::GetLogLevel() const
 {
-    return std::stoi(configData.at("log.level"));
-}
\ No newline at end of file
+    return GetValue("log.level", 1);
+}
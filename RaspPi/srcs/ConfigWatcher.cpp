@@ -0,0 +1,135 @@
+#include "../includes/ConfigWatcher.h"
+#include "../includes/Logger.h"
+
+#include <sys/inotify.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <chrono>
+
+ConfigWatcher::~ConfigWatcher()
+{
+    Stop();
+}
+
+bool ConfigWatcher::Start(const std::string& path, std::function<void()> onChange, int debounceMs)
+{
+    if (running)
+        return true;
+    
+    size_t slash = path.find_last_of('/');
+    directory = slash == std::string::npos ? "." : path.substr(0, slash);
+    fileName = slash == std::string::npos ? path : path.substr(slash + 1);
+    if (directory.empty())
+        directory = "/";
+    
+    changeCallback = std::move(onChange);
+    debounce = debounceMs;
+    
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd < 0)
+    {
+        LOG_ERROR("inotify_init1 failed: " + std::string(strerror(errno)));
+        return false;
+    }
+    
+    if (inotify_add_watch(inotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0)
+    {
+        LOG_ERROR("Failed to watch " + directory + ": " + std::string(strerror(errno)));
+        close(inotifyFd);
+        inotifyFd = -1;
+        return false;
+    }
+    
+    stopFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (stopFd < 0)
+    {
+        LOG_ERROR("eventfd failed: " + std::string(strerror(errno)));
+        close(inotifyFd);
+        inotifyFd = -1;
+        return false;
+    }
+    
+    running = true;
+    watchThread = std::thread(&ConfigWatcher::WatchLoop, this);
+    LOG_INFO("Watching config file: " + path);
+    return true;
+}
+
+void ConfigWatcher::Stop()
+{
+    if (!running.exchange(false))
+        return;
+    
+    uint64_t one = 1;
+    if (write(stopFd, &one, sizeof(one)) < 0)
+        LOG_ERROR("Failed to wake config watcher: " + std::string(strerror(errno)));
+    
+    if (watchThread.joinable())
+        watchThread.join();
+    
+    close(inotifyFd);
+    close(stopFd);
+    inotifyFd = -1;
+    stopFd = -1;
+}
+
+void ConfigWatcher::WatchLoop()
+{
+    using Clock = std::chrono::steady_clock;
+    
+    alignas(struct inotify_event) char buffer[4096];
+    bool pending = false;
+    Clock::time_point deadline;
+    
+    while (running)
+    {
+        int timeout = -1;
+        if (pending)
+        {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+            timeout = left > 0 ? static_cast<int>(left) : 0;
+        }
+        
+        struct pollfd fds[2] = {{inotifyFd, POLLIN, 0}, {stopFd, POLLIN, 0}};
+        int ready = poll(fds, 2, timeout);
+        if (ready < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            LOG_ERROR("Config watcher poll failed: " + std::string(strerror(errno)));
+            break;
+        }
+        
+        if (fds[1].revents & POLLIN)
+            break;
+        
+        if (fds[0].revents & POLLIN)
+        {
+            ssize_t length;
+            while ((length = read(inotifyFd, buffer, sizeof(buffer))) > 0)
+            {
+                for (char* ptr = buffer; ptr < buffer + length; )
+                {
+                    const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(ptr);
+                    if (event->len > 0 && fileName == event->name)
+                    {
+                        // Серия записей одного сохранения схлопывается в одно перечитывание
+                        pending = true;
+                        deadline = Clock::now() + std::chrono::milliseconds(debounce);
+                    }
+                    ptr += sizeof(struct inotify_event) + event->len;
+                }
+            }
+        }
+        
+        if (pending && Clock::now() >= deadline)
+        {
+            pending = false;
+            if (changeCallback)
+                changeCallback();
+        }
+    }
+}
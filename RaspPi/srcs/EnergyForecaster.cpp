@@ -0,0 +1,261 @@
+#include "../includes/EnergyForecaster.h"
+#include "../includes/Metrics.h"
+
+#include <algorithm>
+#include <ctime>
+#include <string>
+
+namespace
+{
+    constexpr uint64_t HOUR_SECONDS = 3600;
+    
+    const char* PERIOD_NAMES[] = {"day", "week", "month"};
+    
+    struct ForecastMetrics
+    {
+        Gauge* energy[EnergyForecast::PERIODS];
+        Gauge* cost[EnergyForecast::PERIODS];
+    };
+    
+    ForecastMetrics& Metrics()
+    {
+        static ForecastMetrics metrics = [] {
+            MetricsRegistry& registry = MetricsRegistry::GetInstance();
+            ForecastMetrics created;
+            for (int period = 0; period < EnergyForecast::PERIODS; ++period)
+            {
+                std::string label = std::string("period=\"") + PERIOD_NAMES[period] + "\"";
+                created.energy[period] = &registry.GetGauge("smart_plug_forecast_energy_kwh",
+                    "Projected energy at the end of the period", label);
+                created.cost[period] = &registry.GetGauge("smart_plug_forecast_cost",
+                    "Projected cost at the end of the period", label);
+            }
+            return created;
+        }();
+        return metrics;
+    }
+    
+    // Местная полночь; mktime сам нормализует выход за границы месяца и переход на летнее время
+    uint64_t LocalMidnight(std::tm date)
+    {
+        date.tm_hour = 0;
+        date.tm_min = 0;
+        date.tm_sec = 0;
+        date.tm_isdst = -1;
+        return static_cast<uint64_t>(std::mktime(&date));
+    }
+}
+
+void EnergyForecaster::Configure(float alpha, float gamma)
+{
+    Metrics();
+    
+    this->alpha = std::clamp(alpha, 0.001f, 1.0f);
+    this->gamma = std::clamp(gamma, 0.001f, 1.0f);
+}
+
+void EnergyForecaster::AddReading(float energy, float cost, uint64_t timestamp, const TariffTable& tariffs)
+{
+    if (hourStart == 0)
+        StartHour(timestamp, tariffs);
+    else if (timestamp >= hourEnd)
+        Advance(timestamp, tariffs);
+    
+    // Запись из уже закрытого часа в модель не попадает, но итоги периодов не теряет
+    if (timestamp >= hourStart)
+        hourEnergy += energy;
+    for (Period& period : periods)
+    {
+        if (timestamp < period.start)
+            continue;
+        period.energy += energy;
+        period.cost += cost;
+    }
+}
+
+void EnergyForecaster::Advance(uint64_t timestamp, const TariffTable& tariffs)
+{
+    if (hourStart == 0 || timestamp < hourEnd)
+        return;
+    
+    CloseHour(hourSlot, hourEnergy);
+    
+    // Часы без записей - нулевое потребление, если розетка работала; после
+    // долгого простоя модель не трогается
+    uint64_t next = hourEnd;
+    if (timestamp - next < MAX_GAP_HOURS * HOUR_SECONDS)
+    {
+        for (; next + HOUR_SECONDS <= timestamp; next += HOUR_SECONDS)
+            CloseHour(tariffs.resolve(next).slot % WEEK_HOURS, 0.0);
+    }
+    
+    StartHour(timestamp, tariffs);
+}
+
+void EnergyForecaster::CloseHour(int slot, double energy)
+{
+    float value = static_cast<float>(energy);
+    
+    if (!modelReady)
+    {
+        level = value;
+        modelReady = true;
+    }
+    else
+    {
+        float correction = seen[slot] ? seasonal[slot] : 0.0f;
+        level += alpha * (value - correction - level);
+        // Первое появление часа недели задаёт поправку целиком
+        seasonal[slot] = seen[slot] ? correction + gamma * (value - level - correction) : value - level;
+    }
+    
+    seen[slot] = true;
+    hoursObserved++;
+}
+
+void EnergyForecaster::StartHour(uint64_t timestamp, const TariffTable& tariffs)
+{
+    const LocalHour& local = tariffs.resolve(timestamp);
+    hourStart = local.hourStart;
+    hourEnd = hourStart + HOUR_SECONDS;
+    hourSlot = local.slot % WEEK_HOURS;
+    hourPrice = tariffs.priceOfSlot(local.slot);
+    hourEnergy = 0.0;
+    
+    UpdatePeriods(hourStart);
+    RecomputeRemaining(tariffs);
+    
+    ForecastMetrics& metrics = Metrics();
+    EnergyForecast forecast = GetForecast();
+    for (int i = 0; i < EnergyForecast::PERIODS; ++i)
+    {
+        metrics.energy[i]->Set(forecast.periods[i].projectedEnergy);
+        metrics.cost[i]->Set(forecast.periods[i].projectedCost);
+    }
+}
+
+void EnergyForecaster::UpdatePeriods(uint64_t timestamp)
+{
+    std::time_t time = static_cast<std::time_t>(timestamp);
+    std::tm local {};
+    localtime_r(&time, &local);
+    
+    uint64_t starts[EnergyForecast::PERIODS];
+    uint64_t ends[EnergyForecast::PERIODS];
+    
+    std::tm day = local;
+    starts[0] = LocalMidnight(day);
+    day.tm_mday += 1;
+    ends[0] = LocalMidnight(day);
+    
+    std::tm week = local;
+    week.tm_mday -= (local.tm_wday + 6) % 7;
+    starts[1] = LocalMidnight(week);
+    week.tm_mday += 7;
+    ends[1] = LocalMidnight(week);
+    
+    std::tm month = local;
+    month.tm_mday = 1;
+    starts[2] = LocalMidnight(month);
+    month.tm_mon += 1;
+    ends[2] = LocalMidnight(month);
+    
+    for (int i = 0; i < EnergyForecast::PERIODS; ++i)
+    {
+        if (periods[i].start == starts[i])
+            continue;
+        
+        periods[i].start = starts[i];
+        periods[i].end = ends[i];
+        periods[i].energy = 0.0;
+        periods[i].cost = 0.0;
+    }
+}
+
+void EnergyForecaster::RecomputeRemaining(const TariffTable& tariffs)
+{
+    // Раз в час: до 31 * 24 + 7 * 24 часов, localtime на каждый
+    uint64_t last = 0;
+    for (Period& period : periods)
+    {
+        period.remainingEnergy = 0.0;
+        period.remainingCost = 0.0;
+        last = std::max(last, period.end);
+    }
+    
+    if (!modelReady)
+        return;
+    
+    for (uint64_t time = hourEnd; time < last; time += HOUR_SECONDS)
+    {
+        const LocalHour& local = tariffs.resolve(time);
+        double energy = ExpectedEnergy(local.slot % WEEK_HOURS);
+        double cost = energy * tariffs.priceOfSlot(local.slot);
+        
+        for (Period& period : periods)
+        {
+            if (time >= period.end)
+                continue;
+            period.remainingEnergy += energy;
+            period.remainingCost += cost;
+        }
+    }
+}
+
+float EnergyForecaster::ExpectedEnergy(int slot) const
+{
+    if (!modelReady)
+        return 0.0f;
+    return std::max(0.0f, level + (seen[slot] ? seasonal[slot] : 0.0f));
+}
+
+void EnergyForecaster::SetCost(ForecastPeriod period, double cost)
+{
+    periods[static_cast<int>(period)].cost = cost;
+}
+
+void EnergyForecaster::Reprice(const TariffTable& tariffs)
+{
+    if (hourStart == 0)
+        return;
+    
+    hourPrice = tariffs.priceAt(hourStart);
+    RecomputeRemaining(tariffs);
+}
+
+uint64_t EnergyForecaster::GetPeriodStart(ForecastPeriod period) const
+{
+    return periods[static_cast<int>(period)].start;
+}
+
+EnergyForecast EnergyForecaster::GetForecast() const
+{
+    EnergyForecast forecast {};
+    forecast.hourEnergy = ExpectedEnergy(hourSlot);
+    forecast.averagePower = level * 1000.0f;
+    forecast.hoursObserved = hoursObserved;
+    forecast.hourStart = hourStart;
+    
+    // Остаток текущего часа: ожидание минус уже набранное
+    double restEnergy = std::max(0.0, static_cast<double>(forecast.hourEnergy) - hourEnergy);
+    double restCost = restEnergy * hourPrice;
+    
+    for (int i = 0; i < EnergyForecast::PERIODS; ++i)
+    {
+        const Period& period = periods[i];
+        PeriodForecast& result = forecast.periods[i];
+        result.start = period.start;
+        result.end = period.end;
+        result.energy = period.energy;
+        result.cost = period.cost;
+        result.projectedEnergy = period.energy + restEnergy + period.remainingEnergy;
+        result.projectedCost = period.cost + restCost + period.remainingCost;
+    }
+    
+    return forecast;
+}
+
+const char* EnergyForecaster::PeriodName(ForecastPeriod period)
+{
+    return PERIOD_NAMES[static_cast<int>(period)];
+}
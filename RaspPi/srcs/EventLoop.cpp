@@ -0,0 +1,231 @@
+#include "../includes/EventLoop.h"
+#include "../includes/Logger.h"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <signal.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+EventLoop::EventLoop()
+{
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd < 0)
+    {
+        LOG_ERROR("epoll_create1 failed: " + std::string(strerror(errno)));
+        return;
+    }
+    
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeFd < 0)
+    {
+        LOG_ERROR("eventfd failed: " + std::string(strerror(errno)));
+        return;
+    }
+    
+    AddHandler(wakeFd, EPOLLIN, [this](uint32_t) {
+        uint64_t value;
+        while (read(wakeFd, &value, sizeof(value)) > 0)
+            ;
+        RunPosted();
+    });
+}
+
+EventLoop::~EventLoop()
+{
+    for (int fd : ownedFds)
+        close(fd);
+    if (wakeFd >= 0)
+        close(wakeFd);
+    if (epollFd >= 0)
+        close(epollFd);
+}
+
+bool EventLoop::BlockSignals(std::initializer_list<int> signals)
+{
+    sigset_t mask;
+    sigemptyset(&mask);
+    for (int signo : signals)
+        sigaddset(&mask, signo);
+    
+    int result = pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+    if (result != 0)
+    {
+        LOG_ERROR("pthread_sigmask failed: " + std::string(strerror(result)));
+        return false;
+    }
+    return true;
+}
+
+bool EventLoop::AddHandler(int fd, uint32_t events, std::function<void(uint32_t)> handler)
+{
+    struct epoll_event event {};
+    event.events = events;
+    event.data.fd = fd;
+    
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) < 0)
+    {
+        LOG_ERROR("epoll_ctl failed for fd " + std::to_string(fd) + ": " + std::string(strerror(errno)));
+        return false;
+    }
+    
+    handlers[fd] = std::move(handler);
+    return true;
+}
+
+int EventLoop::AddTimer(std::chrono::milliseconds interval, std::function<void()> handler)
+{
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd < 0)
+    {
+        LOG_ERROR("timerfd_create failed: " + std::string(strerror(errno)));
+        return -1;
+    }
+    
+    struct itimerspec spec {};
+    spec.it_interval.tv_sec = interval.count() / 1000;
+    spec.it_interval.tv_nsec = (interval.count() % 1000) * 1000000;
+    spec.it_value = spec.it_interval;
+    
+    if (timerfd_settime(fd, 0, &spec, nullptr) < 0)
+    {
+        LOG_ERROR("timerfd_settime failed: " + std::string(strerror(errno)));
+        close(fd);
+        return -1;
+    }
+    
+    bool added = AddHandler(fd, EPOLLIN, [fd, handler = std::move(handler)](uint32_t) {
+        // Пропущенные срабатывания схлопываются в один вызов
+        uint64_t expirations;
+        if (read(fd, &expirations, sizeof(expirations)) > 0)
+            handler();
+    });
+    
+    if (!added)
+    {
+        close(fd);
+        return -1;
+    }
+    
+    ownedFds.push_back(fd);
+    return fd;
+}
+
+int EventLoop::AddSignals(std::initializer_list<int> signals, std::function<void(int)> handler)
+{
+    sigset_t mask;
+    sigemptyset(&mask);
+    for (int signo : signals)
+        sigaddset(&mask, signo);
+    
+    int fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (fd < 0)
+    {
+        LOG_ERROR("signalfd failed: " + std::string(strerror(errno)));
+        return -1;
+    }
+    
+    bool added = AddHandler(fd, EPOLLIN, [fd, handler = std::move(handler)](uint32_t) {
+        struct signalfd_siginfo info;
+        while (read(fd, &info, sizeof(info)) == sizeof(info))
+            handler(static_cast<int>(info.ssi_signo));
+    });
+    
+    if (!added)
+    {
+        close(fd);
+        return -1;
+    }
+    
+    ownedFds.push_back(fd);
+    return fd;
+}
+
+int EventLoop::AddFd(int fd, uint32_t events, std::function<void(uint32_t)> handler)
+{
+    return AddHandler(fd, events, std::move(handler)) ? fd : -1;
+}
+
+void EventLoop::Remove(int fd)
+{
+    if (handlers.erase(fd) == 0)
+        return;
+    
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    
+    auto it = std::find(ownedFds.begin(), ownedFds.end(), fd);
+    if (it != ownedFds.end())
+    {
+        close(fd);
+        ownedFds.erase(it);
+    }
+}
+
+void EventLoop::Post(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(postMutex);
+        posted.push_back(std::move(task));
+    }
+    
+    uint64_t one = 1;
+    if (write(wakeFd, &one, sizeof(one)) < 0 && errno != EAGAIN)
+        LOG_ERROR("Failed to wake event loop: " + std::string(strerror(errno)));
+}
+
+void EventLoop::Stop()
+{
+    stopped = true;
+    Post(nullptr);
+}
+
+void EventLoop::RunPosted()
+{
+    std::vector<std::function<void()>> tasks;
+    {
+        std::lock_guard<std::mutex> lock(postMutex);
+        tasks.swap(posted);
+    }
+    
+    for (auto& task : tasks)
+    {
+        if (task)
+            task();
+    }
+}
+
+void EventLoop::Run()
+{
+    if (!IsValid())
+        return;
+    
+    struct epoll_event events[16];
+    
+    while (!stopped)
+    {
+        int count = epoll_wait(epollFd, events, 16, -1);
+        if (count < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            LOG_ERROR("epoll_wait failed: " + std::string(strerror(errno)));
+            break;
+        }
+        
+        for (int i = 0; i < count && !stopped; ++i)
+        {
+            // Обработчик мог удалить регистрацию другого дескриптора
+            auto it = handlers.find(events[i].data.fd);
+            if (it != handlers.end())
+            {
+                auto handler = it->second;
+                handler(events[i].events);
+            }
+        }
+    }
+}
@@ -1,14 +1,6 @@
 #include "../includes/GPIOController.h"
 #include "../includes/Logger.h"
 
-#include <map>
-#include <thread>
-#include <chrono>
-
-#ifdef RASPBERRY_PI
-#include <wiringPi.h>
-#endif
-
 GPIOController::~GPIOController()
 {
     Cleanup();
@@ -16,53 +8,35 @@ GPIOController::~GPIOController()
 
 bool GPIOController::Initialize(int pin, bool simulation)
 {
-    m_PinNumber = pin;
-    m_IsSimulation = simulation;
+    std::unique_ptr<IGPIO> backend;
     
-    if (m_IsSimulation)
-    {
+    if (simulation)
         LOG_INFO("Initializing GPIO in simulation mode, pin: " + std::to_string(pin));
-        m_IsInitialized = InitializeSimulation();
-    }
     else
     {
         LOG_INFO("Initializing real GPIO, pin: " + std::to_string(pin));
-        m_IsInitialized = InitializeRealGPIO();
+        backend = CreateHardwareGPIO();
+        if (!backend)
+            LOG_WARNING("GPIO hardware support not compiled in, using simulation mode");
     }
     
-    LOG_INFO(m_IsInitialized ? "GPIO initialized successfully" : "Failed to initialize GPIO");
-    return m_IsInitialized;
-}
-
-bool GPIOController::InitializeRealGPIO()
-{
-#ifdef RASPBERRY_PI
-    try
-    {
-        if (wiringPiSetup() == -1)
-        {
-            LOG_ERROR("Failed to initialize wiringPi");
-            return false;
-        }
-        LOG_INFO("wiringPi initialized successfully");
-        return true;
-    }
-    catch (const std::exception& e)
-    {
-        LOG_ERROR("Exception in wiringPi initialization: " + std::string(e.what()));
-        return false;
-    }
-#else
-    LOG_WARNING("Not on Raspberry Pi, using simulation mode");
-    m_IsSimulation = true;
-    return InitializeSimulation();
-#endif
+    if (!backend)
+        backend = std::make_unique<SimulatedGPIO>();
+    
+    return Initialize(pin, std::move(backend));
 }
 
-bool GPIOController::InitializeSimulation()
+bool GPIOController::Initialize(int pin, std::unique_ptr<IGPIO> backend)
 {
-    LOG_INFO("Simulation mode activated - no real GPIO operations");
-    return true;
+    Cleanup();
+    
+    m_PinNumber = pin;
+    m_Backend = std::move(backend);
+    m_IsSimulation = dynamic_cast<SimulatedGPIO*>(m_Backend.get()) != nullptr;
+    m_IsInitialized = m_Backend && m_Backend->Setup();
+    
+    LOG_INFO(m_IsInitialized ? "GPIO initialized successfully" : "Failed to initialize GPIO");
+    return m_IsInitialized;
 }
 
 void GPIOController::Cleanup() {
@@ -81,32 +55,7 @@ bool GPIOController::SetPinMode(int pin, int mode)
         return false;
     }
     
-    return m_IsSimulation ? SetPinModeSim(pin, mode) : SetPinModeReal(pin, mode); 
-}
-
-bool GPIOController::SetPinModeReal(int pin, int mode)
-{
-#ifdef RASPBERRY_PI
-    try
-    {
-        pinMode(pin, mode);
-        LOG_DEBUG("Set pin " + std::to_string(pin) + " mode to " + (mode == Pins::Input ? "INPUT" : "OUTPUT"));
-        return true;
-    }
-    catch (const std::exception& e)
-    {
-        LOG_ERROR("Failed to set pin mode: " + std::string(e.what()));
-        return false;
-    }
-#else
-    return false;
-#endif
-}
-
-bool GPIOController::SetPinModeSim(int pin, int mode)
-{
-    LOG_DEBUG("[SIM] Set pin " + std::to_string(pin) + " mode to " + (mode == Pins::Input ? "INPUT" : "OUTPUT"));
-    return true;
+    return m_Backend->SetPinMode(pin, mode);
 }
 
 bool GPIOController::WritePin(int pin, int value)
@@ -117,32 +66,12 @@ bool GPIOController::WritePin(int pin, int value)
         return false;
     }
     
-    return m_IsSimulation ? WritePinSim(pin, value) : WritePinReal(pin, value);
-}
-
-bool GPIOController::WritePinReal(int pin, int value)
-{
-#ifdef RASPBERRY_PI
-    try
-    {
-        digitalWrite(pin, value);
-        LOG_DEBUG("Set pin " + std::to_string(pin) + " to " + (value == Pins::High ? "HIGH" : "LOW"));
-        return true;
-    }
-    catch (const std::exception& e)
-    {
-        LOG_ERROR("Failed to write pin: " + std::string(e.what()));
-        return false;
-    }
-#else
-    return false;
-#endif
+    return m_Backend->Write(pin, value);
 }
 
-bool GPIOController::WritePinSim(int pin, int value)
+bool GPIOController::WritePinRaw(int pin, int value) noexcept
 {
-    LOG_DEBUG("[SIM] Set pin " + std::to_string(pin) + " to " + (value == Pins::High ? "HIGH" : "LOW"));
-    return true;
+    return m_IsInitialized && m_Backend->WriteRaw(pin, value);
 }
 
 int GPIOController::ReadPin(int pin)
@@ -153,32 +82,7 @@ int GPIOController::ReadPin(int pin)
         return -1;
     }
     
-    return m_IsSimulation ? ReadPinSim(pin) : ReadPinReal(pin);
-}
-
-int GPIOController::ReadPinReal(int pin)
-{
-#ifdef RASPBERRY_PI
-    try
-    {
-        int value = digitalRead(pin);
-        LOG_DEBUG("Read pin " + std::to_string(pin) + " = " + std::to_string(value));
-        return value;
-    }
-    catch (const std::exception& e)
-    {
-        LOG_ERROR("Failed to read pin: " + std::string(e.what()));
-        return -1;
-    }
-#else
-    return -1;
-#endif
-}
-
-int GPIOController::ReadPinSim(int pin)
-{
-    LOG_DEBUG("[SIM] Read pin " + std::to_string(pin) + " = 0");
-    return Pins::Low;
+    return m_Backend->Read(pin);
 }
 
 bool GPIOController::DigitalWrite(int pin, bool state)
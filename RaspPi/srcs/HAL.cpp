@@ -0,0 +1,224 @@
+#include "../includes/HAL.h"
+#include "../includes/GPIOController.h"
+#include "../includes/Logger.h"
+
+#include <string>
+#include <chrono>
+#include <thread>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/i2c-dev.h>
+
+#ifdef SMART_PLUG_HAVE_WIRINGPI
+#include <wiringPi.h>
+#endif
+
+bool SimulatedGPIO::Setup()
+{
+    LOG_INFO("Simulation mode activated - no real GPIO operations");
+    return true;
+}
+
+bool SimulatedGPIO::SetPinMode(int pin, int mode)
+{
+    LOG_DEBUGF("[SIM] Set pin {} mode to {}", pin, mode == Pins::Input ? "INPUT" : "OUTPUT");
+    return true;
+}
+
+bool SimulatedGPIO::Write(int pin, int value)
+{
+    if (!WriteRaw(pin, value))
+        return false;
+    
+    LOG_DEBUGF("[SIM] Set pin {} to {}", pin, value == Pins::High ? "HIGH" : "LOW");
+    return true;
+}
+
+bool SimulatedGPIO::WriteRaw(int pin, int value) noexcept
+{
+    if (pin < 0 || pin >= MAX_PINS)
+        return false;
+    
+    levels[pin].store(value, std::memory_order_relaxed);
+    return true;
+}
+
+int SimulatedGPIO::Read(int pin)
+{
+    if (pin < 0 || pin >= MAX_PINS)
+        return -1;
+    
+    int value = levels[pin].load(std::memory_order_relaxed);
+    LOG_DEBUGF("[SIM] Read pin {} = {}", pin, value);
+    return value;
+}
+
+#ifdef SMART_PLUG_HAVE_WIRINGPI
+class WiringPiGPIO : public IGPIO
+{
+public:
+    bool Setup() override
+    {
+        if (wiringPiSetup() == -1)
+        {
+            LOG_ERROR("Failed to initialize wiringPi");
+            return false;
+        }
+        LOG_INFO("wiringPi initialized successfully");
+        return true;
+    }
+    
+    bool SetPinMode(int pin, int mode) override
+    {
+        pinMode(pin, mode == Pins::Input ? INPUT : OUTPUT);
+        LOG_DEBUGF("Set pin {} mode to {}", pin, mode == Pins::Input ? "INPUT" : "OUTPUT");
+        return true;
+    }
+    
+    bool Write(int pin, int value) override
+    {
+        WriteRaw(pin, value);
+        LOG_DEBUGF("Set pin {} to {}", pin, value == Pins::High ? "HIGH" : "LOW");
+        return true;
+    }
+    
+    bool WriteRaw(int pin, int value) noexcept override
+    {
+        digitalWrite(pin, value == Pins::High ? HIGH : LOW);
+        return true;
+    }
+    
+    int Read(int pin) override
+    {
+        int value = digitalRead(pin) == HIGH ? Pins::High : Pins::Low;
+        LOG_DEBUGF("Read pin {} = {}", pin, value);
+        return value;
+    }
+    
+    const char* GetName() const override { return "wiringPi"; }
+};
+
+std::unique_ptr<IGPIO> CreateHardwareGPIO()
+{
+    return std::make_unique<WiringPiGPIO>();
+}
+#else
+std::unique_ptr<IGPIO> CreateHardwareGPIO()
+{
+    return nullptr;
+}
+#endif
+
+bool LinuxI2CBus::Open(int bus, int address)
+{
+    Close();
+    
+    std::string device = "/dev/i2c-" + std::to_string(bus);
+    fd = ::open(device.c_str(), O_RDWR | O_CLOEXEC);
+    if (fd < 0)
+    {
+        LOG_ERROR("Failed to open " + device + ": " + std::strerror(errno));
+        return false;
+    }
+    
+    if (ioctl(fd, I2C_SLAVE, address) < 0)
+    {
+        LOG_ERROR("Failed to select I2C address " + std::to_string(address) + ": " + std::strerror(errno));
+        Close();
+        return false;
+    }
+    
+    return true;
+}
+
+void LinuxI2CBus::Close()
+{
+    if (fd >= 0)
+    {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+bool LinuxI2CBus::ReadRegister(uint8_t reg, uint16_t& value)
+{
+    uint8_t data[2];
+    if (fd < 0 || ::write(fd, &reg, 1) != 1 || ::read(fd, data, 2) != 2)
+        return false;
+    
+    value = static_cast<uint16_t>((data[0] << 8) | data[1]);
+    return true;
+}
+
+bool LinuxI2CBus::WriteRegister(uint8_t reg, uint16_t value)
+{
+    uint8_t data[3] = {reg, static_cast<uint8_t>(value >> 8), static_cast<uint8_t>(value & 0xFF)};
+    return fd >= 0 && ::write(fd, data, sizeof(data)) == static_cast<ssize_t>(sizeof(data));
+}
+
+bool FakeSensorBus::Open(int, int)
+{
+    open = !failing;
+    return open;
+}
+
+bool FakeSensorBus::ReadRegister(uint8_t reg, uint16_t& value)
+{
+    if (!open || failing)
+        return false;
+    
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = registers.find(reg);
+    value = it != registers.end() ? it->second : 0;
+    return true;
+}
+
+bool FakeSensorBus::WriteRegister(uint8_t reg, uint16_t value)
+{
+    if (!open || failing)
+        return false;
+    
+    SetRegister(reg, value);
+    return true;
+}
+
+void FakeSensorBus::SetRegister(uint8_t reg, uint16_t value)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    registers[reg] = value;
+}
+
+SystemClock& SystemClock::GetInstance()
+{
+    static SystemClock instance;
+    return instance;
+}
+
+int64_t SystemClock::MonotonicNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int64_t SystemClock::WallTimeMs()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void SystemClock::SleepUntilNs(int64_t monotonicNs)
+{
+    std::this_thread::sleep_until(std::chrono::steady_clock::time_point(
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds(monotonicNs))));
+}
+
+void FakeClock::SleepUntilNs(int64_t monotonicNs)
+{
+    int64_t current = nowNs.load(std::memory_order_acquire);
+    while (current < monotonicNs && !nowNs.compare_exchange_weak(current, monotonicNs, std::memory_order_acq_rel))
+    {
+    }
+}
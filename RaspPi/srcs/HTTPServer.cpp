@@ -1,12 +1,132 @@
 #include "../includes/HTTPServer.h"
 #include "../includes/Logger.h"
 #include "../includes/ConfigManager.h"
+#include "../includes/Metrics.h"
 
 #include <sstream>
-#ifdef RASPBERRY_PI
 #include <json/json.h>
-#endif
+#include <arpa/inet.h>
 #include <ctime>
+#include <cstdlib>
+#include <cstring>
+#include <charconv>
+#include <chrono>
+#include <vector>
+
+static constexpr uint64_t HISTORY_MAX_BUCKETS = 10000;
+static constexpr size_t EXPORT_CHUNK_SIZE = 64 * 1024;
+
+template <typename T>
+static void AppendNumber(std::string& out, T value)
+{
+    char buffer[32];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr);
+}
+
+// Только десятичные цифры целиком; знак, пробелы и хвост - ошибка
+static bool ParseUnsigned(const char* text, uint64_t& value)
+{
+    const char* end = text + std::strlen(text);
+    auto result = std::from_chars(text, end, value);
+    return result.ec == std::errc() && result.ptr == end && text != end;
+}
+
+template <typename T>
+static void AppendRaw(std::string& out, const T& value)
+{
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+// Метки метрик - фиксированный список маршрутов и кодов, чтобы число рядов не росло от URL
+static constexpr const char* HTTP_ROUTES[] = {
+    "/on", "/off", "/toggle", "/power", "/energy", "/stats", "/history", "/export",
+    "/sensor/config", "/calibrate", "/status", "/health", "/metrics", "/appliances", "/power-quality", "other"
+};
+static constexpr size_t HTTP_ROUTE_COUNT = sizeof(HTTP_ROUTES) / sizeof(HTTP_ROUTES[0]);
+static constexpr int HTTP_CODES[] = {200, 400, 401, 404, 405, 500, 503};
+static constexpr size_t HTTP_CODE_COUNT = sizeof(HTTP_CODES) / sizeof(HTTP_CODES[0]);
+
+static constexpr bool SameRoute(const char* a, const char* b)
+{
+    while (*a != '\0' && *a == *b)
+    {
+        ++a;
+        ++b;
+    }
+    return *a == *b;
+}
+
+static constexpr size_t RouteOf(const char* route)
+{
+    for (size_t i = 0; i + 1 < HTTP_ROUTE_COUNT; ++i)
+    {
+        if (SameRoute(HTTP_ROUTES[i], route))
+            return i;
+    }
+    return HTTP_ROUTE_COUNT - 1;
+}
+
+// Маршруты с параметром в пути; индексы берутся из таблицы, а не вписываются руками
+static constexpr size_t STATS_ROUTE = RouteOf("/stats");
+static constexpr size_t CALIBRATE_ROUTE = RouteOf("/calibrate");
+static_assert(STATS_ROUTE + 1 < HTTP_ROUTE_COUNT && CALIBRATE_ROUTE + 1 < HTTP_ROUTE_COUNT,
+              "Parameterised routes must be listed in HTTP_ROUTES");
+
+static size_t RouteIndex(const char* url)
+{
+    if (std::strncmp(url, "/stats/", 7) == 0)
+        return STATS_ROUTE;
+    if (std::strncmp(url, "/calibrate", 10) == 0)
+        return CALIBRATE_ROUTE;
+    
+    for (size_t i = 0; i + 1 < HTTP_ROUTE_COUNT; ++i)
+    {
+        if (std::strcmp(url, HTTP_ROUTES[i]) == 0)
+            return i;
+    }
+    return HTTP_ROUTE_COUNT - 1;
+}
+
+struct HTTPMetrics
+{
+    Counter* requests[HTTP_ROUTE_COUNT];
+    Histogram* latency[HTTP_ROUTE_COUNT];
+    Counter* responses[HTTP_CODE_COUNT + 1];
+    
+    HTTPMetrics()
+    {
+        MetricsRegistry& registry = MetricsRegistry::GetInstance();
+        for (size_t i = 0; i < HTTP_ROUTE_COUNT; ++i)
+        {
+            std::string labels = std::string("route=\"") + HTTP_ROUTES[i] + "\"";
+            requests[i] = &registry.GetCounter("smart_plug_http_requests_total", "HTTP requests by route", labels);
+            latency[i] = &registry.GetHistogram("smart_plug_http_request_duration_seconds",
+                "HTTP request handling time", {0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.5, 1.0}, labels);
+        }
+        for (size_t i = 0; i < HTTP_CODE_COUNT; ++i)
+            responses[i] = &registry.GetCounter("smart_plug_http_responses_total", "HTTP responses by status code",
+                                                "code=\"" + std::to_string(HTTP_CODES[i]) + "\"");
+        responses[HTTP_CODE_COUNT] = &registry.GetCounter("smart_plug_http_responses_total",
+                                                          "HTTP responses by status code", "code=\"other\"");
+    }
+    
+    static HTTPMetrics& Get()
+    {
+        static HTTPMetrics metrics;
+        return metrics;
+    }
+    
+    Counter& Response(int code)
+    {
+        for (size_t i = 0; i < HTTP_CODE_COUNT; ++i)
+        {
+            if (HTTP_CODES[i] == code)
+                return *responses[i];
+        }
+        return *responses[HTTP_CODE_COUNT];
+    }
+};
 
 HTTPServer::~HTTPServer()
 {
@@ -34,15 +154,13 @@ bool HTTPServer::Start(int serverPort, const std::string& serverAddress)
         LOG_INFO("API authentication enabled");
     }
     
-#ifdef RASPBERRY_PI
     daemon = MHD_start_daemon(
         MHD_USE_SELECT_INTERNALLY,
         port,
         NULL, NULL,
-        &HTTPServer::handleRequest, this,
+        &HTTPServer::HandleRequest, this,
         MHD_OPTION_NOTIFY_COMPLETED, NULL, NULL,
         MHD_OPTION_END);
-#endif
     
     if (!daemon)
     {
@@ -57,6 +175,10 @@ bool HTTPServer::Start(int serverPort, const std::string& serverAddress)
     LOG_INFO("  GET  /on       - Turn relay ON");
     LOG_INFO("  GET  /off      - Turn relay OFF");
     LOG_INFO("  GET  /toggle   - Toggle relay state");
+    LOG_INFO("  GET  /history  - Energy history (from, to, step, format)");
+    LOG_INFO("  GET  /export   - Download daily stats (days, format)");
+    LOG_INFO("  GET  /appliances - Detected appliances and recent load steps");
+    LOG_INFO("  GET  /power-quality - Voltage and frequency events, THD (since, type)");
     LOG_INFO("  GET  /status   - Get current status");
     LOG_INFO("  GET  /health   - Health check");
     
@@ -67,33 +189,39 @@ void HTTPServer::Stop()
 {
     if (daemon)
     {
-#ifdef RASPBERRY_PI
         MHD_stop_daemon(daemon);
-#endif
         daemon = nullptr;
         running = false;
         LOG_INFO("HTTP server stopped");
     }
 }
 
-int HTTPServer::HandleRequest(void* cls, struct MHD_Connection* connection,
-                            const char* url, const char* method,
-                            const char* version, const char* upload_data,
-                            size_t* upload_data_size, void** con_cls)
+MHDResult HTTPServer::HandleRequest(void* cls, struct MHD_Connection* connection,
+                                  const char* url, const char* method,
+                                  const char* /* version */, const char* /* upload_data */,
+                                  size_t* /* upload_data_size */, void** /* con_cls */)
 {
     HTTPServer* server = static_cast<HTTPServer*>(cls);
-    return server->ProcessRequest(connection, url, method);
+    auto start = std::chrono::steady_clock::now();
+    
+    int ret = server->ProcessRequest(connection, url, method);
+    
+    size_t route = RouteIndex(url);
+    HTTPMetrics& metrics = HTTPMetrics::Get();
+    metrics.requests[route]->Add();
+    metrics.latency[route]->Observe(
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    return static_cast<MHDResult>(ret);
 }
 
 int HTTPServer::ProcessRequest(struct MHD_Connection* connection, const std::string& url, const std::string& method)
 {
     std::string clientIP = GetClientIP(connection);
     int ret = 0;
-
+    
     if (!CheckAuthentication(connection))
     {
         LogRequest(clientIP, method, url, 401);
-#ifdef RASPBERRY_PI
         Json::Value response;
         response["status"] = "error";
         response["message"] = "Unauthorized";
@@ -108,14 +236,18 @@ int HTTPServer::ProcessRequest(struct MHD_Connection* connection, const std::str
         MHD_add_response_header(mhdResponse, "Content-Type", "application/json");
         ret = MHD_queue_response(connection, 401, mhdResponse);
         MHD_destroy_response(mhdResponse);
-#endif
         return ret;
     }
     
+    if (method == "GET" && url == "/export")
+        return handleExportRequest(connection, clientIP);
+    if (method == "GET" && url == "/metrics")
+        return handleMetricsRequest(connection, clientIP);
+    
     std::string responseStr;
+    std::string contentType = "application/json";
     int responseCode = 200;
     
-#ifdef RASPBERRY_PI
     Json::Value response;
     
     if (method == "GET")
@@ -178,6 +310,10 @@ int HTTPServer::ProcessRequest(struct MHD_Connection* connection, const std::str
             std::string period = url.substr(7);
             responseStr = handleStatsRequest(period);
         }
+        else if (url == "/history")
+        {
+            responseStr = handleHistoryRequest(connection, contentType, responseCode);
+        }
         else if (url == "/sensor/config")
         {
             responseStr = handleSensorConfigRequest();
@@ -186,11 +322,52 @@ int HTTPServer::ProcessRequest(struct MHD_Connection* connection, const std::str
         {
             responseStr = handleCalibrationRequest(url);
         }
+        else if (url == "/appliances")
+        {
+            responseStr = handleAppliancesRequest();
+        }
+        else if (url == "/power-quality")
+        {
+            responseStr = handlePowerQualityRequest(connection);
+        }
         else if (url == "/status")
         {
             response["status"] = "success";
             response["state"] = relay.IsOn() ? "on" : "off";
             response["uptime"] = static_cast<int>(std::time(nullptr));
+            
+            response["sampling"]["mode"] = SamplingGovernor::ModeName(sensorManager.getSamplingMode());
+            response["sampling"]["rate_hz"] = sensorManager.getCurrentSampleRate();
+            
+            ThermalSnapshot thermal = sensorManager.getThermalSnapshot();
+            response["thermal"]["cpu_temperature"] = thermal.cpuTemperature;
+            response["thermal"]["cpu_frequency_khz"] = thermal.cpuFrequencyKHz;
+            if (thermal.throttleAvailable)
+            {
+                response["thermal"]["throttled"] = thermal.throttled;
+                response["thermal"]["under_voltage"] = (thermal.throttled & Throttle::UNDER_VOLTAGE) != 0;
+                response["thermal"]["frequency_capped"] = (thermal.throttled & Throttle::FREQUENCY_CAPPED) != 0;
+                response["thermal"]["throttling"] = (thermal.throttled & Throttle::THROTTLED) != 0;
+            }
+            for (int i = 0; i < thermal.zoneCount; ++i)
+                if (thermal.zones[i].valid)
+                    response["thermal"]["zones"][thermal.zones[i].type] = thermal.zones[i].celsius;
+            
+            AnomalySnapshot anomalies = sensorManager.getAnomalies();
+            for (int i = 0; i < AnomalySnapshot::CHANNELS; ++i)
+            {
+                const AnomalyChannelState& channel = anomalies.channels[i];
+                Json::Value& entry = response["anomaly"][AnomalyDetector::ChannelName(static_cast<AnomalyChannel>(i))];
+                entry["baseline"] = channel.mean;
+                entry["sigma"] = channel.sigma;
+                entry["ready"] = channel.ready;
+                entry["anomalies"] = static_cast<Json::UInt64>(channel.anomalies);
+            }
+            response["anomaly"]["hour_mean"] = anomalies.hourMean;
+            if (anomalies.hourExpected > 0.0f)
+                response["anomaly"]["hour_expected"] = anomalies.hourExpected;
+            if (anomalies.lastAnomalyAt > 0)
+                response["anomaly"]["last_anomaly_at"] = static_cast<Json::UInt64>(anomalies.lastAnomalyAt);
         }
         else if (url == "/health")
         {
@@ -211,7 +388,8 @@ int HTTPServer::ProcessRequest(struct MHD_Connection* connection, const std::str
         responseCode = 405;
     }
     
-    responseStr = response.toStyledString();
+    if (responseStr.empty())
+        responseStr = response.toStyledString();
     
     LogRequest(clientIP, method, url, responseCode);
     
@@ -220,39 +398,36 @@ int HTTPServer::ProcessRequest(struct MHD_Connection* connection, const std::str
         (void*)responseStr.c_str(),
         MHD_RESPMEM_MUST_COPY);
     
-    MHD_add_response_header(mhdResponse, "Content-Type", "application/json");
+    MHD_add_response_header(mhdResponse, "Content-Type", contentType.c_str());
     MHD_add_response_header(mhdResponse, "Access-Control-Allow-Origin", "*");
     MHD_add_response_header(mhdResponse, "Access-Control-Allow-Methods", "GET, OPTIONS");
     MHD_add_response_header(mhdResponse, "Access-Control-Allow-Headers", "Content-Type, X-API-Key");
     
     ret = MHD_queue_response(connection, responseCode, mhdResponse);
     MHD_destroy_response(mhdResponse);
-#endif
     return ret;
 }
 
 bool HTTPServer::CheckAuthentication(struct MHD_Connection* connection)
 {
-    ConfigManager& config = ConfigManager::GetInstance();
-    bool enableAuth = config.GetBool("security.enable_auth", false);
+    static const ConfigHandle<bool> enableAuth("security.enable_auth", false);
     
-    if (!enableAuth || apiKeys.empty())
+    std::shared_ptr<const APIKeyMap> keys = std::atomic_load(&apiKeys);
+    
+    if (!enableAuth.Get() || keys->empty())
         return true;
     
     const char* apiKey = nullptr;
-#ifdef RASPBERRY_PI
     apiKey = MHD_lookup_connection_value(connection, MHD_HEADER_KIND, "X-API-Key");
-#endif
-
+    
     if (!apiKey)
         return false;
     
-    return apiKeys.find(apiKey) != apiKeys.end();
+    return keys->find(apiKey) != keys->end();
 }
 
 std::string HTTPServer::GetClientIP(struct MHD_Connection* connection)
 {
-#ifdef RASPBERRY_PI
     const union MHD_ConnectionInfo* info = MHD_get_connection_info(connection, MHD_CONNECTION_INFO_CLIENT_ADDRESS);
     
     if (info && info->client_addr)
@@ -270,10 +445,9 @@ std::string HTTPServer::GetClientIP(struct MHD_Connection* connection)
         }
         else
             return "unknown";
-
+        
         return std::string(buffer);
     }
-#endif    
     return "unknown";
 }
 
@@ -282,21 +456,57 @@ void HTTPServer::LogRequest(const std::string& clientIP,
                           const std::string& url, 
                           int responseCode)
 {
-    LOG_INFO("[" + clientIP + "] " + method + " " + url + " -> " + std::to_string(responseCode));
+    HTTPMetrics::Get().Response(responseCode).Add();
+    LOG_INFOF("[{}] {} {} -> {}", clientIP, method, url, responseCode);
 }
 
 void HTTPServer::AddAPIKey(const std::string& key, const std::string& clientName)
 {
     if (!key.empty())
     {
-        apiKeys[key] = clientName.empty() ? "unnamed_client" : clientName;
-        LOG_INFO("Added API key for client: " + apiKeys[key]);
+        std::lock_guard<std::mutex> lock(apiKeysMutex);
+        manualKeys[key] = clientName.empty() ? "unnamed_client" : clientName;
+        PublishAPIKeysLocked();
+        LOG_INFO("Added API key for client: " + manualKeys[key]);
+    }
+}
+
+void HTTPServer::SetConfigAPIKeys(const std::string& keyList)
+{
+    APIKeyMap keys;
+    size_t start = 0;
+    while (start <= keyList.size())
+    {
+        size_t end = keyList.find(',', start);
+        if (end == std::string::npos)
+            end = keyList.size();
+        
+        std::string entry = keyList.substr(start, end - start);
+        size_t colon = entry.find(':');
+        std::string key = entry.substr(0, colon);
+        std::string clientName = colon == std::string::npos ? "" : entry.substr(colon + 1);
+        if (!key.empty())
+            keys[key] = clientName.empty() ? "config_client" : clientName;
+        
+        start = end + 1;
     }
+    
+    std::lock_guard<std::mutex> lock(apiKeysMutex);
+    configKeys = std::move(keys);
+    PublishAPIKeysLocked();
+    LOG_INFO("API keys from config: " + std::to_string(configKeys.size()));
+}
+
+void HTTPServer::PublishAPIKeysLocked()
+{
+    auto keys = std::make_shared<APIKeyMap>(configKeys);
+    for (const auto& pair : manualKeys)
+        (*keys)[pair.first] = pair.second;
+    std::atomic_store(&apiKeys, std::shared_ptr<const APIKeyMap>(std::move(keys)));
 }
 
 std::string HTTPServer::handlePowerRequest()
 {
-#ifdef RASPBERRY_PI
     Json::Value response;
     try
     {
@@ -326,14 +536,126 @@ std::string HTTPServer::handlePowerRequest()
     
     Json::StreamWriterBuilder builder;
     return Json::writeString(builder, response);
-#else
-    return "";
-#endif
+}
+
+std::string HTTPServer::handleAppliancesRequest()
+{
+    ApplianceSnapshot snapshot = sensorManager.getAppliances();
+    
+    Json::Value response;
+    response["status"] = "success";
+    response["baseline_power"] = snapshot.baseline;
+    response["edges"] = static_cast<Json::UInt64>(snapshot.edges);
+    response["unmatched"] = static_cast<Json::UInt64>(snapshot.unmatched);
+    
+    response["appliances"] = Json::Value(Json::arrayValue);
+    for (int i = 0; i < snapshot.applianceCount; ++i)
+    {
+        const ApplianceState& state = snapshot.appliances[i];
+        Json::Value item;
+        item["name"] = state.name;
+        item["on"] = state.on;
+        item["power"] = state.power;
+        item["reactive_power"] = state.reactive;
+        item["trained"] = state.trained;
+        item["activations"] = state.activations;
+        item["changed_at"] = static_cast<Json::UInt64>(state.changedAt);
+        response["appliances"].append(item);
+    }
+    
+    // Последние скачки, от новых к старым
+    response["events"] = Json::Value(Json::arrayValue);
+    for (int i = 1; i <= snapshot.eventCount; ++i)
+    {
+        const ApplianceEvent& event = snapshot.events[(snapshot.nextEvent - i + ApplianceSnapshot::MAX_EVENTS) %
+                                                     ApplianceSnapshot::MAX_EVENTS];
+        Json::Value item;
+        item["appliance"] = event.appliance >= 0 ? Json::Value(snapshot.appliances[event.appliance].name) : Json::Value();
+        item["on"] = event.on;
+        item["delta_power"] = event.deltaPower;
+        item["delta_reactive"] = event.deltaReactive;
+        item["timestamp"] = static_cast<Json::UInt64>(event.timestamp);
+        response["events"].append(item);
+    }
+    
+    Json::StreamWriterBuilder builder;
+    return Json::writeString(builder, response);
+}
+
+std::string HTTPServer::handlePowerQualityRequest(struct MHD_Connection* connection)
+{
+    PQSnapshot snapshot = sensorManager.getPowerQuality();
+    
+    // ?since=<мс> - только события, начавшиеся позже; ?type=sag|swell|interruption|frequency
+    const char* sinceArg = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "since");
+    const char* typeArg = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "type");
+    uint64_t since = sinceArg ? std::strtoull(sinceArg, nullptr, 10) : 0;
+    std::string type = typeArg ? typeArg : "";
+    
+    auto eventJson = [](const PQEvent& event) {
+        Json::Value item;
+        item["type"] = PowerQualityMonitor::EventTypeName(event.type);
+        item["start"] = static_cast<Json::UInt64>(event.start);
+        item["duration_ms"] = event.durationMs;
+        item["extreme"] = event.extreme;
+        return item;
+    };
+    auto windowJson = [](const PQAggregate& window, bool withThd) {
+        Json::Value item;
+        item["voltage"] = window.voltage;
+        if (window.frequency > 0.0f)
+            item["frequency"] = window.frequency;
+        if (withThd)
+        {
+            item["voltage_thd"] = window.voltageThd;
+            item["current_thd"] = window.currentThd;
+        }
+        item["timestamp"] = static_cast<Json::UInt64>(window.timestamp);
+        return item;
+    };
+    
+    Json::Value response;
+    response["status"] = "success";
+    response["waveform"] = snapshot.waveform;
+    response["short_window"] = windowJson(snapshot.shortWindow, snapshot.waveform);
+    response["long_window"] = windowJson(snapshot.longWindow, snapshot.waveform);
+    
+    if (snapshot.waveform)
+    {
+        response["harmonics"]["voltage_fundamental"] = snapshot.voltageHarmonics[0];
+        response["harmonics"]["current_fundamental"] = snapshot.currentHarmonics[0];
+        for (int h = 1; h < PQSnapshot::MAX_HARMONIC; ++h)
+        {
+            response["harmonics"]["voltage"].append(snapshot.voltageHarmonics[h]);
+            response["harmonics"]["current"].append(snapshot.currentHarmonics[h]);
+        }
+    }
+    
+    response["active"] = Json::Value(Json::arrayValue);
+    if (snapshot.voltageActive)
+        response["active"].append(eventJson(snapshot.voltageEvent));
+    if (snapshot.frequencyActive)
+        response["active"].append(eventJson(snapshot.frequencyEvent));
+    
+    // Завершённые события, от новых к старым
+    response["total_events"] = static_cast<Json::UInt64>(snapshot.totalEvents);
+    response["events"] = Json::Value(Json::arrayValue);
+    for (int i = 1; i <= snapshot.eventCount; ++i)
+    {
+        const PQEvent& event = snapshot.events[(snapshot.nextEvent - i + PQSnapshot::MAX_EVENTS) % PQSnapshot::MAX_EVENTS];
+        if (event.start <= since)
+            break;
+        if (!type.empty() && type != PowerQualityMonitor::EventTypeName(event.type))
+            continue;
+        response["events"].append(eventJson(event));
+    }
+    
+    Json::StreamWriterBuilder builder;
+    return Json::writeString(builder, response);
 }
 
 std::string HTTPServer::handleEnergyRequest()
 {
-#ifdef RASPBERRY_PI
     Json::Value response;
     try
     {
@@ -343,6 +665,7 @@ std::string HTTPServer::handleEnergyRequest()
         response["data"]["energy"] = latest.energy;
         response["data"]["cost"] = latest.cost;
         response["data"]["timestamp"] = static_cast<Json::Int64>(latest.timestamp);
+        response["data"]["energy_total_kwh"] = statistics.getTotalEnergyKWh();
         
         auto today = statistics.getTodayStats();
         auto week = statistics.getWeekStats();
@@ -363,6 +686,23 @@ std::string HTTPServer::handleEnergyRequest()
             monthJson[pair.first] = pair.second;
         response["stats"]["month"] = monthJson;
         
+        EnergyForecast forecast = statistics.getForecast();
+        for (int i = 0; i < EnergyForecast::PERIODS; ++i)
+        {
+            const PeriodForecast& period = forecast.periods[i];
+            Json::Value periodJson;
+            periodJson["start"] = static_cast<Json::Int64>(period.start);
+            periodJson["end"] = static_cast<Json::Int64>(period.end);
+            periodJson["energy"] = period.energy;
+            periodJson["cost"] = period.cost;
+            periodJson["projected_energy"] = period.projectedEnergy;
+            periodJson["projected_cost"] = period.projectedCost;
+            response["forecast"][EnergyForecaster::PeriodName(static_cast<ForecastPeriod>(i))] = periodJson;
+        }
+        response["forecast"]["hour_energy"] = forecast.hourEnergy;
+        response["forecast"]["average_power"] = forecast.averagePower;
+        response["forecast"]["hours_observed"] = forecast.hoursObserved;
+        
         float totalEnergy = today["energy_total"];
         response["environment"]["co2_kg"] = statistics.calculateCO2Emissions(totalEnergy);
         
@@ -375,14 +715,10 @@ std::string HTTPServer::handleEnergyRequest()
     
     Json::StreamWriterBuilder builder;
     return Json::writeString(builder, response);
-#else
-    return "";
-#endif
 }
 
 std::string HTTPServer::handleStatsRequest(const std::string& period)
 {
-#ifdef RASPBERRY_PI
     Json::Value response; 
     try
     {
@@ -428,7 +764,238 @@ std::string HTTPServer::handleStatsRequest(const std::string& period)
     
     Json::StreamWriterBuilder builder;
     return Json::writeString(builder, response);
-#else
-    return "";
-#endif
-}
\ No newline at end of file
+}
+
+std::string HTTPServer::handleSensorConfigRequest()
+{
+    static const char* const SENSOR_TYPES[] = {"none", "i2c", "analog", "pzem", "simulation", "replay"};
+    
+    const SensorConfig& config = sensorManager.getConfig();
+    size_t type = static_cast<size_t>(config.type);
+    
+    Json::Value response;
+    response["status"] = "success";
+    response["data"]["name"] = config.name;
+    response["data"]["type"] = type < sizeof(SENSOR_TYPES) / sizeof(SENSOR_TYPES[0]) ? SENSOR_TYPES[type] : "unknown";
+    response["data"]["bus"] = config.bus;
+    response["data"]["address"] = config.address;
+    response["data"]["calibration"] = config.calibration;
+    response["data"]["enabled"] = config.enabled;
+    response["data"]["state"] = sensorManager.getSensorStatus();
+    response["data"]["sample_rate_hz"] = sensorManager.getCurrentSampleRate();
+    
+    Json::StreamWriterBuilder builder;
+    return Json::writeString(builder, response);
+}
+
+std::string HTTPServer::handleCalibrationRequest(const std::string& params)
+{
+    // /calibrate/<эталонная мощность, Вт>
+    Json::Value response;
+    std::string value = params.size() > 11 && params.compare(0, 11, "/calibrate/") == 0 ? params.substr(11) : "";
+    
+    char* end = nullptr;
+    float reference = value.empty() ? 0.0f : std::strtof(value.c_str(), &end);
+    if (value.empty() || end != value.c_str() + value.size() || !(reference > 0.0f))
+    {
+        response["status"] = "error";
+        response["message"] = "Usage: /calibrate/<reference watts>, reference must be positive";
+    }
+    else
+    {
+        sensorManager.calibrate(reference);
+        response["status"] = "success";
+        response["reference"] = reference;
+    }
+    
+    Json::StreamWriterBuilder builder;
+    return Json::writeString(builder, response);
+}
+
+std::string HTTPServer::handleHistoryRequest(struct MHD_Connection* connection,
+                                             std::string& contentType, int& responseCode)
+{
+    auto argument = [connection](const char* name) -> const char* {
+        return MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, name);
+    };
+    
+    uint64_t now = static_cast<uint64_t>(std::time(nullptr));
+    const char* toArg = argument("to");
+    const char* fromArg = argument("from");
+    const char* stepArg = argument("step");
+    const char* formatArg = argument("format");
+    
+    uint64_t to = now;
+    uint64_t from = 0;
+    uint64_t step = 60;
+    bool parsed = (!toArg || ParseUnsigned(toArg, to)) &&
+                  (!fromArg || ParseUnsigned(fromArg, from)) &&
+                  (!stepArg || ParseUnsigned(stepArg, step));
+    if (!fromArg)
+        from = to > 86400 ? to - 86400 : 0;
+    std::string format = formatArg ? formatArg : "json";
+    
+    // Неполный последний интервал - тоже корзина; (to - from - 1) / step + 1 без переполнения
+    if (!parsed || step == 0 || to <= from || (to - from - 1) / step + 1 > HISTORY_MAX_BUCKETS)
+    {
+        Json::Value response;
+        response["status"] = "error";
+        response["message"] = "Invalid range: require unsigned integers, from < to, step > 0 and at most " +
+                              std::to_string(HISTORY_MAX_BUCKETS) + " buckets";
+        responseCode = 400;
+        Json::StreamWriterBuilder builder;
+        return Json::writeString(builder, response);
+    }
+    
+    std::string out;
+    
+    if (format == "csv")
+    {
+        contentType = "text/csv";
+        out = "timestamp,energy,cost,samples\n";
+        statistics.forEachHistoryBucket(from, to, step, [&out](const HistoryBucket& bucket) {
+            AppendNumber(out, bucket.timestamp);
+            out += ',';
+            AppendNumber(out, bucket.energy);
+            out += ',';
+            AppendNumber(out, bucket.cost);
+            out += ',';
+            AppendNumber(out, bucket.samples);
+            out += '\n';
+        });
+    }
+    else if (format == "bin")
+    {
+        // "SPH1", u32 count, u64 from, u64 step, затем колонки:
+        // u64 timestamp[count], f32 energy[count], f32 cost[count], u32 samples[count]
+        contentType = "application/octet-stream";
+        std::string timestamps, energy, cost, samples;
+        uint32_t count = static_cast<uint32_t>(statistics.forEachHistoryBucket(from, to, step,
+            [&](const HistoryBucket& bucket) {
+                AppendRaw(timestamps, bucket.timestamp);
+                AppendRaw(energy, bucket.energy);
+                AppendRaw(cost, bucket.cost);
+                AppendRaw(samples, bucket.samples);
+            }));
+        
+        out.reserve(24 + timestamps.size() + energy.size() + cost.size() + samples.size());
+        out.append("SPH1", 4);
+        AppendRaw(out, count);
+        AppendRaw(out, from);
+        AppendRaw(out, step);
+        out += timestamps;
+        out += energy;
+        out += cost;
+        out += samples;
+    }
+    else
+    {
+        std::string timestamps, energy, cost, samples;
+        size_t count = statistics.forEachHistoryBucket(from, to, step, [&](const HistoryBucket& bucket) {
+            if (!timestamps.empty())
+            {
+                timestamps += ',';
+                energy += ',';
+                cost += ',';
+                samples += ',';
+            }
+            AppendNumber(timestamps, bucket.timestamp);
+            AppendNumber(energy, bucket.energy);
+            AppendNumber(cost, bucket.cost);
+            AppendNumber(samples, bucket.samples);
+        });
+        
+        out = "{\"status\":\"success\",\"from\":";
+        AppendNumber(out, from);
+        out += ",\"to\":";
+        AppendNumber(out, to);
+        out += ",\"step\":";
+        AppendNumber(out, step);
+        out += ",\"count\":";
+        AppendNumber(out, count);
+        out += ",\"timestamp\":[" + timestamps + "],\"energy\":[" + energy +
+               "],\"cost\":[" + cost + "],\"samples\":[" + samples + "]}";
+    }
+    
+    return out;
+}
+
+int HTTPServer::handleExportRequest(struct MHD_Connection* connection, const std::string& clientIP)
+{
+    int ret = 0;
+    const char* daysArg = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "days");
+    const char* formatArg = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "format");
+    
+    int days = daysArg ? std::atoi(daysArg) : 30;
+    bool binary = formatArg && std::strcmp(formatArg, "bin") == 0;
+    
+    // Выгрузка - фоновая работа: при перегреве клиент повторит позже
+    if (sensorManager.shouldDeferBackgroundWork())
+    {
+        static const char busy[] = "{\"status\":\"error\",\"message\":\"Device is busy, retry later\"}";
+        struct MHD_Response* mhdResponse = MHD_create_response_from_buffer(
+            sizeof(busy) - 1, (void*)busy, MHD_RESPMEM_PERSISTENT);
+        MHD_add_response_header(mhdResponse, "Content-Type", "application/json");
+        MHD_add_response_header(mhdResponse, "Retry-After", "60");
+        LogRequest(clientIP, "GET", "/export", 503);
+        ret = MHD_queue_response(connection, 503, mhdResponse);
+        MHD_destroy_response(mhdResponse);
+        return ret;
+    }
+    
+    // Снимок берётся под коротким локом, дальше MHD вычитывает его чанками
+    StatisticsExport* exporter = statistics.createExport(days,
+        binary ? StatisticsExport::FORMAT_BINARY : StatisticsExport::FORMAT_CSV).release();
+    
+    struct MHD_Response* mhdResponse = MHD_create_response_from_callback(
+        MHD_SIZE_UNKNOWN,
+        EXPORT_CHUNK_SIZE,
+        [](void* cls, uint64_t, char* buffer, size_t max) -> ssize_t {
+            size_t count = static_cast<StatisticsExport*>(cls)->read(buffer, max);
+            return count > 0 ? static_cast<ssize_t>(count) : MHD_CONTENT_READER_END_OF_STREAM;
+        },
+        exporter,
+        [](void* cls) { delete static_cast<StatisticsExport*>(cls); });
+    
+    if (!mhdResponse)
+    {
+        delete exporter;
+        LogRequest(clientIP, "GET", "/export", 500);
+        return MHD_NO;
+    }
+    
+    MHD_add_response_header(mhdResponse, "Content-Type", binary ? "application/octet-stream" : "text/csv");
+    MHD_add_response_header(mhdResponse, "Content-Disposition",
+                            binary ? "attachment; filename=\"stats.bin\"" : "attachment; filename=\"stats.csv\"");
+    MHD_add_response_header(mhdResponse, "Access-Control-Allow-Origin", "*");
+    
+    LogRequest(clientIP, "GET", "/export", 200);
+    ret = MHD_queue_response(connection, 200, mhdResponse);
+    MHD_destroy_response(mhdResponse);
+    return ret;
+}
+
+int HTTPServer::handleMetricsRequest(struct MHD_Connection* connection, const std::string& clientIP)
+{
+    int ret = 0;
+    // Буфер потока растёт только при появлении новых рядов, дальше рендер без выделений
+    static thread_local std::vector<char> buffer(16 * 1024);
+    
+    MetricsRegistry& registry = MetricsRegistry::GetInstance();
+    size_t size = registry.Render(buffer.data(), buffer.size());
+    while (size > buffer.size())
+    {
+        buffer.resize(size + size / 2);
+        size = registry.Render(buffer.data(), buffer.size());
+    }
+    
+    struct MHD_Response* mhdResponse = MHD_create_response_from_buffer(
+        size, buffer.data(), MHD_RESPMEM_MUST_COPY);
+    
+    MHD_add_response_header(mhdResponse, "Content-Type", "text/plain; version=0.0.4; charset=utf-8");
+    
+    LogRequest(clientIP, "GET", "/metrics", 200);
+    ret = MHD_queue_response(connection, 200, mhdResponse);
+    MHD_destroy_response(mhdResponse);
+    return ret;
+}
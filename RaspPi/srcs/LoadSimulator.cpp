@@ -0,0 +1,213 @@
+#include "../includes/LoadSimulator.h"
+#include "../includes/ConfigManager.h"
+#include "../includes/Logger.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+namespace
+{
+    constexpr double TWO_PI = 6.283185307179586;
+    constexpr double SQRT2 = 1.4142135623730951;
+    
+    bool SetParameter(ApplianceModel& model, const std::string& name, float value)
+    {
+        if (name == "power") model.power = value;
+        else if (name == "pf") model.powerFactor = std::clamp(value, 0.05f, 1.0f);
+        else if (name == "on") model.onSeconds = value;
+        else if (name == "off") model.offSeconds = value;
+        else if (name == "phase") model.phaseSeconds = value;
+        else if (name == "ramp") model.rampSeconds = value;
+        else if (name == "inrush") model.inrushFactor = std::max(1.0f, value);
+        else if (name == "inrush_ms") model.inrushMs = value;
+        else if (name == "h3") model.thirdHarmonic = value;
+        else if (name == "h5") model.fifthHarmonic = value;
+        else if (name == "noise") model.noise = value;
+        else return false;
+        return true;
+    }
+}
+
+bool LoadSimulator::LoadProfile(const std::string& path)
+{
+    std::map<std::string, std::string> data;
+    if (!ConfigManager::ParseConfigFile(path, data))
+    {
+        LOG_ERROR("Failed to read load profile: " + path);
+        return false;
+    }
+    
+    // Ключи отсортированы, поэтому параметры одного прибора идут подряд
+    std::vector<ApplianceModel> models;
+    for (const auto& [key, text] : data)
+    {
+        if (key.compare(0, 10, "appliance.") != 0)
+            continue;
+        
+        size_t dot = key.find('.', 10);
+        if (dot == std::string::npos)
+            continue;
+        
+        std::string name = key.substr(10, dot - 10);
+        if (models.empty() || models.back().name != name)
+        {
+            models.emplace_back();
+            models.back().name = name;
+        }
+        
+        ConfigValue value = ConfigValue::Parse(text);
+        if (!(value.isInt || value.isFloat) || !SetParameter(models.back(), key.substr(dot + 1), value.floatValue))
+            LOG_WARNING("Ignoring load profile key " + key + " = " + text);
+    }
+    
+    std::lock_guard<std::mutex> lock(simulatorMutex);
+    appliances = std::move(models);
+    auto base = data.find("base_load");
+    if (base != data.end())
+        baseLoad = std::max(0.0f, ConfigValue::Parse(base->second).floatValue);
+    LOG_INFO("Load profile " + path + ": " + std::to_string(appliances.size()) + " appliances");
+    return true;
+}
+
+void LoadSimulator::AddAppliance(const ApplianceModel& model)
+{
+    std::lock_guard<std::mutex> lock(simulatorMutex);
+    appliances.push_back(model);
+}
+
+void LoadSimulator::ClearAppliances()
+{
+    std::lock_guard<std::mutex> lock(simulatorMutex);
+    appliances.clear();
+}
+
+size_t LoadSimulator::GetApplianceCount() const
+{
+    std::lock_guard<std::mutex> lock(simulatorMutex);
+    return appliances.size();
+}
+
+void LoadSimulator::Seed(uint32_t seed)
+{
+    std::lock_guard<std::mutex> lock(simulatorMutex);
+    rng.seed(seed);
+}
+
+void LoadSimulator::SetBaseLoad(float power)
+{
+    std::lock_guard<std::mutex> lock(simulatorMutex);
+    baseLoad = std::max(0.0f, power);
+}
+
+void LoadSimulator::AddSpike(float power, int durationMs, int64_t nowNs)
+{
+    std::lock_guard<std::mutex> lock(simulatorMutex);
+    spikes.push_back({power, nowNs + static_cast<int64_t>(std::max(0, durationMs)) * 1000000});
+}
+
+float LoadSimulator::ApplianceFactor(const ApplianceModel& model, double seconds) const
+{
+    double sinceOn = seconds + model.phaseSeconds;
+    if (model.onSeconds > 0)
+    {
+        double period = model.onSeconds + model.offSeconds;
+        sinceOn = std::fmod(sinceOn, period);
+        if (sinceOn < 0)
+            sinceOn += period;
+        if (sinceOn >= model.onSeconds)
+            return 0.0f;
+    }
+    else if (sinceOn < 0)
+        return 0.0f;
+    
+    double factor = 1.0;
+    if (model.rampSeconds > 0 && sinceOn < model.rampSeconds)
+        factor = sinceOn / model.rampSeconds;
+    if (model.inrushFactor > 1.0f && model.inrushMs > 0)
+        factor *= 1.0 + (model.inrushFactor - 1.0) * std::exp(-sinceOn * 1000.0 / model.inrushMs);
+    
+    return static_cast<float>(factor);
+}
+
+LoadSample LoadSimulator::Sample(int64_t nowNs)
+{
+    std::lock_guard<std::mutex> lock(simulatorMutex);
+    
+    if (startNs < 0)
+        startNs = nowNs;
+    double seconds = static_cast<double>(nowNs - startNs) / 1e9;
+    
+    std::normal_distribution<float> noiseDist(0.0f, 1.0f);
+    double power = baseLoad;
+    double reactive = 0.0;
+    double distortion = 0.0;
+    
+    for (const ApplianceModel& model : appliances)
+    {
+        float factor = ApplianceFactor(model, seconds);
+        if (factor <= 0.0f)
+            continue;
+        
+        double active = model.power * factor;
+        if (model.noise > 0)
+            active = std::max(0.0, active * (1.0 + model.noise * noiseDist(rng)));
+        
+        double fundamental = active / model.powerFactor;
+        power += active;
+        reactive += std::sqrt(std::max(0.0, fundamental * fundamental - active * active));
+        distortion += fundamental * std::sqrt(model.thirdHarmonic * model.thirdHarmonic +
+                                              model.fifthHarmonic * model.fifthHarmonic);
+    }
+    
+    spikes.erase(std::remove_if(spikes.begin(), spikes.end(),
+                                [nowNs](const Spike& spike) { return spike.endNs <= nowNs; }),
+                 spikes.end());
+    for (const Spike& spike : spikes)
+        power += spike.power;
+    
+    LoadSample sample;
+    sample.power = static_cast<float>(power);
+    sample.reactive = static_cast<float>(reactive);
+    sample.apparent = static_cast<float>(std::sqrt(power * power + reactive * reactive + distortion * distortion));
+    sample.current = sample.apparent / NOMINAL_VOLTAGE;
+    return sample;
+}
+
+void LoadSimulator::FillWaveform(int64_t startTimeNs, double sampleRateHz, size_t count, float* voltage, float* current,
+                                 float voltageRms)
+{
+    std::lock_guard<std::mutex> lock(simulatorMutex);
+    
+    if (startNs < 0)
+        startNs = startTimeNs;
+    
+    const double omega = TWO_PI * NOMINAL_FREQUENCY;
+    const double voltagePeak = SQRT2 * voltageRms;
+    double resistive = baseLoad;
+    for (const Spike& spike : spikes)
+        if (spike.endNs > startTimeNs)
+            resistive += spike.power;
+    
+    for (size_t i = 0; i < count; ++i)
+    {
+        double t = static_cast<double>(startTimeNs - startNs) / 1e9 + static_cast<double>(i) / sampleRateHz;
+        double angle = omega * t;
+        
+        double instantCurrent = SQRT2 * resistive / NOMINAL_VOLTAGE * std::sin(angle);
+        for (const ApplianceModel& model : appliances)
+        {
+            float factor = ApplianceFactor(model, t);
+            if (factor <= 0.0f)
+                continue;
+            
+            double peak = SQRT2 * model.power * factor / model.powerFactor / NOMINAL_VOLTAGE;
+            instantCurrent += peak * (std::sin(angle - std::acos(model.powerFactor)) +
+                                      model.thirdHarmonic * std::sin(3.0 * angle) +
+                                      model.fifthHarmonic * std::sin(5.0 * angle));
+        }
+        
+        voltage[i] = static_cast<float>(voltagePeak * std::sin(angle));
+        current[i] = static_cast<float>(instantCurrent);
+    }
+}
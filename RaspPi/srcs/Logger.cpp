@@ -1,6 +1,22 @@
-#include "..\includes\Logger.h"
+#include "../includes/Logger.h"
+#include "../includes/Metrics.h"
+
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <algorithm>
+#include <vector>
+#include <spawn.h>
+#include <sys/wait.h>
+
+extern char** environ;
+
+// Как часто писатель заново спрашивает, можно ли сжимать отложенные файлы
+static constexpr auto DEFERRED_RETRY_INTERVAL = std::chrono::seconds(30);
 
 Logger* Logger::m_Instance = nullptr;
+std::atomic<LogLevel> Logger::m_CurrentLevel {LogLevel::INFO};
+std::atomic<bool> Logger::m_ReopenRequested {false};
 
 Logger& Logger::GetInstance()
 {
@@ -13,6 +29,8 @@ Logger& Logger::GetInstance()
 
 Logger::~Logger()
 {
+    DisableAsyncMode();
+    m_BinarySink.Close();
     if (m_LogFile.is_open())
         m_LogFile.close();
 }
@@ -49,8 +67,7 @@ std::string Logger::LevelToString(LogLevel level)
 
 void Logger::SetLogLevel(LogLevel level)
 {
-    std::lock_guard<std::mutex> lock(m_Mutex);
-    m_CurrentLevel = level;
+    m_CurrentLevel.store(level, std::memory_order_relaxed);
 }
 
 void Logger::EnableConsoleOutput(bool enable)
@@ -65,11 +82,8 @@ void Logger::EnableFileOutput(bool enable, const std::string& filename)
     
     if (enable && !filename.empty())
     {
-        if (m_LogFile.is_open())
-            m_LogFile.close();
-
-        m_LogFile.open(filename, std::ios::app);
-        m_WriteToFile = m_LogFile.is_open();
+        m_LogFileName = filename;
+        OpenLogFileLocked();
         if (!m_WriteToFile)
             std::cerr << "Failed to open log file: " << filename << std::endl;
     }
@@ -81,9 +95,246 @@ void Logger::EnableFileOutput(bool enable, const std::string& filename)
     }
 }
 
-void Logger::Log(LogLevel level, const std::string& message, const std::string& function, int line)
+void Logger::SetRotation(const LogRotationConfig& config)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Rotation = config;
+}
+
+void Logger::SetBackgroundWorkGate(std::function<bool()> shouldDefer)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_DeferBackgroundWork = std::move(shouldDefer);
+}
+
+void Logger::OpenLogFileLocked()
+{
+    if (m_LogFile.is_open())
+        m_LogFile.close();
+    
+    m_LogFile.clear();
+    m_LogFile.open(m_LogFileName, std::ios::app);
+    m_WriteToFile = m_LogFile.is_open();
+    
+    std::error_code error;
+    auto size = std::filesystem::file_size(m_LogFileName, error);
+    m_FileBytes = error ? 0 : size;
+    m_FileOpenedAt = std::chrono::steady_clock::now();
+}
+
+void Logger::WriteToFileLocked(const char* data, size_t size)
+{
+    if (m_ReopenRequested.exchange(false, std::memory_order_relaxed) && !m_LogFileName.empty())
+        OpenLogFileLocked();
+    
+    if (!m_WriteToFile || !m_LogFile.is_open())
+        return;
+    
+    bool sizeExceeded = m_Rotation.maxBytes > 0 && m_FileBytes + size > m_Rotation.maxBytes && m_FileBytes > 0;
+    bool ageExceeded = m_Rotation.maxAgeSeconds > 0 && m_FileBytes > 0 &&
+        std::chrono::steady_clock::now() - m_FileOpenedAt >= std::chrono::seconds(m_Rotation.maxAgeSeconds);
+    if (sizeExceeded || ageExceeded)
+        RotateLocked();
+    else if (!m_PendingRotated.empty() && std::chrono::steady_clock::now() >= m_DeferredCheckAt)
+        StartBackgroundWorkLocked();
+    
+    m_LogFile.write(data, static_cast<std::streamsize>(size));
+    m_FileBytes += size;
+}
+
+void Logger::RotateLocked()
+{
+    m_LogFile.close();
+    
+    std::time_t now = std::time(nullptr);
+    std::tm local {};
+    localtime_r(&now, &local);
+    char suffix[32];
+    std::strftime(suffix, sizeof(suffix), ".%Y%m%d-%H%M%S", &local);
+    
+    std::string rotated = m_LogFileName + suffix;
+    for (int i = 1; std::filesystem::exists(rotated) || std::filesystem::exists(rotated + ".gz"); i++)
+        rotated = m_LogFileName + suffix + "-" + std::to_string(i);
+    
+    std::error_code error;
+    std::filesystem::rename(m_LogFileName, rotated, error);
+    OpenLogFileLocked();
+    
+    if (error)
+    {
+        // Следующая попытка - после ещё maxBytes или maxAgeSeconds, а не на каждой строке
+        m_FileBytes = 0;
+        if (m_RotationFailed)
+            return;
+        
+        // LOG_ERROR здесь нельзя: мьютекс уже взят, а писатель не может ждать сам себя
+        m_RotationFailed = true;
+        std::string entry = "[" + GetCurrentTime() + "] [ERROR] [" + __FUNCTION__ + ":" +
+            std::to_string(__LINE__) + "] Log rotation failed, keep writing to " + m_LogFileName +
+            ": " + error.message() + "\n";
+        if (m_WriteToConsole)
+            std::cout << entry << std::flush;
+        if (m_LogFile.is_open())
+        {
+            m_LogFile << entry;
+            m_FileBytes += entry.size();
+        }
+        return;
+    }
+    
+    m_RotationFailed = false;
+    m_PendingRotated.push_back(rotated);
+    StartBackgroundWorkLocked();
+}
+
+void Logger::StartBackgroundWorkLocked()
+{
+    // Перегретому процессору gzip не нужен: файлы полежат несжатыми
+    if (m_DeferBackgroundWork && m_DeferBackgroundWork())
+    {
+        m_DeferredCheckAt = std::chrono::steady_clock::now() + DEFERRED_RETRY_INTERVAL;
+        return;
+    }
+    
+    // Сжатие и удаление старых файлов не задерживают писателя
+    std::thread(&Logger::CompressAndPrune, std::move(m_PendingRotated), m_LogFileName,
+                m_Rotation.compress, m_Rotation.keepFiles).detach();
+    m_PendingRotated.clear();
+}
+
+// Только имена, которые даёт RotateLocked: <base>.YYYYmmdd-HHMMSS[-N][.gz]
+bool Logger::IsRotatedName(const std::string& name, const std::string& baseName)
+{
+    size_t pos = baseName.size();
+    if (name.compare(0, pos, baseName) != 0 || name.size() < pos + 16 || name[pos] != '.')
+        return false;
+    
+    auto digits = [&name](size_t from, size_t count) {
+        for (size_t i = from; i < from + count; i++)
+            if (name[i] < '0' || name[i] > '9')
+                return false;
+        return true;
+    };
+    if (!digits(pos + 1, 8) || name[pos + 9] != '-' || !digits(pos + 10, 6))
+        return false;
+    
+    std::string rest = name.substr(pos + 16);
+    if (rest.size() >= 3 && rest.compare(rest.size() - 3, 3, ".gz") == 0)
+        rest.resize(rest.size() - 3);
+    if (rest.empty())
+        return true;
+    
+    return rest.size() >= 2 && rest[0] == '-' &&
+        std::all_of(rest.begin() + 1, rest.end(), [](char c) { return c >= '0' && c <= '9'; });
+}
+
+void Logger::CompressAndPrune(std::vector<std::string> rotatedFiles, std::string baseFile, bool compress, int keepFiles)
+{
+    if (compress)
+    {
+        for (std::string& rotatedFile : rotatedFiles)
+        {
+            char gzip[] = "gzip";
+            char force[] = "-f";
+            char* argv[] = {gzip, force, rotatedFile.data(), nullptr};
+            pid_t pid;
+            if (posix_spawnp(&pid, "gzip", nullptr, nullptr, argv, environ) == 0)
+            {
+                int status = 0;
+                waitpid(pid, &status, 0);
+            }
+        }
+    }
+    
+    if (keepFiles <= 0)
+        return;
+    
+    namespace fs = std::filesystem;
+    fs::path base(baseFile);
+    fs::path directory = base.has_parent_path() ? base.parent_path() : fs::path(".");
+    std::string baseName = base.filename().string();
+    
+    std::vector<fs::path> rotated;
+    std::error_code error;
+    for (const auto& entry : fs::directory_iterator(directory, error))
+        if (IsRotatedName(entry.path().filename().string(), baseName))
+            rotated.push_back(entry.path());
+    
+    if (rotated.size() <= static_cast<size_t>(keepFiles))
+        return;
+    
+    std::sort(rotated.begin(), rotated.end(), [](const fs::path& a, const fs::path& b) {
+        std::error_code ignored;
+        return fs::last_write_time(a, ignored) < fs::last_write_time(b, ignored);
+    });
+    for (size_t i = 0; i + keepFiles < rotated.size(); i++)
+        fs::remove(rotated[i], error);
+}
+
+void Logger::EnableBinaryOutput(bool enable, const std::string& filename)
+{
+    if (enable && !filename.empty())
+    {
+        m_WriteBinary = m_BinarySink.Open(filename);
+        return;
+    }
+    
+    m_WriteBinary = false;
+    m_BinarySink.Close();
+}
+
+void Logger::CountRecord(LogLevel level)
+{
+    static MetricsRegistry& metrics = MetricsRegistry::GetInstance();
+    static Counter* counters[] = {
+        &metrics.GetCounter("smart_plug_log_records_total", "Log records by level", "level=\"debug\""),
+        &metrics.GetCounter("smart_plug_log_records_total", "Log records by level", "level=\"info\""),
+        &metrics.GetCounter("smart_plug_log_records_total", "Log records by level", "level=\"warning\""),
+        &metrics.GetCounter("smart_plug_log_records_total", "Log records by level", "level=\"error\"")
+    };
+    counters[static_cast<int>(level)]->Add();
+}
+
+void Logger::Log(LogLevel level, const std::string& message, const char* function, int line)
+{
+    if (!IsEnabled(level))
+        return;
+    
+    Submit(level, &message, function, line, 0, nullptr);
+}
+
+void Logger::Submit(LogLevel level, const std::string* message, const char* function, int line,
+                    uint32_t formatId, const std::string* binaryArgs)
 {
-    if (level < m_CurrentLevel)
+    CountRecord(level);
+    
+    uint64_t monotonicNs = binaryArgs ? BinaryLogSink::Now() : 0;
+    bool flushNow = level >= LogLevel::ERROR;
+    
+    // Аргументы длиннее ячейки очереди пишутся сразу, из вызывающего потока
+    if (binaryArgs && binaryArgs->size() > LogRecord::MAX_ARGS)
+    {
+        m_BinarySink.WriteEncoded(formatId, monotonicNs, flushNow, binaryArgs->data(), binaryArgs->size());
+        binaryArgs = nullptr;
+    }
+    
+    if (!message && !binaryArgs)
+        return;
+    
+    if (m_Async.load(std::memory_order_acquire))
+    {
+        // Пока счётчик не ноль, DisableAsyncMode ждёт и не трогает очередь
+        m_Producers.fetch_add(1);
+        bool queued = m_Async.load() &&
+            EnqueueAsync(level, message, function, line, formatId, monotonicNs, binaryArgs);
+        m_Producers.fetch_sub(1);
+        if (queued)
+            return;
+    }
+    
+    if (binaryArgs)
+        m_BinarySink.WriteEncoded(formatId, monotonicNs, flushNow, binaryArgs->data(), binaryArgs->size());
+    if (!message)
         return;
     
     std::lock_guard<std::mutex> lock(m_Mutex);
@@ -92,38 +343,299 @@ void Logger::Log(LogLevel level, const std::string& message, const std::string&
     logEntry << "[" << GetCurrentTime() << "] "
              << "[" << LevelToString(level) << "] ";
     
-    if (!function.empty())
+    if (function && *function)
         logEntry << "[" << function << ":" << line << "] ";
     
-    logEntry << message;
+    logEntry << *message;
     
     std::string fullMessage = logEntry.str();
     if (m_WriteToConsole)
         std::cout << fullMessage << std::endl;
     
-    if (m_WriteToFile && m_LogFile.is_open())
+    if (m_WriteToFile)
     {
-        m_LogFile << fullMessage << std::endl;
+        fullMessage += '\n';
+        WriteToFileLocked(fullMessage.data(), fullMessage.size());
         m_LogFile.flush();
     }
 }
 
-void Logger::Debug(const std::string& message, const std::string& function, int line)
+void Logger::EnableAsyncMode(const AsyncLogConfig& config)
+{
+    DisableAsyncMode();
+    
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_AsyncConfig = config;
+        m_Overflow.store(config.overflow);
+        m_FlushOnError.store(config.flushOnError);
+        // Писатель остановлен, очередь пуста и без производителей - размер можно сменить
+        m_Queue.reset(new MPSCQueue<LogRecord>(config.queueSize));
+    }
+    
+    m_WriterRunning = true;
+    m_WriterThread = std::thread(&Logger::WriterLoop, this);
+    m_Async.store(true, std::memory_order_release);
+}
+
+void Logger::DisableAsyncMode()
+{
+    if (!m_Async.exchange(false))
+        return;
+    
+    {
+        std::lock_guard<std::mutex> lock(m_WakeMutex);
+        m_WriterRunning = false;
+    }
+    m_WakeCondition.notify_one();
+    
+    if (m_WriterThread.joinable())
+        m_WriterThread.join();
+    
+    while (m_Producers.load() != 0)
+        std::this_thread::yield();
+    DrainQueue();
+}
+
+void Logger::DrainQueue()
+{
+    // Записи, успевшие попасть в очередь после последнего прохода писателя
+    std::string batch;
+    while (LogRecord* record = m_Queue->front())
+    {
+        WriteRecord(*record, batch);
+        m_Queue->pop();
+    }
+    if (!batch.empty())
+        WriteBatch(batch, true);
+}
+
+void Logger::Flush()
+{
+    if (m_Async.load(std::memory_order_acquire))
+    {
+        std::unique_lock<std::mutex> lock(m_WakeMutex);
+        m_FlushRequested = true;
+        m_WakeCondition.notify_one();
+        m_FlushedCondition.wait_for(lock, std::chrono::seconds(1), [this] { return !m_FlushRequested.load(); });
+    }
+    
+    // В асинхронном режиме - для длинных записей, которые шли мимо очереди
+    m_BinarySink.Flush();
+    if (m_Async.load(std::memory_order_acquire))
+        return;
+    
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    std::cout.flush();
+    if (m_LogFile.is_open())
+        m_LogFile.flush();
+}
+
+bool Logger::EnqueueAsync(LogLevel level, const std::string* message, const char* function, int line,
+                          uint32_t formatId, uint64_t monotonicNs, const std::string* binaryArgs)
+{
+    size_t ticket = 0;
+    LogRecord* record = m_Queue->beginPush(ticket);
+    
+    while (!record)
+    {
+        if (m_Overflow.load(std::memory_order_relaxed) == LogOverflowPolicy::DROP)
+        {
+            static Counter& droppedCounter = MetricsRegistry::GetInstance().GetCounter(
+                "smart_plug_log_dropped_total", "Log records dropped because the async queue was full");
+            droppedCounter.Add();
+            m_Dropped.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+        
+        // Писатель остановлен - очередь больше никто не разберёт, пишем синхронно
+        if (!m_WriterRunning.load(std::memory_order_acquire))
+            return false;
+        
+        if (m_WriterIdle.load(std::memory_order_acquire))
+            m_WakeCondition.notify_one();
+        std::this_thread::yield();
+        record = m_Queue->beginPush(ticket);
+    }
+    
+    record->timestampNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    record->monotonicNs = monotonicNs;
+    record->level = level;
+    record->line = line;
+    record->formatId = formatId;
+    size_t functionLength = function ? std::strlen(function) : 0;
+    record->functionLength = static_cast<uint16_t>(std::min(functionLength, LogRecord::MAX_FUNCTION));
+    if (record->functionLength > 0)
+        std::memcpy(record->function, function, record->functionLength);
+    record->text = message != nullptr;
+    record->messageLength = message ? static_cast<uint16_t>(std::min(message->size(), LogRecord::MAX_MESSAGE)) : 0;
+    if (record->messageLength > 0)
+        std::memcpy(record->message, message->data(), record->messageLength);
+    record->argsLength = binaryArgs ? static_cast<uint16_t>(binaryArgs->size()) : 0;
+    if (record->argsLength > 0)
+        std::memcpy(record->args, binaryArgs->data(), record->argsLength);
+    m_Queue->commitPush(ticket);
+    
+    // Будим писателя только если он спит, иначе он сам заберёт запись
+    if (m_WriterIdle.load(std::memory_order_acquire) ||
+        (level >= LogLevel::ERROR && m_FlushOnError.load(std::memory_order_relaxed)))
+        m_WakeCondition.notify_one();
+    
+    return true;
+}
+
+void Logger::WriterLoop()
+{
+    std::string batch;
+    batch.reserve(64 * 1024);
+    
+    size_t unflushed = 0;
+    auto lastFlush = std::chrono::steady_clock::now();
+    auto flushInterval = std::chrono::milliseconds(m_AsyncConfig.flushIntervalMs);
+    
+    for (;;)
+    {
+        size_t count = 0;
+        bool urgent = false;
+        
+        while (LogRecord* record = m_Queue->front())
+        {
+            WriteRecord(*record, batch);
+            urgent |= m_AsyncConfig.flushOnError && record->level >= LogLevel::ERROR;
+            m_Queue->pop();
+            
+            if (++count >= m_AsyncConfig.flushEveryRecords)
+                break;
+        }
+        
+        unflushed += count;
+        bool stopping = !m_WriterRunning.load() && m_Queue->empty();
+        bool flushRequested = m_FlushRequested.load() && m_Queue->empty();
+        auto now = std::chrono::steady_clock::now();
+        bool flush = unflushed > 0 && (urgent || stopping || flushRequested ||
+                                       unflushed >= m_AsyncConfig.flushEveryRecords ||
+                                       now - lastFlush >= flushInterval);
+        
+        if (!batch.empty() || flush)
+        {
+            WriteBatch(batch, flush);
+            if (flush)
+            {
+                unflushed = 0;
+                lastFlush = now;
+            }
+        }
+        
+        if (flushRequested)
+        {
+            std::lock_guard<std::mutex> lock(m_WakeMutex);
+            m_FlushRequested = false;
+            m_FlushedCondition.notify_all();
+        }
+        
+        if (stopping)
+            break;
+        
+        if (count == 0)
+        {
+            std::unique_lock<std::mutex> lock(m_WakeMutex);
+            m_WriterIdle.store(true, std::memory_order_release);
+            if (m_Queue->empty() && m_WriterRunning && !m_FlushRequested)
+                m_WakeCondition.wait_for(lock, flushInterval);
+            m_WriterIdle.store(false, std::memory_order_release);
+        }
+    }
+}
+
+void Logger::WriteRecord(const LogRecord& record, std::string& batch)
+{
+    if (record.argsLength > 0)
+        m_BinarySink.WriteEncoded(record.formatId, record.monotonicNs, record.level >= LogLevel::ERROR,
+                                  record.args, record.argsLength);
+    if (record.text)
+        FormatRecord(record, batch);
+}
+
+void Logger::FormatRecord(const LogRecord& record, std::string& out)
+{
+    int64_t seconds = record.timestampNs / 1000000000;
+    if (seconds != m_CachedSecond)
+    {
+        std::time_t time = static_cast<std::time_t>(seconds);
+        std::tm local {};
+        localtime_r(&time, &local);
+        std::strftime(m_CachedTime, sizeof(m_CachedTime), "%Y-%m-%d %H:%M:%S", &local);
+        m_CachedSecond = seconds;
+    }
+    
+    char millis[5];
+    int ms = static_cast<int>((record.timestampNs / 1000000) % 1000);
+    millis[0] = '.';
+    millis[1] = static_cast<char>('0' + ms / 100);
+    millis[2] = static_cast<char>('0' + (ms / 10) % 10);
+    millis[3] = static_cast<char>('0' + ms % 10);
+    millis[4] = '\0';
+    
+    out += '[';
+    out += m_CachedTime;
+    out += millis;
+    out += "] [";
+    out += LevelToString(record.level);
+    out += "] ";
+    
+    if (record.functionLength > 0)
+    {
+        out += '[';
+        out.append(record.function, record.functionLength);
+        out += ':';
+        out += std::to_string(record.line);
+        out += "] ";
+    }
+    
+    out.append(record.message, record.messageLength);
+    out += '\n';
+}
+
+void Logger::WriteBatch(std::string& batch, bool flush)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    
+    if (m_WriteToConsole && !batch.empty())
+        std::cout.write(batch.data(), static_cast<std::streamsize>(batch.size()));
+    
+    if (m_WriteToFile)
+    {
+        WriteToFileLocked(batch.data(), batch.size());
+        if (flush)
+            m_LogFile.flush();
+    }
+    
+    if (flush && m_WriteToConsole)
+        std::cout.flush();
+    
+    batch.clear();
+    
+    if (flush)
+        m_BinarySink.Flush();
+}
+
+void Logger::Debug(const std::string& message, const char* function, int line)
 {
     Log(LogLevel::DEBUG, message, function, line);
 }
 
-void Logger::Info(const std::string& message, const std::string& function, int line)
+void Logger::Info(const std::string& message, const char* function, int line)
 {
     Log(LogLevel::INFO, message, function, line);
 }
 
-void Logger::Warning(const std::string& message, const std::string& function, int line)
+void Logger::Warning(const std::string& message, const char* function, int line)
 {
     Log(LogLevel::WARNING, message, function, line);
 }
 
-void Logger::Error(const std::string& message, const std::string& function, int line)
+void Logger::Error(const std::string& message, const char* function, int line)
 {
     Log(LogLevel::ERROR, message, function, line);
 }
\ No newline at end of file
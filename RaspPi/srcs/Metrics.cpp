@@ -0,0 +1,261 @@
+#include "../includes/Metrics.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+MetricsRegistry* MetricsRegistry::instance = nullptr;
+
+namespace
+{
+    class RenderBuffer
+    {
+    public:
+        RenderBuffer(char* buffer, size_t capacity) : data(buffer), capacity(capacity) {}
+        
+        void Append(const char* text, size_t length)
+        {
+            if (size + length <= capacity)
+                std::memcpy(data + size, text, length);
+            size += length;
+        }
+        
+        void Append(const std::string& text) { Append(text.data(), text.size()); }
+        
+        void AppendUint(uint64_t value)
+        {
+            char digits[24];
+            auto result = std::to_chars(digits, digits + sizeof(digits), value);
+            Append(digits, result.ptr - digits);
+        }
+        
+        void AppendDouble(double value)
+        {
+            if (std::isnan(value))
+                return Append("NaN", 3);
+            if (std::isinf(value))
+                return value > 0 ? Append("+Inf", 4) : Append("-Inf", 4);
+            
+            char digits[32];
+            auto result = std::to_chars(digits, digits + sizeof(digits), value);
+            Append(digits, result.ptr - digits);
+        }
+        
+        size_t GetSize() const { return size; }
+
+    private:
+        char* data;
+        size_t capacity;
+        size_t size {0};
+    };
+    
+    std::string FormatBound(double bound)
+    {
+        char digits[32];
+        auto result = std::to_chars(digits, digits + sizeof(digits), bound);
+        return std::string(digits, result.ptr);
+    }
+    
+    std::string SeriesPrefix(const std::string& name, const std::string& labels)
+    {
+        return labels.empty() ? name + " " : name + "{" + labels + "} ";
+    }
+}
+
+uint64_t Counter::Value() const
+{
+    uint64_t total = 0;
+    for (const Shard& shard : shards)
+        total += shard.value.load(std::memory_order_relaxed);
+    return total;
+}
+
+void Gauge::Add(double delta)
+{
+    double current = gaugeValue.load(std::memory_order_relaxed);
+    while (!gaugeValue.compare_exchange_weak(current, current + delta, std::memory_order_relaxed))
+        ;
+}
+
+Histogram::Histogram(std::initializer_list<double> upperBounds)
+{
+    for (double bound : upperBounds)
+    {
+        if (boundCount == MAX_BUCKETS)
+            break;
+        bounds[boundCount++] = bound;
+    }
+    std::sort(bounds, bounds + boundCount);
+}
+
+void Histogram::Observe(double value)
+{
+    size_t bucket = 0;
+    while (bucket < boundCount && value > bounds[bucket])
+        bucket++;
+    
+    Shard& shard = shards[MetricShardIndex()];
+    shard.counts[bucket].fetch_add(1, std::memory_order_relaxed);
+    
+    double sum = shard.sum.load(std::memory_order_relaxed);
+    while (!shard.sum.compare_exchange_weak(sum, sum + value, std::memory_order_relaxed))
+        ;
+}
+
+void Histogram::Collect(uint64_t* cumulative, double& sum) const
+{
+    sum = 0.0;
+    for (size_t bucket = 0; bucket <= boundCount; ++bucket)
+        cumulative[bucket] = 0;
+    
+    for (const Shard& shard : shards)
+    {
+        for (size_t bucket = 0; bucket <= boundCount; ++bucket)
+            cumulative[bucket] += shard.counts[bucket].load(std::memory_order_relaxed);
+        sum += shard.sum.load(std::memory_order_relaxed);
+    }
+    
+    for (size_t bucket = 1; bucket <= boundCount; ++bucket)
+        cumulative[bucket] += cumulative[bucket - 1];
+}
+
+MetricsRegistry& MetricsRegistry::GetInstance()
+{
+    static std::once_flag initFlag;
+    std::call_once(initFlag, []() {
+        instance = new MetricsRegistry();
+    });
+    return *instance;
+}
+
+MetricsRegistry::Family& MetricsRegistry::GetFamilyLocked(const std::string& name, const std::string& help, MetricType type)
+{
+    for (Family& family : families)
+    {
+        if (family.name == name)
+            return family;
+    }
+    
+    static const char* typeNames[] = {"counter", "gauge", "histogram"};
+    families.emplace_back();
+    Family& family = families.back();
+    family.name = name;
+    family.type = type;
+    family.header = "# HELP " + name + " " + help + "\n# TYPE " + name + " " +
+                    typeNames[static_cast<int>(type)] + "\n";
+    return family;
+}
+
+const MetricsRegistry::Series* MetricsRegistry::FindSeries(const Family& family, const std::string& labels)
+{
+    for (const Series& series : family.series)
+    {
+        if (series.labels == labels)
+            return &series;
+    }
+    return nullptr;
+}
+
+Counter& MetricsRegistry::GetCounter(const std::string& name, const std::string& help, const std::string& labels)
+{
+    std::lock_guard<std::mutex> lock(registryMutex);
+    Family& family = GetFamilyLocked(name, help, MetricType::COUNTER);
+    
+    if (const Series* existing = FindSeries(family, labels))
+        return *static_cast<Counter*>(existing->metric);
+    
+    counters.emplace_back();
+    family.series.push_back({labels, SeriesPrefix(name, labels), {}, "", "", &counters.back()});
+    return counters.back();
+}
+
+Gauge& MetricsRegistry::GetGauge(const std::string& name, const std::string& help, const std::string& labels)
+{
+    std::lock_guard<std::mutex> lock(registryMutex);
+    Family& family = GetFamilyLocked(name, help, MetricType::GAUGE);
+    
+    if (const Series* existing = FindSeries(family, labels))
+        return *static_cast<Gauge*>(existing->metric);
+    
+    gauges.emplace_back();
+    family.series.push_back({labels, SeriesPrefix(name, labels), {}, "", "", &gauges.back()});
+    return gauges.back();
+}
+
+Histogram& MetricsRegistry::GetHistogram(const std::string& name, const std::string& help,
+                                         std::initializer_list<double> upperBounds, const std::string& labels)
+{
+    std::lock_guard<std::mutex> lock(registryMutex);
+    Family& family = GetFamilyLocked(name, help, MetricType::HISTOGRAM);
+    
+    if (const Series* existing = FindSeries(family, labels))
+        return *static_cast<Histogram*>(existing->metric);
+    
+    histograms.emplace_back(upperBounds);
+    Histogram& histogram = histograms.back();
+    
+    Series series {labels, "", {}, SeriesPrefix(name + "_sum", labels), SeriesPrefix(name + "_count", labels), &histogram};
+    std::string separator = labels.empty() ? "" : labels + ",";
+    for (size_t bucket = 0; bucket < histogram.GetBucketCount(); ++bucket)
+        series.bucketPrefixes.push_back(name + "_bucket{" + separator + "le=\"" +
+                                        FormatBound(histogram.GetBound(bucket)) + "\"} ");
+    series.bucketPrefixes.push_back(name + "_bucket{" + separator + "le=\"+Inf\"} ");
+    
+    family.series.push_back(std::move(series));
+    return histogram;
+}
+
+size_t MetricsRegistry::Render(char* buffer, size_t capacity) const
+{
+    std::lock_guard<std::mutex> lock(registryMutex);
+    RenderBuffer out(buffer, capacity);
+    uint64_t cumulative[Histogram::MAX_BUCKETS + 1];
+    
+    for (const Family& family : families)
+    {
+        out.Append(family.header);
+        
+        for (const Series& series : family.series)
+        {
+            switch (family.type)
+            {
+                case MetricType::COUNTER:
+                    out.Append(series.prefix);
+                    out.AppendUint(static_cast<const Counter*>(series.metric)->Value());
+                    out.Append("\n", 1);
+                    break;
+                    
+                case MetricType::GAUGE:
+                    out.Append(series.prefix);
+                    out.AppendDouble(static_cast<const Gauge*>(series.metric)->Value());
+                    out.Append("\n", 1);
+                    break;
+                    
+                case MetricType::HISTOGRAM:
+                {
+                    const Histogram* histogram = static_cast<const Histogram*>(series.metric);
+                    double sum;
+                    histogram->Collect(cumulative, sum);
+                    
+                    for (size_t bucket = 0; bucket < series.bucketPrefixes.size(); ++bucket)
+                    {
+                        out.Append(series.bucketPrefixes[bucket]);
+                        out.AppendUint(cumulative[bucket]);
+                        out.Append("\n", 1);
+                    }
+                    
+                    out.Append(series.sumPrefix);
+                    out.AppendDouble(sum);
+                    out.Append("\n", 1);
+                    out.Append(series.countPrefix);
+                    out.AppendUint(cumulative[histogram->GetBucketCount()]);
+                    out.Append("\n", 1);
+                    break;
+                }
+            }
+        }
+    }
+    
+    return out.GetSize();
+}
@@ -0,0 +1,127 @@
+#include "../includes/OverloadProtection.h"
+#include "../includes/RelayController.h"
+#include "../includes/AlertEngine.h"
+#include "../includes/Logger.h"
+#include "../includes/Metrics.h"
+
+#include <algorithm>
+
+namespace
+{
+    struct ProtectionMetrics
+    {
+        Counter& instantCurrent;
+        Counter& instantPower;
+        Counter& i2t;
+        Histogram& latency;
+    };
+    
+    // Метрики создаются при настройке, а не в потоке опроса при срабатывании
+    ProtectionMetrics& Metrics()
+    {
+        static MetricsRegistry& registry = MetricsRegistry::GetInstance();
+        static ProtectionMetrics metrics {
+            registry.GetCounter("smart_plug_protection_trips_total", "Overload protection trips", "reason=\"instant_current\""),
+            registry.GetCounter("smart_plug_protection_trips_total", "Overload protection trips", "reason=\"instant_power\""),
+            registry.GetCounter("smart_plug_protection_trips_total", "Overload protection trips", "reason=\"i2t\""),
+            registry.GetHistogram("smart_plug_protection_trip_latency_seconds",
+                "Delay between a sample becoming available and the relay GPIO write",
+                {0.000001, 0.000005, 0.00001, 0.00005, 0.0001, 0.0005, 0.001, 0.005, 0.01})
+        };
+        return metrics;
+    }
+}
+
+void OverloadProtection::Configure(const ProtectionSettings& settings)
+{
+    Metrics();
+    
+    ratedCurrent.store(std::max(0.1f, settings.ratedCurrent), std::memory_order_relaxed);
+    instantCurrent.store(std::max(0.0f, settings.instantCurrent), std::memory_order_relaxed);
+    instantPower.store(std::max(0.0f, settings.instantPower), std::memory_order_relaxed);
+    i2tLimit.store(std::max(0.0f, settings.i2t), std::memory_order_relaxed);
+    enabled.store(settings.enabled, std::memory_order_release);
+    
+    if (settings.enabled)
+        LOG_INFOF("Overload protection: rated {} A, instant {} A / {} W, I2t {} A2s",
+                  settings.ratedCurrent, settings.instantCurrent, settings.instantPower, settings.i2t);
+    else
+        LOG_INFO("Overload protection disabled");
+}
+
+bool OverloadProtection::Check(const PowerData& data, int64_t monotonicNs, int64_t acquiredNs, IClock& clock)
+{
+    if (!enabled.load(std::memory_order_acquire))
+        return false;
+    
+    // Интегрирование по времени между отсчётами; первый отсчёт только задаёт точку отсчёта
+    double dt = lastSampleNs < 0 ? 0.0 : static_cast<double>(std::max<int64_t>(0, monotonicNs - lastSampleNs)) / 1e9;
+    lastSampleNs = monotonicNs;
+    
+    float rated = ratedCurrent.load(std::memory_order_relaxed);
+    float limit = i2tLimit.load(std::memory_order_relaxed);
+    heat = std::max(0.0, heat + (static_cast<double>(data.current) * data.current - static_cast<double>(rated) * rated) * dt);
+    if (limit > 0)
+        heat = std::min(heat, static_cast<double>(limit));
+    thermalLoad.store(limit > 0 ? static_cast<float>(heat / limit) : 0.0f, std::memory_order_relaxed);
+    
+    RelayController* target = relay.load(std::memory_order_acquire);
+    if (!target || target->GetState() != RelayState::ON)
+        return false;
+    
+    float currentLimit = instantCurrent.load(std::memory_order_relaxed);
+    float powerLimit = instantPower.load(std::memory_order_relaxed);
+    
+    if (currentLimit > 0 && data.current >= currentLimit)
+        Trip(TripReason::INSTANT_CURRENT, data.current, currentLimit, data, acquiredNs, clock);
+    else if (powerLimit > 0 && data.power >= powerLimit)
+        Trip(TripReason::INSTANT_POWER, data.power, powerLimit, data, acquiredNs, clock);
+    else if (limit > 0 && heat >= limit)
+        Trip(TripReason::I2T, data.current, rated, data, acquiredNs, clock);
+    else
+        return false;
+    
+    return true;
+}
+
+void OverloadProtection::Trip(TripReason reason, float value, float limit, const PowerData& data,
+                              int64_t acquiredNs, IClock& clock)
+{
+    RelayController* target = relay.load(std::memory_order_relaxed);
+    if (!target->EmergencyOff())
+        return;
+    
+    int64_t latency = std::max<int64_t>(0, clock.MonotonicNs() - acquiredNs);
+    
+    ProtectionMetrics& metrics = Metrics();
+    metrics.latency.Observe(static_cast<double>(latency) / 1e9);
+    switch (reason)
+    {
+        case TripReason::INSTANT_CURRENT: metrics.instantCurrent.Add(); break;
+        case TripReason::INSTANT_POWER: metrics.instantPower.Add(); break;
+        default: metrics.i2t.Add(); break;
+    }
+    
+    trips.fetch_add(1, std::memory_order_relaxed);
+    lastReason.store(reason, std::memory_order_relaxed);
+    lastValue.store(value, std::memory_order_relaxed);
+    lastLatencyNs.store(latency, std::memory_order_relaxed);
+    if (latency > maxLatencyNs.load(std::memory_order_relaxed))
+        maxLatencyNs.store(latency, std::memory_order_relaxed);
+    
+    if (AlertEngine* engine = alerts.load(std::memory_order_acquire))
+        engine->RaiseCritical(TRIP_RULE, reason == TripReason::INSTANT_POWER ? AlertMetric::POWER : AlertMetric::CURRENT,
+                              value, limit, data.timestamp);
+}
+
+ProtectionStatus OverloadProtection::GetStatus() const
+{
+    ProtectionStatus status;
+    status.trips = trips.load(std::memory_order_relaxed);
+    status.lastReason = lastReason.load(std::memory_order_relaxed);
+    status.lastValue = lastValue.load(std::memory_order_relaxed);
+    status.lastLatencyNs = lastLatencyNs.load(std::memory_order_relaxed);
+    status.maxLatencyNs = maxLatencyNs.load(std::memory_order_relaxed);
+    status.thermalLoad = thermalLoad.load(std::memory_order_relaxed);
+    return status;
+}
@@ -1,22 +1,38 @@
 #include "../includes/PowerMonitor.h"
 #include "../includes/Logger.h"
+#include "../includes/Metrics.h"
 #include "../includes/ConfigManager.h"
+#include "../includes/PowerTrace.h"
+#include "../includes/AlertEngine.h"
+#include "../includes/OverloadProtection.h"
+#include "../includes/SamplingGovernor.h"
+#include "../includes/ApplianceDetector.h"
+#include "../includes/AnomalyDetector.h"
+#include "../includes/PowerQualityMonitor.h"
 #include <cmath>
 #include <algorithm>
 #include <random>
 
-#ifdef HAVE_I2C
-#include <linux/i2c-dev.h>
-#include <sys/ioctl.h>
-#include <fcntl.h>
-#include <unistd.h>
-#endif
+// Карта регистров модуля измерения (16 бит, старший байт первым)
+namespace SensorRegisters
+{
+    static constexpr uint8_t Voltage = 0x01;      // 0.01 В
+    static constexpr uint8_t Current = 0x02;      // 1 мА
+    static constexpr uint8_t Power = 0x03;        // 0.1 Вт
+    static constexpr uint8_t PowerFactor = 0x04;  // 0.001
+    static constexpr uint8_t Frequency = 0x05;    // 0.01 Гц
+}
+
+// Отставание формы больше 150/180 периодов (пауза опроса) не догоняется: окно начинается заново
+static constexpr int64_t MAX_WAVEFORM_BLOCKS = 15;
 
 PowerMonitor::PowerMonitor()
 {
     currentData = {0, 0, 0, 0, 0, 1.0, 50.0, 0, 0};
     lastValidData = currentData;
     powerHistory.resize(historySize, 0.0f);
+    waveformVoltage = std::make_unique<float[]>(PowerQualityMonitor::MAX_BLOCK_SAMPLES);
+    waveformCurrent = std::make_unique<float[]>(PowerQualityMonitor::MAX_BLOCK_SAMPLES);
 }
 
 PowerMonitor::~PowerMonitor()
@@ -28,7 +44,7 @@ bool PowerMonitor::initialize(SensorType type, int bus, int address, float calFa
 {
     if (running)
         stop();
-
+    
     i2cBus = bus;
     i2cAddress = address;
     calibrationFactor = calFactor;
@@ -51,6 +67,14 @@ bool PowerMonitor::initialize(SensorType type, int bus, int address, float calFa
             initialized = true;
             LOG_INFO("Power monitor running in simulation mode");
             break;
+        case SENSOR_REPLAY:
+            initialized = replaySource != nullptr;
+            simulationMode = true;
+            if (initialized)
+                LOG_INFO("Power monitor replaying a recorded trace");
+            else
+                LOG_WARNING("No trace to replay");
+            break;
         case SENSOR_NONE:
             LOG_INFO("Power monitoring disabled");
             return true;
@@ -76,15 +100,22 @@ bool PowerMonitor::initialize(SensorType type, int bus, int address, float calFa
 
 bool PowerMonitor::initializeI2C()
 {
-#ifdef HAVE_I2C
     LOG_INFO("Initializing I2C power sensor on bus " + 
-             std::to_string(i2cBus) + ", address 0x" + 
+             std::to_string(i2cBus) + ", address " + 
              std::to_string(i2cAddress));
+    
+    if (!sensorBus)
+        sensorBus = std::make_unique<LinuxI2CBus>();
+    
+    uint16_t probe = 0;
+    if (!sensorBus->Open(i2cBus, i2cAddress) || !sensorBus->ReadRegister(SensorRegisters::Voltage, probe))
+    {
+        LOG_WARNING("I2C power sensor not responding");
+        sensorBus->Close();
+        return false;
+    }
+    
     return true;
-#else
-    LOG_WARNING("I2C support not compiled in");
-    return false;
-#endif
 }
 
 bool PowerMonitor::initializeAnalog()
@@ -103,83 +134,238 @@ void PowerMonitor::monitoringLoop()
 {
     LOG_INFO("Power monitoring thread started");
     
-    auto lastStatUpdate = std::chrono::steady_clock::now();
-    auto lastLogUpdate = std::chrono::steady_clock::now();
+    int64_t lastStatUpdate = clock->MonotonicNs();
+    int64_t lastLogUpdate = lastStatUpdate;
+    int64_t nextSample = lastStatUpdate;
+    
+    energyAccumulator.reset(energyTotalNanoWh.load());
+    
+    MetricsRegistry& metrics = MetricsRegistry::GetInstance();
+    Counter& sampleCounter = metrics.GetCounter("smart_plug_sensor_samples_total", "Sensor samples taken");
+    Counter& invalidCounter = metrics.GetCounter("smart_plug_sensor_read_errors_total",
+                                                 "Sensor samples rejected as invalid");
+    Counter& queueFullCounter = metrics.GetCounter("smart_plug_energy_queue_full_total",
+                                                   "Energy deltas kept back because the queue was full");
+    Histogram& jitterHistogram = metrics.GetHistogram("smart_plug_sensor_sample_jitter_seconds",
+        "Delay between the scheduled and the actual sample time",
+        {0.0001, 0.0005, 0.001, 0.002, 0.005, 0.01, 0.02, 0.05, 0.1});
+    Gauge& powerGauge = metrics.GetGauge("smart_plug_power_watts", "Last measured active power");
+    
+    int64_t replayStartNs = lastStatUpdate;
+    int64_t waveformNextNs = -1;        // начало следующего блока формы
+    uint64_t traceStartMs = 0;
+    bool replayStarted = false;
     
     while (running)
     {
         PowerData newData;
+        int64_t now;
+        int64_t acquiredNs;         // начало чтения: задержка срабатывания защиты включает шину
         
-        if (simulationMode)
-            newData = simulateData();
+        if (replaySource)
+        {
+            if (!replaySource->Next(newData))
+            {
+                LOG_INFOF("Trace replay finished: {} samples", replaySource->GetRecordCount());
+                replayFinished = true;
+                break;
+            }
+            
+            if (!replayStarted)
+            {
+                traceStartMs = newData.timestamp;
+                replayStarted = true;
+            }
+            
+            // Время трассы отсчитывается от запуска; скорость влияет только на паузы
+            int64_t traceOffsetNs = static_cast<int64_t>(newData.timestamp - traceStartMs) * 1000000;
+            now = replayStartNs + traceOffsetNs;
+            if (replaySpeed > 0)
+                clock->SleepUntilNs(replayStartNs + static_cast<int64_t>(traceOffsetNs / replaySpeed));
+            acquiredNs = clock->MonotonicNs();
+        }
         else
         {
-            // реальное чтение с датчика
-            // newData = readFromI2C(); или readFromAnalog() и т.д.
-            newData = simulateData(); // временно использую симуляцию
+            now = clock->MonotonicNs();
+            acquiredNs = now;
+            newData = simulationMode ? simulateData(now) : readFromI2C();
+            newData.current *= calibrationFactor;
+            newData.power *= calibrationFactor;
+            newData.timestamp = clock->WallTimeMs();
         }
         
-        newData.current *= calibrationFactor;
-        newData.power *= calibrationFactor;
-
+        OverloadProtection* guard = protection.load(std::memory_order_acquire);
+        if (guard)
+            guard->Check(newData, now, acquiredNs, *clock);
+        
+        if (energyResetRequested.exchange(false))
+            energyAccumulator.reset(energyResetValue.load());
+        
+        energyAccumulator.addSample(newData.power, now);
+        energyTotalNanoWh.store(energyAccumulator.getTotal(), std::memory_order_relaxed);
+        newData.energy = static_cast<float>(energyAccumulator.getTotalKWh());
+        
         {
             std::lock_guard<std::mutex> lock(dataMutex);
             currentData = newData;
-            currentData.timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
-                std::chrono::system_clock::now().time_since_epoch()).count();
             
             if (newData.voltage > 0 && newData.current >= 0)
                 lastValidData = newData;
+            else
+                invalidCounter.Add();
         }
         
-        auto now = std::chrono::steady_clock::now();
-        if (std::chrono::duration_cast<std::chrono::seconds>(now - lastStatUpdate).count() >= 1)
+        AlertEngine* alerts = alertEngine.load(std::memory_order_acquire);
+        if (alerts)
+            alerts->Evaluate(newData, now);
+        
+        ApplianceDetector* detector = applianceDetector.load(std::memory_order_acquire);
+        if (detector)
+            detector->Process(newData);
+        
+        AnomalyDetector* anomalies = anomalyDetector.load(std::memory_order_acquire);
+        if (anomalies)
+            anomalies->Process(newData);
+        
+        PowerQualityMonitor* quality = powerQuality.load(std::memory_order_acquire);
+        if (quality)
+        {
+            // Форму даёт только симулятор; реальный датчик отдаёт действующие значения.
+            // Блоки идут встык от прошлого: окна 10/12 и 150/180 периодов непрерывны
+            // при любом интервале опроса.
+            size_t blockSamples;
+            double waveformRate;
+            if (simulationMode && !replaySource && quality->GetBlockFormat(blockSamples, waveformRate))
+            {
+                blockSamples = std::min(blockSamples, PowerQualityMonitor::MAX_BLOCK_SAMPLES);
+                int64_t blockNs = static_cast<int64_t>(1e9 * static_cast<double>(blockSamples) / waveformRate);
+                if (waveformNextNs < 0 || now - waveformNextNs > MAX_WAVEFORM_BLOCKS * blockNs)
+                    waveformNextNs = now - blockNs;
+                
+                for (; waveformNextNs + blockNs <= now; waveformNextNs += blockNs)
+                {
+                    loadSimulator.FillWaveform(waveformNextNs, waveformRate, blockSamples, waveformVoltage.get(),
+                                               waveformCurrent.get(), newData.voltage);
+                    uint64_t blockMs = newData.timestamp - static_cast<uint64_t>((now - waveformNextNs) / 1000000);
+                    quality->ProcessBlock(waveformVoltage.get(), waveformCurrent.get(), blockSamples, waveformRate,
+                                          blockMs);
+                }
+            }
+            else
+            {
+                waveformNextNs = -1;
+                quality->Process(newData);
+            }
+        }
+        
+        PowerTraceRecorder* traceRecorder = recorder.load(std::memory_order_acquire);
+        if (traceRecorder)
+            traceRecorder->Write(newData);
+        
+        sampleCounter.Add();
+        powerGauge.Set(newData.power);
+        
+        if (now - lastStatUpdate >= 1000000000LL)
         {
             updateStatistics(newData);
+            
+            EnergyQueue* sink = energySink.load(std::memory_order_acquire);
+            if (sink && energyAccumulator.getPendingSamples() > 0)
+            {
+                EnergyDelta delta {currentData.timestamp, energyAccumulator.getPending(),
+                                   energyAccumulator.getPendingSamples()};
+                // При переполнении дельта остаётся в аккумуляторе до следующей попытки.
+                // Воспроизведение ждёт потребителя, чтобы не терять разрешение по времени.
+                bool pushed = sink->push(delta);
+                while (!pushed && replaySource && running)
+                {
+                    std::this_thread::yield();
+                    pushed = sink->push(delta);
+                }
+                
+                if (pushed)
+                    energyAccumulator.commitPending();
+                else
+                    queueFullCounter.Add();
+            }
+            
             lastStatUpdate = now;
         }
         
-        if (std::chrono::duration_cast<std::chrono::seconds>(now - lastLogUpdate).count() >= 30)
+        if (now - lastLogUpdate >= 30000000000LL)
         {
-            LOG_DEBUG("Power: " + std::to_string(newData.power) + 
-                     "W, Current: " + std::to_string(newData.current) + 
-                     "A, Voltage: " + std::to_string(newData.voltage) + "V");
+            LOG_DEBUGF("Power: {}W, Current: {}A, Voltage: {}V", newData.power, newData.current, newData.voltage);
             lastLogUpdate = now;
         }
         
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        if (replaySource)
+            continue;
+        
+        SamplingGovernor* rateGovernor = governor.load(std::memory_order_acquire);
+        int64_t intervalUs = rateGovernor ? rateGovernor->OnSample(newData, now)
+                                          : sampleIntervalUs.load(std::memory_order_relaxed);
+        nextSample += intervalUs * 1000;
+        if (nextSample < now)
+            nextSample = now;
+        clock->SleepUntilNs(nextSample);
+        jitterHistogram.Observe(static_cast<double>(clock->MonotonicNs() - nextSample) / 1e9);
+    }
+    
+    EnergyQueue* sink = energySink.load(std::memory_order_acquire);
+    if (sink && energyAccumulator.getPending() != 0)
+    {
+        EnergyDelta delta {currentData.timestamp, energyAccumulator.getPending(),
+                           energyAccumulator.getPendingSamples()};
+        if (sink->push(delta))
+            energyAccumulator.commitPending();
     }
     
     LOG_INFO("Power monitoring thread stopped");
 }
 
-PowerData PowerMonitor::simulateData()
+PowerData PowerMonitor::readFromI2C()
 {
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    static std::uniform_real_distribution<> voltDist(215.0, 230.0);
-    static std::uniform_real_distribution<> freqDist(49.8, 50.2);
-    static std::uniform_real_distribution<> pfDist(0.85, 0.99);
-    
-    static float simulatedLoad = 100.0f;
-    static float energyAccumulator = 0.0f;
-    static auto lastUpdate = std::chrono::steady_clock::now();
-    
-    auto now = std::chrono::steady_clock::now();
-    float deltaHours = std::chrono::duration<float>(now - lastUpdate).count() / 3600.0f;
-    lastUpdate = now;
+    // Нулевое напряжение отбрасывается циклом опроса как недостоверное
+    PowerData data {};
+    uint16_t voltage, current, power, powerFactor, frequency;
+    
+    if (!sensorBus->ReadRegister(SensorRegisters::Voltage, voltage) ||
+        !sensorBus->ReadRegister(SensorRegisters::Current, current) ||
+        !sensorBus->ReadRegister(SensorRegisters::Power, power) ||
+        !sensorBus->ReadRegister(SensorRegisters::PowerFactor, powerFactor) ||
+        !sensorBus->ReadRegister(SensorRegisters::Frequency, frequency))
+        return data;
+    
+    data.voltage = voltage * 0.01f;
+    data.current = current * 0.001f;
+    data.power = power * 0.1f;
+    data.power_factor = powerFactor * 0.001f;
+    data.frequency = frequency * 0.01f;
+    data.apparent_power = data.voltage * data.current;
+    data.reactive_power = std::sqrt(std::max(0.0f, data.apparent_power * data.apparent_power - data.power * data.power));
+    
+    return data;
+}
 
-    energyAccumulator += simulatedLoad * deltaHours / 1000.0f;
+PowerData PowerMonitor::simulateData(int64_t nowNs)
+{
+    // Сопротивление сети 0.4 Ом: пусковые токи дают заметную просадку напряжения
+    static constexpr float SOURCE_IMPEDANCE = 0.4f;
+    std::normal_distribution<float> voltNoise(0.0f, 1.5f);
+    std::normal_distribution<float> freqNoise(0.0f, 0.02f);
+    
+    LoadSample load = loadSimulator.Sample(nowNs);
     
     PowerData data;
-    data.voltage = voltDist(gen);
-    data.current = simulatedLoad / data.voltage;
-    data.power = simulatedLoad;
-    data.apparent_power = data.voltage * data.current;
-    data.reactive_power = std::sqrt(data.apparent_power * data.apparent_power - data.power * data.power);
-    data.power_factor = pfDist(gen);
-    data.frequency = freqDist(gen);
-    data.energy = energyAccumulator;
+    data.voltage = LoadSimulator::NOMINAL_VOLTAGE - SOURCE_IMPEDANCE * load.current + voltNoise(simulationRng);
+    data.current = load.apparent / data.voltage;
+    data.power = load.power;
+    data.apparent_power = load.apparent;
+    data.reactive_power = load.reactive;
+    data.power_factor = load.apparent > 0.0f ? load.power / load.apparent : 1.0f;
+    data.frequency = LoadSimulator::NOMINAL_FREQUENCY + freqNoise(simulationRng);
+    data.energy = 0.0f;
+    data.timestamp = 0;
     
     return data;
 }
@@ -226,7 +412,7 @@ float PowerMonitor::getAveragePower(int seconds)
 {
     if (seconds <= 0 || seconds > static_cast<int>(historySize))
         seconds = 60;
-
+    
     size_t samples = std::min(static_cast<size_t>(seconds), historySize);
     float sum = 0.0f;
     size_t count = 0;
@@ -245,14 +431,14 @@ float PowerMonitor::getMaxPower(int seconds)
 {
     if (seconds <= 0 || seconds > static_cast<int>(historySize))
         seconds = 60;
-
+    
     size_t samples = std::min(static_cast<size_t>(seconds), historySize);
     float maxPower = 0.0f;
     
     for (size_t i = historySize - samples; i < historySize; i++)
         if (powerHistory[i] > maxPower)
             maxPower = powerHistory[i];
-
+    
     return maxPower;
 }
 
@@ -260,25 +446,35 @@ float PowerMonitor::getMinPower(int seconds)
 {
     if (seconds <= 0 || seconds > static_cast<int>(historySize))
         seconds = 60;
-
+    
     size_t samples = std::min(static_cast<size_t>(seconds), historySize);
     float minPower = std::numeric_limits<float>::max();
     
     for (size_t i = historySize - samples; i < historySize; i++)
         if (powerHistory[i] > 0 && powerHistory[i] < minPower)
             minPower = powerHistory[i];
-
+    
     return (minPower < std::numeric_limits<float>::max()) ? minPower : 0.0f;
 }
 
 void PowerMonitor::resetEnergy()
 {
-    std::lock_guard<std::mutex> lock(dataMutex);
-    currentData.energy = 0;
-    lastValidData.energy = 0;
+    restoreEnergy(0);
     LOG_INFO("Energy counter reset");
 }
 
+void PowerMonitor::restoreEnergy(int64_t nanoWh)
+{
+    energyResetValue = nanoWh;
+    energyResetRequested = true;
+    energyTotalNanoWh = nanoWh;
+    
+    float energy = static_cast<float>(static_cast<double>(nanoWh) / EnergyAccumulator::NANO_WH_PER_KWH);
+    std::lock_guard<std::mutex> lock(dataMutex);
+    currentData.energy = energy;
+    lastValidData.energy = energy;
+}
+
 bool PowerMonitor::isInitialized() const
 {
     return running;
@@ -297,10 +493,54 @@ void PowerMonitor::stop()
         if (monitoringThread.joinable())
             monitoringThread.join();
     }
+    
+    if (sensorBus)
+        sensorBus->Close();
+}
+
+void PowerMonitor::setSampleRate(int hz)
+{
+    if (hz <= 0 || hz > 10000)
+    {
+        LOG_WARNING("Invalid sample rate: " + std::to_string(hz) + " Hz");
+        return;
+    }
+    
+    sampleIntervalUs = 1000000 / hz;
+    LOG_INFO("Power sample rate set to " + std::to_string(hz) + " Hz");
 }
 
 void PowerMonitor::simulateLoad(float power)
 {
     LOG_INFO("Setting simulated load to " + std::to_string(power) + "W");
-    // в реальной реализации здесь будет изменение параметров симуляции
+    loadSimulator.SetBaseLoad(power);
+}
+
+void PowerMonitor::simulatePowerSpike(float power, int durationMs)
+{
+    loadSimulator.AddSpike(power, durationMs, clock->MonotonicNs());
+}
+
+void PowerMonitor::setSimulationSeed(uint32_t seed)
+{
+    simulationRng.seed(seed);
+    loadSimulator.Seed(seed);
+}
+
+bool PowerMonitor::setReplaySource(const std::string& path, double speed)
+{
+    if (running)
+    {
+        LOG_WARNING("Replay source must be set before the monitor starts");
+        return false;
+    }
+    
+    auto reader = std::make_unique<PowerTraceReader>();
+    if (!reader->Open(path))
+        return false;
+    
+    replaySource = std::move(reader);
+    replaySpeed = std::max(0.0, speed);
+    replayFinished = false;
+    return true;
 }
\ No newline at end of file
@@ -0,0 +1,404 @@
+#include "../includes/PowerQualityMonitor.h"
+#include "../includes/AlertEngine.h"
+#include "../includes/Metrics.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    constexpr double TWO_PI = 6.283185307179586;
+    // Отклонение частоты заканчивается, когда она вернулась в эту долю допуска
+    constexpr float FREQUENCY_RECOVERY = 0.8f;
+    // Измеренная частота используется для гармоник, если не дальше этого от номинала
+    constexpr double MAX_TRACKED_DEVIATION = 0.05;
+    
+    const char* TYPE_NAMES[] = {"sag", "swell", "interruption", "frequency"};
+    const char* ALERT_NAMES[] = {"pq_voltage_sag", "pq_voltage_swell", "pq_interruption", "pq_frequency"};
+    
+    struct QualityMetrics
+    {
+        Counter* events[4];
+        Gauge* voltage;
+        Gauge* frequency;
+        Gauge* voltageThd;
+        Gauge* currentThd;
+    };
+    
+    QualityMetrics& Metrics()
+    {
+        static QualityMetrics metrics = [] {
+            MetricsRegistry& registry = MetricsRegistry::GetInstance();
+            QualityMetrics created;
+            for (int type = 0; type < 4; ++type)
+                created.events[type] = &registry.GetCounter("smart_plug_pq_events_total",
+                    "Power quality events by type", std::string("type=\"") + TYPE_NAMES[type] + "\"");
+            created.voltage = &registry.GetGauge("smart_plug_pq_voltage_volts",
+                "RMS voltage over the 150/180-cycle window");
+            created.frequency = &registry.GetGauge("smart_plug_pq_frequency_hz",
+                "Mean frequency over the 150/180-cycle window");
+            created.voltageThd = &registry.GetGauge("smart_plug_pq_voltage_thd_ratio",
+                "Voltage total harmonic distortion over the 150/180-cycle window");
+            created.currentThd = &registry.GetGauge("smart_plug_pq_current_thd_ratio",
+                "Current total harmonic distortion over the 150/180-cycle window");
+            return created;
+        }();
+        return metrics;
+    }
+    
+    // Частота по переходам через ноль снизу вверх с линейной интерполяцией;
+    // переходы ближе полупериода считаются дребезгом
+    double MeasureFrequency(const float* voltage, size_t count, double sampleRateHz, double samplesPerCycle)
+    {
+        double first = -1.0;
+        double last = -1.0;
+        int cycles = -1;
+        for (size_t n = 1; n < count; ++n)
+        {
+            if (!(voltage[n - 1] < 0.0f && voltage[n] >= 0.0f))
+                continue;
+            
+            double crossing = static_cast<double>(n - 1) + voltage[n - 1] / (voltage[n - 1] - voltage[n]);
+            if (last >= 0.0 && crossing - last < samplesPerCycle / 2)
+                continue;
+            if (first < 0.0)
+                first = crossing;
+            last = crossing;
+            cycles++;
+        }
+        
+        if (cycles < 1 || last <= first)
+            return 0.0;
+        return cycles * sampleRateHz / (last - first);
+    }
+}
+
+void PowerQualityMonitor::Configure(const PQSettings& value)
+{
+    Metrics();
+    settings.Store(value);
+}
+
+const char* PowerQualityMonitor::EventTypeName(PQEventType type)
+{
+    return TYPE_NAMES[static_cast<int>(type)];
+}
+
+void PowerQualityMonitor::RefreshLimits()
+{
+    // Версия до чтения: запись между ними просто вызовет повторное обновление
+    settingsVersion = settings.GetVersion();
+    PQSettings current = settings.Load();
+    
+    float nominal = std::max(1.0f, current.nominalVoltage);
+    limits.enabled = current.enabled;
+    limits.waveform = current.waveform;
+    limits.nominalFrequency = current.nominalFrequency > 55.0f ? 60.0f : 50.0f;
+    limits.sagStart = current.sagThreshold * nominal;
+    limits.sagEnd = (current.sagThreshold + current.hysteresis) * nominal;
+    limits.swellStart = current.swellThreshold * nominal;
+    limits.swellEnd = (current.swellThreshold - current.hysteresis) * nominal;
+    limits.interruption = current.interruptionThreshold * nominal;
+    limits.frequencyTolerance = std::max(0.01f, current.frequencyTolerance);
+    limits.samplesPerCycle = std::clamp(current.samplesPerCycle, 16, 128);
+    limits.shortCycles = limits.nominalFrequency > 55.0f ? 12 : 10;
+    limits.longWindowMs = static_cast<uint64_t>(limits.shortCycles * 15 * 1000 / limits.nominalFrequency);
+}
+
+bool PowerQualityMonitor::GetBlockFormat(size_t& samples, double& sampleRateHz)
+{
+    if (settings.GetVersion() != settingsVersion)
+        RefreshLimits();
+    if (!limits.enabled || !limits.waveform)
+        return false;
+    
+    samples = static_cast<size_t>(limits.shortCycles * limits.samplesPerCycle);
+    sampleRateHz = static_cast<double>(limits.samplesPerCycle) * limits.nominalFrequency;
+    return true;
+}
+
+void PowerQualityMonitor::ProcessBlock(const float* voltage, const float* current, size_t count, double sampleRateHz,
+                                       uint64_t timestamp)
+{
+    if (settings.GetVersion() != settingsVersion)
+        RefreshLimits();
+    if (!limits.enabled || sampleRateHz <= 0.0)
+        return;
+    
+    double samplesPerCycle = sampleRateHz / limits.nominalFrequency;
+    size_t half = std::max<size_t>(1, static_cast<size_t>(std::lround(samplesPerCycle / 2)));
+    if (count < 2 * half)
+        return;
+    
+    // Urms(1/2): период, сдвигаемый на полпериода
+    double halfMs = 1000.0 * static_cast<double>(half) / sampleRateHz;
+    double previousHalf = 0.0;
+    double totalSquares = 0.0;
+    size_t used = 0;
+    for (size_t start = 0, k = 0; start + half <= count; start += half, ++k)
+    {
+        double squares = 0.0;
+        for (size_t n = start; n < start + half; ++n)
+            squares += static_cast<double>(voltage[n]) * voltage[n];
+        
+        if (k > 0)
+            UpdateVoltage(static_cast<float>(std::sqrt((previousHalf + squares) / (2 * half))),
+                          timestamp + static_cast<uint64_t>((k + 1) * halfMs));
+        previousHalf = squares;
+        totalSquares += squares;
+        used += half;
+    }
+    
+    double frequency = MeasureFrequency(voltage, count, sampleRateHz, samplesPerCycle);
+    double fundamental = frequency > 0.0 && std::fabs(frequency / limits.nominalFrequency - 1.0) <= MAX_TRACKED_DEVIATION
+        ? frequency : limits.nominalFrequency;
+    
+    // Гёрцель сразу для всех гармоник: внутренний цикл по гармоникам без
+    // зависимостей между ними векторизуется
+    int harmonics = std::min(PQSnapshot::MAX_HARMONIC, static_cast<int>(sampleRateHz / 2 / fundamental - 0.01));
+    float coefficients[PQSnapshot::MAX_HARMONIC];
+    float voltage1[PQSnapshot::MAX_HARMONIC] {};
+    float voltage2[PQSnapshot::MAX_HARMONIC] {};
+    float current1[PQSnapshot::MAX_HARMONIC] {};
+    float current2[PQSnapshot::MAX_HARMONIC] {};
+    for (int h = 0; h < harmonics; ++h)
+        coefficients[h] = static_cast<float>(2.0 * std::cos(TWO_PI * (h + 1) * fundamental / sampleRateHz));
+    
+    for (size_t n = 0; n < count; ++n)
+    {
+        float v = voltage[n];
+        float i = current[n];
+        for (int h = 0; h < harmonics; ++h)
+        {
+            float nextVoltage = v + coefficients[h] * voltage1[h] - voltage2[h];
+            voltage2[h] = voltage1[h];
+            voltage1[h] = nextVoltage;
+            float nextCurrent = i + coefficients[h] * current1[h] - current2[h];
+            current2[h] = current1[h];
+            current1[h] = nextCurrent;
+        }
+    }
+    
+    // Действующее значение гармоники: sqrt(2 * |X|^2) / N
+    double voltageRms[PQSnapshot::MAX_HARMONIC] {};
+    double currentRms[PQSnapshot::MAX_HARMONIC] {};
+    for (int h = 0; h < harmonics; ++h)
+    {
+        double voltagePower = static_cast<double>(voltage1[h]) * voltage1[h] + static_cast<double>(voltage2[h]) * voltage2[h] -
+                              static_cast<double>(coefficients[h]) * voltage1[h] * voltage2[h];
+        double currentPower = static_cast<double>(current1[h]) * current1[h] + static_cast<double>(current2[h]) * current2[h] -
+                              static_cast<double>(coefficients[h]) * current1[h] * current2[h];
+        voltageRms[h] = std::sqrt(2.0 * std::max(0.0, voltagePower)) / count;
+        currentRms[h] = std::sqrt(2.0 * std::max(0.0, currentPower)) / count;
+    }
+    
+    double voltageDistortion = 0.0;
+    double currentDistortion = 0.0;
+    for (int h = 1; h < harmonics; ++h)
+    {
+        voltageDistortion += voltageRms[h] * voltageRms[h];
+        currentDistortion += currentRms[h] * currentRms[h];
+    }
+    
+    voltageHarmonics[0] = static_cast<float>(voltageRms[0]);
+    currentHarmonics[0] = static_cast<float>(currentRms[0]);
+    for (int h = 1; h < PQSnapshot::MAX_HARMONIC; ++h)
+    {
+        voltageHarmonics[h] = h < harmonics && voltageRms[0] > 0.0 ? static_cast<float>(voltageRms[h] / voltageRms[0]) : 0.0f;
+        currentHarmonics[h] = h < harmonics && currentRms[0] > 0.0 ? static_cast<float>(currentRms[h] / currentRms[0]) : 0.0f;
+    }
+    
+    PQAggregate window;
+    window.voltage = static_cast<float>(std::sqrt(totalSquares / used));
+    window.frequency = static_cast<float>(frequency);
+    window.voltageThd = voltageRms[0] > 0.0 ? static_cast<float>(std::sqrt(voltageDistortion) / voltageRms[0]) : 0.0f;
+    window.currentThd = currentRms[0] > 0.0 ? static_cast<float>(std::sqrt(currentDistortion) / currentRms[0]) : 0.0f;
+    window.timestamp = timestamp + static_cast<uint64_t>(1000.0 * count / sampleRateHz);
+    AddShortWindow(window, true);
+}
+
+void PowerQualityMonitor::Process(const PowerData& data)
+{
+    if (settings.GetVersion() != settingsVersion)
+        RefreshLimits();
+    // Нулевое напряжение - ошибка чтения, а не прерывание
+    if (!limits.enabled || !(data.voltage > 0.0f))
+        return;
+    
+    UpdateVoltage(data.voltage, data.timestamp);
+    
+    PQAggregate window {};
+    window.voltage = data.voltage;
+    window.frequency = data.frequency > 0.0f ? data.frequency : 0.0f;
+    window.timestamp = data.timestamp;
+    AddShortWindow(window, false);
+}
+
+void PowerQualityMonitor::UpdateVoltage(float rms, uint64_t timestamp)
+{
+    if (!voltageActive)
+    {
+        PQEventType type;
+        float threshold;
+        if (rms < limits.sagStart)
+        {
+            type = rms < limits.interruption ? PQEventType::INTERRUPTION : PQEventType::SAG;
+            threshold = type == PQEventType::SAG ? limits.sagStart : limits.interruption;
+        }
+        else if (rms > limits.swellStart)
+        {
+            type = PQEventType::SWELL;
+            threshold = limits.swellStart;
+        }
+        else
+            return;
+        
+        voltageActive = true;
+        voltageEvent = PQEvent {timestamp, 0, rms, type};
+        if (alertEngine)
+            alertEngine->Raise(ALERT_NAMES[static_cast<int>(type)], AlertMetric::VOLTAGE, rms, threshold, timestamp);
+        return;
+    }
+    
+    if (voltageEvent.type == PQEventType::SWELL)
+    {
+        voltageEvent.extreme = std::max(voltageEvent.extreme, rms);
+        if (rms <= limits.swellEnd)
+            FinishEvent(voltageEvent, voltageActive, timestamp);
+        return;
+    }
+    
+    // Провал, перешедший ниже порога прерывания, считается прерыванием
+    voltageEvent.extreme = std::min(voltageEvent.extreme, rms);
+    if (voltageEvent.type == PQEventType::SAG && rms < limits.interruption)
+    {
+        voltageEvent.type = PQEventType::INTERRUPTION;
+        if (alertEngine)
+            alertEngine->Raise(ALERT_NAMES[static_cast<int>(PQEventType::INTERRUPTION)], AlertMetric::VOLTAGE,
+                               rms, limits.interruption, timestamp);
+    }
+    if (rms >= limits.sagEnd)
+        FinishEvent(voltageEvent, voltageActive, timestamp);
+}
+
+void PowerQualityMonitor::UpdateFrequency(float frequency, uint64_t timestamp)
+{
+    float deviation = std::fabs(frequency - limits.nominalFrequency);
+    
+    if (!frequencyActive)
+    {
+        if (deviation <= limits.frequencyTolerance)
+            return;
+        
+        frequencyActive = true;
+        frequencyEvent = PQEvent {timestamp, 0, frequency, PQEventType::FREQUENCY};
+        float threshold = frequency > limits.nominalFrequency ? limits.nominalFrequency + limits.frequencyTolerance
+                                                              : limits.nominalFrequency - limits.frequencyTolerance;
+        if (alertEngine)
+            alertEngine->Raise(ALERT_NAMES[static_cast<int>(PQEventType::FREQUENCY)], AlertMetric::FREQUENCY,
+                               frequency, threshold, timestamp);
+        return;
+    }
+    
+    if (deviation > std::fabs(frequencyEvent.extreme - limits.nominalFrequency))
+        frequencyEvent.extreme = frequency;
+    if (deviation <= limits.frequencyTolerance * FREQUENCY_RECOVERY)
+        FinishEvent(frequencyEvent, frequencyActive, timestamp);
+}
+
+void PowerQualityMonitor::FinishEvent(PQEvent& event, bool& active, uint64_t timestamp)
+{
+    event.durationMs = timestamp > event.start ? static_cast<uint32_t>(timestamp - event.start) : 0;
+    events[nextEvent] = event;
+    nextEvent = (nextEvent + 1) % PQSnapshot::MAX_EVENTS;
+    eventCount = std::min(eventCount + 1, PQSnapshot::MAX_EVENTS);
+    totalEvents++;
+    active = false;
+    
+    Metrics().events[static_cast<int>(event.type)]->Add();
+}
+
+void PowerQualityMonitor::AddShortWindow(const PQAggregate& window, bool fromWaveform)
+{
+    // Длинное окно - 15 коротких по времени; при скачке часов назад начинается заново
+    if (longCount > 0 && (window.timestamp - longStartMs >= limits.longWindowMs || window.timestamp < longStartMs))
+        CloseLongWindow(window.timestamp);
+    
+    if (longCount == 0)
+        longStartMs = window.timestamp;
+    
+    shortWindow = window;
+    lastFromWaveform = fromWaveform;
+    longVoltageSquares += static_cast<double>(window.voltage) * window.voltage;
+    longCount++;
+    if (window.frequency > 0.0f)
+    {
+        longFrequency += window.frequency;
+        longFrequencyCount++;
+    }
+    if (fromWaveform)
+    {
+        longVoltageThdSquares += static_cast<double>(window.voltageThd) * window.voltageThd;
+        longCurrentThdSquares += static_cast<double>(window.currentThd) * window.currentThd;
+        longThdCount++;
+    }
+    
+    Publish();
+}
+
+void PowerQualityMonitor::CloseLongWindow(uint64_t timestamp)
+{
+    longWindow.voltage = static_cast<float>(std::sqrt(longVoltageSquares / longCount));
+    longWindow.frequency = longFrequencyCount > 0 ? static_cast<float>(longFrequency / longFrequencyCount) : 0.0f;
+    longWindow.voltageThd = longThdCount > 0 ? static_cast<float>(std::sqrt(longVoltageThdSquares / longThdCount)) : 0.0f;
+    longWindow.currentThd = longThdCount > 0 ? static_cast<float>(std::sqrt(longCurrentThdSquares / longThdCount)) : 0.0f;
+    longWindow.timestamp = timestamp;
+    
+    if (longWindow.frequency > 0.0f)
+        UpdateFrequency(longWindow.frequency, timestamp);
+    
+    QualityMetrics& metrics = Metrics();
+    metrics.voltage->Set(longWindow.voltage);
+    if (longWindow.frequency > 0.0f)
+        metrics.frequency->Set(longWindow.frequency);
+    if (longThdCount > 0)
+    {
+        metrics.voltageThd->Set(longWindow.voltageThd);
+        metrics.currentThd->Set(longWindow.currentThd);
+    }
+    
+    longVoltageSquares = 0.0;
+    longFrequency = 0.0;
+    longFrequencyCount = 0;
+    longVoltageThdSquares = 0.0;
+    longCurrentThdSquares = 0.0;
+    longThdCount = 0;
+    longCount = 0;
+}
+
+void PowerQualityMonitor::Publish()
+{
+    PQSnapshot current {};
+    
+    std::copy(std::begin(events), std::end(events), current.events);
+    current.eventCount = eventCount;
+    current.nextEvent = nextEvent;
+    current.totalEvents = totalEvents;
+    
+    current.voltageActive = voltageActive;
+    current.voltageEvent = voltageEvent;
+    if (voltageActive && shortWindow.timestamp > voltageEvent.start)
+        current.voltageEvent.durationMs = static_cast<uint32_t>(shortWindow.timestamp - voltageEvent.start);
+    current.frequencyActive = frequencyActive;
+    current.frequencyEvent = frequencyEvent;
+    if (frequencyActive && shortWindow.timestamp > frequencyEvent.start)
+        current.frequencyEvent.durationMs = static_cast<uint32_t>(shortWindow.timestamp - frequencyEvent.start);
+    
+    current.shortWindow = shortWindow;
+    current.longWindow = longWindow;
+    current.waveform = lastFromWaveform;
+    std::copy(std::begin(voltageHarmonics), std::end(voltageHarmonics), current.voltageHarmonics);
+    std::copy(std::begin(currentHarmonics), std::end(currentHarmonics), current.currentHarmonics);
+    
+    snapshot.Store(current);
+}
@@ -0,0 +1,253 @@
+#include "../includes/PowerTrace.h"
+#include "../includes/Logger.h"
+#include "../includes/RawBytes.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+    constexpr char TRACE_MAGIC[4] = {'S', 'P', 'T', 'R'};
+    constexpr uint32_t TRACE_VERSION = 1;
+    constexpr size_t TRACE_BUFFER_SIZE = 64 * 1024;
+    constexpr const char* CSV_HEADER = "timestamp_ms,voltage,current,power,power_factor,frequency\n";
+    
+    void FillDerived(PowerData& data)
+    {
+        data.apparent_power = data.voltage * data.current;
+        data.reactive_power = std::sqrt(std::max(0.0f,
+            data.apparent_power * data.apparent_power - data.power * data.power));
+        data.energy = 0.0f;
+    }
+}
+
+TraceFormat PowerTrace::FormatFromPath(const std::string& path)
+{
+    size_t dot = path.rfind('.');
+    if (dot != std::string::npos && path.compare(dot, std::string::npos, ".csv") == 0)
+        return TraceFormat::CSV;
+    return TraceFormat::BINARY;
+}
+
+PowerTraceReader::~PowerTraceReader()
+{
+    Close();
+}
+
+bool PowerTraceReader::Open(const std::string& path)
+{
+    Close();
+    
+    file = std::fopen(path.c_str(), "rbe");
+    if (!file)
+    {
+        LOG_ERROR("Failed to open trace " + path + ": " + std::string(strerror(errno)));
+        return false;
+    }
+    setvbuf(file, nullptr, _IOFBF, TRACE_BUFFER_SIZE);
+    
+    unsigned char header[PowerTrace::HEADER_SIZE];
+    size_t got = std::fread(header, 1, sizeof(header), file);
+    if (got == sizeof(header) && std::memcmp(header, TRACE_MAGIC, sizeof(TRACE_MAGIC)) == 0)
+    {
+        if (GetRaw<uint32_t>(header, 4) != TRACE_VERSION)
+        {
+            LOG_ERROR("Unsupported trace version in " + path);
+            Close();
+            return false;
+        }
+        format = TraceFormat::BINARY;
+        dataOffset = PowerTrace::HEADER_SIZE;
+    }
+    else
+    {
+        // Первая строка CSV - заголовок
+        format = TraceFormat::CSV;
+        std::rewind(file);
+        int c;
+        while ((c = std::fgetc(file)) != EOF && c != '\n')
+        {
+        }
+        dataOffset = std::ftell(file);
+    }
+    
+    records = 0;
+    skipped = 0;
+    LOG_INFO("Trace opened: " + path + (format == TraceFormat::CSV ? " (csv)" : " (binary)"));
+    return true;
+}
+
+void PowerTraceReader::Close()
+{
+    if (file)
+    {
+        std::fclose(file);
+        file = nullptr;
+    }
+}
+
+bool PowerTraceReader::Next(PowerData& data)
+{
+    if (!file)
+        return false;
+    
+    if (!(format == TraceFormat::CSV ? ReadCSV(data) : ReadBinary(data)))
+        return false;
+    
+    FillDerived(data);
+    records++;
+    return true;
+}
+
+bool PowerTraceReader::ReadBinary(PowerData& data)
+{
+    unsigned char record[PowerTrace::RECORD_SIZE];
+    if (std::fread(record, 1, sizeof(record), file) != sizeof(record))
+        return false;
+    
+    data.timestamp = static_cast<uint64_t>(GetRaw<int64_t>(record, 0));
+    data.voltage = GetRaw<float>(record, 8);
+    data.current = GetRaw<float>(record, 12);
+    data.power = GetRaw<float>(record, 16);
+    data.power_factor = GetRaw<float>(record, 20);
+    data.frequency = GetRaw<float>(record, 24);
+    return true;
+}
+
+bool PowerTraceReader::ReadCSV(PowerData& data)
+{
+    char line[256];
+    while (std::fgets(line, sizeof(line), file))
+    {
+        char* cursor = line;
+        char* end;
+        
+        long long timestamp = std::strtoll(cursor, &end, 10);
+        bool valid = end != cursor;
+        float fields[5];
+        for (float& field : fields)
+        {
+            if (!valid || *end != ',')
+            {
+                valid = false;
+                break;
+            }
+            cursor = end + 1;
+            field = std::strtof(cursor, &end);
+            valid = end != cursor;
+        }
+        
+        if (!valid)
+        {
+            if (line[0] != '\n' && line[0] != '\r')
+                skipped++;
+            continue;
+        }
+        
+        data.timestamp = static_cast<uint64_t>(timestamp);
+        data.voltage = fields[0];
+        data.current = fields[1];
+        data.power = fields[2];
+        data.power_factor = fields[3];
+        data.frequency = fields[4];
+        return true;
+    }
+    return false;
+}
+
+bool PowerTraceReader::Rewind()
+{
+    if (!file || std::fseek(file, dataOffset, SEEK_SET) != 0)
+        return false;
+    
+    records = 0;
+    return true;
+}
+
+PowerTraceRecorder::~PowerTraceRecorder()
+{
+    Close();
+}
+
+bool PowerTraceRecorder::Open(const std::string& path, TraceFormat traceFormat)
+{
+    Close();
+    
+    file = std::fopen(path.c_str(), "wbe");
+    if (!file)
+    {
+        LOG_ERROR("Failed to create trace " + path + ": " + std::string(strerror(errno)));
+        return false;
+    }
+    setvbuf(file, nullptr, _IOFBF, TRACE_BUFFER_SIZE);
+    
+    format = traceFormat;
+    records = 0;
+    
+    bool written;
+    if (format == TraceFormat::CSV)
+        written = std::fputs(CSV_HEADER, file) >= 0;
+    else
+    {
+        unsigned char header[PowerTrace::HEADER_SIZE];
+        std::memcpy(header, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+        PutRaw<uint32_t>(header, 4, TRACE_VERSION);
+        written = std::fwrite(header, 1, sizeof(header), file) == sizeof(header);
+    }
+    
+    if (!written)
+    {
+        LOG_ERROR("Failed to write trace header to " + path);
+        Close();
+        return false;
+    }
+    
+    LOG_INFO("Recording sensor trace to " + path);
+    return true;
+}
+
+void PowerTraceRecorder::Close()
+{
+    if (file)
+    {
+        std::fclose(file);
+        file = nullptr;
+    }
+}
+
+bool PowerTraceRecorder::Write(const PowerData& data)
+{
+    if (!file)
+        return false;
+    
+    bool written;
+    if (format == TraceFormat::CSV)
+        written = std::fprintf(file, "%" PRId64 ",%.3f,%.4f,%.2f,%.4f,%.3f\n",
+                               static_cast<int64_t>(data.timestamp), data.voltage, data.current,
+                               data.power, data.power_factor, data.frequency) > 0;
+    else
+    {
+        unsigned char record[PowerTrace::RECORD_SIZE];
+        PutRaw<int64_t>(record, 0, static_cast<int64_t>(data.timestamp));
+        PutRaw<float>(record, 8, data.voltage);
+        PutRaw<float>(record, 12, data.current);
+        PutRaw<float>(record, 16, data.power);
+        PutRaw<float>(record, 20, data.power_factor);
+        PutRaw<float>(record, 24, data.frequency);
+        written = std::fwrite(record, 1, sizeof(record), file) == sizeof(record);
+    }
+    
+    if (written)
+        records++;
+    return written;
+}
+
+void PowerTraceRecorder::Flush()
+{
+    if (file)
+        std::fflush(file);
+}
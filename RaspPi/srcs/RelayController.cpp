@@ -1,7 +1,8 @@
 #include "../includes/RelayController.h"
 #include "../includes/Logger.h"
+#include "../includes/Metrics.h"
 
-bool RelayController::Initialize(int pin, bool simulation, bool activeLowMode)
+bool RelayController::Initialize(int pin, bool simulation, bool activeLowMode, RelayState initialState)
 {
     m_RelayPin = pin;
     m_ActiveLow = activeLowMode;
@@ -20,7 +21,7 @@ bool RelayController::Initialize(int pin, bool simulation, bool activeLowMode)
         return false;
     }
     
-    bool success = TurnOff();
+    bool success = SetRelayStateInternal(initialState == RelayState::ON ? RelayState::ON : RelayState::OFF);
     LOG_INFO(success ? "Relay controller initialized successfully" : "Failed to set initial relay state");
     return success;
 }
@@ -34,23 +35,44 @@ void RelayController::Shutdown()
 
 bool RelayController::SetRelayStateInternal(RelayState state)
 {
-    std::lock_guard<std::mutex> lock(m_StateMutex);
-    
-    bool gpioState;
-    if (m_ActiveLow)
-        gpioState = (state == RelayState::OFF) ? Pins::High : Pins::Low;
-    else
-        gpioState = (state == RelayState::ON) ? Pins::High : Pins::Low;
+    static MetricsRegistry& metrics = MetricsRegistry::GetInstance();
+    static Counter& switchesOn = metrics.GetCounter("smart_plug_relay_switches_total", "Relay state changes", "state=\"on\"");
+    static Counter& switchesOff = metrics.GetCounter("smart_plug_relay_switches_total", "Relay state changes", "state=\"off\"");
+    static Counter& switchErrors = metrics.GetCounter("smart_plug_relay_errors_total", "Failed GPIO writes to the relay");
+    static Gauge& stateGauge = metrics.GetGauge("smart_plug_relay_state", "Relay state (1 = on)");
     
-    if (m_Gpio.DigitalWrite(m_RelayPin, gpioState))
+    std::function<void(RelayState)> callback;
     {
+        std::lock_guard<std::mutex> lock(m_StateMutex);
+        
+        bool gpioState;
+        if (m_ActiveLow)
+            gpioState = (state == RelayState::OFF) ? Pins::High : Pins::Low;
+        else
+            gpioState = (state == RelayState::ON) ? Pins::High : Pins::Low;
+        
+        if (!m_Gpio.DigitalWrite(m_RelayPin, gpioState))
+        {
+            switchErrors.Add();
+            LOG_ERROR("Failed to set relay state");
+            return false;
+        }
+        
+        // Обычное переключение поглощает ещё не обработанное аварийное
+        bool emergency = m_EmergencyPending.exchange(false);
+        if (m_CurrentState != state || emergency)
+        {
+            callback = m_StateChangeCallback;
+            (state == RelayState::ON ? switchesOn : switchesOff).Add();
+        }
+        stateGauge.Set(state == RelayState::ON ? 1.0 : 0.0);
         m_CurrentState = state;
         LOG_INFO("Relay set to: " + StateToString(state) + " (GPIO: " + std::string(gpioState ? "HIGH" : "LOW") + ")");
-        return true;
     }
     
-    LOG_ERROR("Failed to set relay state");
-    return false;
+    if (callback)
+        callback(state);
+    return true;
 }
 
 std::string RelayController::StateToString(RelayState state)
@@ -91,6 +113,42 @@ bool RelayController::Toggle()
     }
 }
 
+bool RelayController::EmergencyOff() noexcept
+{
+    if (m_RelayPin < 0 || !m_Gpio.GetInitialized())
+        return false;
+    
+    int level = m_ActiveLow.load(std::memory_order_relaxed) ? Pins::High : Pins::Low;
+    if (!m_Gpio.WritePinRaw(m_RelayPin, level))
+        return false;
+    
+    if (m_CurrentState.exchange(RelayState::OFF) != RelayState::OFF)
+        m_EmergencyPending.store(true, std::memory_order_release);
+    return true;
+}
+
+void RelayController::CompleteEmergencyOff()
+{
+    static Counter& switchesOff = MetricsRegistry::GetInstance().GetCounter(
+        "smart_plug_relay_switches_total", "Relay state changes", "state=\"off\"");
+    static Gauge& stateGauge = MetricsRegistry::GetInstance().GetGauge("smart_plug_relay_state", "Relay state (1 = on)");
+    
+    std::function<void(RelayState)> callback;
+    {
+        std::lock_guard<std::mutex> lock(m_StateMutex);
+        if (!m_EmergencyPending.exchange(false))
+            return;
+        
+        switchesOff.Add();
+        stateGauge.Set(m_CurrentState == RelayState::ON ? 1.0 : 0.0);
+        callback = m_StateChangeCallback;
+    }
+    
+    LOG_WARNING("Relay switched OFF by overload protection");
+    if (callback)
+        callback(RelayState::OFF);
+}
+
 RelayState RelayController::GetState() const
 {
     return m_CurrentState;
@@ -115,4 +173,9 @@ void RelayController::SetActiveLow(bool activeLowMode)
 {
     m_ActiveLow = activeLowMode;
     LOG_INFO("Set relay activeLow mode to: " + std::string(m_ActiveLow ? "true" : "false"));
-}
\ No newline at end of file
+}
+void RelayController::SetStateChangeCallback(std::function<void(RelayState)> callback)
+{
+    std::lock_guard<std::mutex> lock(m_StateMutex);
+    m_StateChangeCallback = std::move(callback);
+}
@@ -0,0 +1,209 @@
+#include "../includes/SamplingGovernor.h"
+#include "../includes/Logger.h"
+#include "../includes/Metrics.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace
+{
+    // Полоса, на которую температура должна опуститься, чтобы вернуть уровень
+    constexpr float TEMPERATURE_HYSTERESIS = 3.0f;
+    constexpr float LOAD_HYSTERESIS = 0.1f;
+    
+    struct GovernorMetrics
+    {
+        Counter* changes[SamplingGovernor::MODE_COUNT];
+        Gauge& rate;
+        Gauge& load;
+        Counter& deferred;
+    };
+    
+    GovernorMetrics& Metrics()
+    {
+        static MetricsRegistry& registry = MetricsRegistry::GetInstance();
+        static GovernorMetrics metrics = [] {
+            GovernorMetrics result {
+                {},
+                registry.GetGauge("smart_plug_sample_rate_hz", "Current power sampling rate"),
+                registry.GetGauge("smart_plug_cpu_load_ratio", "CPU busy fraction seen by the sampling governor"),
+                registry.GetCounter("smart_plug_background_work_deferred_total",
+                                    "Rollups and exports postponed because the CPU is hot or busy")
+            };
+            for (int i = 0; i < SamplingGovernor::MODE_COUNT; ++i)
+                result.changes[i] = &registry.GetCounter("smart_plug_sample_rate_changes_total",
+                    "Sampling governor rate changes by new mode",
+                    std::string("mode=\"") + SamplingGovernor::ModeName(static_cast<GovernorMode>(i)) + "\"");
+            return result;
+        }();
+        return metrics;
+    }
+}
+
+const char* SamplingGovernor::ModeName(GovernorMode mode)
+{
+    switch (mode)
+    {
+        case GovernorMode::NORMAL: return "normal";
+        case GovernorMode::BOOST: return "boost";
+        case GovernorMode::REDUCED: return "reduced";
+        case GovernorMode::MINIMUM: return "minimum";
+    }
+    return "unknown";
+}
+
+SamplingGovernor::SamplingGovernor()
+{
+    Metrics();
+    statFd = open("/proc/stat", O_RDONLY | O_CLOEXEC);
+}
+
+SamplingGovernor::~SamplingGovernor()
+{
+    if (statFd >= 0)
+        close(statFd);
+}
+
+void SamplingGovernor::Configure(const GovernorSettings& settings)
+{
+    minRate.store(std::max(1, settings.minRateHz), std::memory_order_relaxed);
+    boostRate.store(std::max(1, settings.boostRateHz), std::memory_order_relaxed);
+    warmTemperature.store(settings.warmTemperature, std::memory_order_relaxed);
+    hotTemperature.store(std::max(settings.warmTemperature, settings.hotTemperature), std::memory_order_relaxed);
+    highLoad.store(settings.highLoad, std::memory_order_relaxed);
+    nearThreshold.store(settings.nearThreshold, std::memory_order_relaxed);
+    transientWatts.store(settings.transientWatts, std::memory_order_relaxed);
+    boostHoldMs.store(std::max(0, settings.boostHoldMs), std::memory_order_relaxed);
+    enabled.store(settings.enabled, std::memory_order_release);
+    
+    LOG_INFOF("Sampling governor {}: {}-{} Hz, warm {} C, hot {} C, high load {}",
+              settings.enabled ? "enabled" : "disabled", settings.minRateHz, settings.boostRateHz,
+              settings.warmTemperature, settings.hotTemperature, settings.highLoad);
+}
+
+void SamplingGovernor::SetBaseRate(int hz)
+{
+    baseRate.store(std::max(1, hz), std::memory_order_relaxed);
+}
+
+void SamplingGovernor::SetWatchLimits(float powerWatts, float currentAmps)
+{
+    watchPower.store(std::max(0.0f, powerWatts), std::memory_order_relaxed);
+    watchCurrent.store(std::max(0.0f, currentAmps), std::memory_order_relaxed);
+}
+
+float SamplingGovernor::ReadCpuLoad()
+{
+    char buffer[256];
+    ssize_t length = statFd >= 0 ? pread(statFd, buffer, sizeof(buffer) - 1, 0) : -1;
+    if (length <= 0)
+        return cpuLoad.load(std::memory_order_relaxed);
+    buffer[length] = '\0';
+    
+    uint64_t user = 0, nice = 0, system = 0, idle = 0, iowait = 0, irq = 0, softirq = 0, steal = 0;
+    if (std::sscanf(buffer, "cpu %" SCNu64 " %" SCNu64 " %" SCNu64 " %" SCNu64 " %" SCNu64 " %" SCNu64 " %" SCNu64 " %" SCNu64,
+                    &user, &nice, &system, &idle, &iowait, &irq, &softirq, &steal) < 4)
+        return cpuLoad.load(std::memory_order_relaxed);
+    
+    uint64_t total = user + nice + system + idle + iowait + irq + softirq + steal;
+    uint64_t busy = total - idle - iowait;
+    float load = 0.0f;
+    if (lastTotal != 0 && total > lastTotal)
+        load = static_cast<float>(busy - lastBusy) / static_cast<float>(total - lastTotal);
+    lastBusy = busy;
+    lastTotal = total;
+    return load;
+}
+
+void SamplingGovernor::UpdateConditions(const ThermalSnapshot& thermal)
+{
+    float load = ReadCpuLoad();
+    cpuLoad.store(load, std::memory_order_relaxed);
+    Metrics().load.Set(load);
+    
+    float warm = warmTemperature.load(std::memory_order_relaxed);
+    float hot = hotTemperature.load(std::memory_order_relaxed);
+    float busy = highLoad.load(std::memory_order_relaxed);
+    float temperature = thermal.cpuTemperature;
+    int previous = thermalLevel.load(std::memory_order_relaxed);
+    
+    // Уровень снижается только после выхода из полосы гистерезиса
+    int level = COOL;
+    if (temperature >= hot || (previous == HOT && temperature > hot - TEMPERATURE_HYSTERESIS) ||
+        (thermal.throttled & (Throttle::THROTTLED | Throttle::SOFT_TEMP_LIMIT)))
+        level = HOT;
+    else if (temperature >= warm || (previous >= WARM && temperature > warm - TEMPERATURE_HYSTERESIS) ||
+             load >= busy || (previous >= WARM && load > busy - LOAD_HYSTERESIS) ||
+             (thermal.throttled & (Throttle::UNDER_VOLTAGE | Throttle::FREQUENCY_CAPPED)))
+        level = WARM;
+    
+    if (level != previous)
+    {
+        thermalLevel.store(level, std::memory_order_relaxed);
+        LOG_INFOF("Sampling governor: CPU {} C, load {}, level {} -> {}", temperature, load, previous, level);
+    }
+}
+
+int64_t SamplingGovernor::OnSample(const PowerData& data, int64_t monotonicNs)
+{
+    int base = baseRate.load(std::memory_order_relaxed);
+    int rate = base;
+    GovernorMode next = GovernorMode::NORMAL;
+    
+    if (enabled.load(std::memory_order_acquire))
+    {
+        float near = nearThreshold.load(std::memory_order_relaxed);
+        float powerLimit = watchPower.load(std::memory_order_relaxed);
+        float currentLimit = watchCurrent.load(std::memory_order_relaxed);
+        bool nearLimit = (powerLimit > 0 && data.power >= near * powerLimit) ||
+                         (currentLimit > 0 && data.current >= near * currentLimit);
+        bool transient = hasPrevious &&
+                         std::fabs(data.power - previousPower) >= transientWatts.load(std::memory_order_relaxed);
+        hasPrevious = true;
+        previousPower = data.power;
+        
+        if (nearLimit || transient)
+            boostUntilNs = monotonicNs + static_cast<int64_t>(boostHoldMs.load(std::memory_order_relaxed)) * 1000000;
+        
+        int level = thermalLevel.load(std::memory_order_relaxed);
+        if (monotonicNs < boostUntilNs)
+        {
+            next = GovernorMode::BOOST;
+            rate = level == COOL ? std::max(base, boostRate.load(std::memory_order_relaxed)) : base;
+        }
+        else if (level == HOT)
+        {
+            next = GovernorMode::MINIMUM;
+            rate = std::min(base, minRate.load(std::memory_order_relaxed));
+        }
+        else if (level == WARM)
+        {
+            next = GovernorMode::REDUCED;
+            rate = std::max(std::min(base, minRate.load(std::memory_order_relaxed)), base / 2);
+        }
+    }
+    
+    if (next != mode.load(std::memory_order_relaxed) || rate != currentRate.load(std::memory_order_relaxed))
+    {
+        GovernorMetrics& metrics = Metrics();
+        metrics.changes[static_cast<int>(next)]->Add();
+        metrics.rate.Set(rate);
+        mode.store(next, std::memory_order_relaxed);
+        currentRate.store(rate, std::memory_order_relaxed);
+    }
+    
+    return 1000000 / rate;
+}
+
+bool SamplingGovernor::ShouldDeferBackgroundWork()
+{
+    if (!enabled.load(std::memory_order_acquire) || thermalLevel.load(std::memory_order_relaxed) == COOL)
+        return false;
+    
+    Metrics().deferred.Add();
+    return true;
+}
@@ -1,12 +1,21 @@
 #include "../includes/SensorManager.h"
+#include "../includes/RelayController.h"
 #include "../includes/Logger.h"
-#include <fstream>
+#include <algorithm>
 #include <sstream>
 
 bool SensorManager::initialize(const SensorConfig& config)
 {
     currentConfig = config;
     
+    // Температура нужна и без датчика мощности
+    thermalMonitor.SetListener([this](const ThermalSnapshot& snapshot) {
+        alertEngine.SetTemperature(snapshot.cpuTemperature);
+        governor.UpdateConditions(snapshot);
+    });
+    if (!thermalMonitor.Start(config.thermalIntervalMs))
+        LOG_WARNING("No thermal zones found, CPU temperature unavailable");
+    
     if (!config.enabled)
     {
         LOG_INFO("Sensor monitoring disabled");
@@ -18,13 +27,36 @@ bool SensorManager::initialize(const SensorConfig& config)
              ", Bus: " + std::to_string(config.bus) + 
              ", Addr: 0x" + std::to_string(config.address) + ")");
     
+    powerMonitor.setSimulationSeed(config.simulationSeed);
+    if (!config.loadProfile.empty())
+        powerMonitor.getLoadSimulator().LoadProfile(config.loadProfile);
+    
+    if (config.type == PowerMonitor::SENSOR_REPLAY)
+        powerMonitor.setReplaySource(config.replayFile, config.replaySpeed);
+    
+    if (!config.recordFile.empty() &&
+        recorder.Open(config.recordFile, PowerTrace::FormatFromPath(config.recordFile)))
+        powerMonitor.setRecorder(&recorder);
+    
+    alertEngine.Subscribe([this](const AlertEvent& event) { onAlert(event); });
+    alertEngine.Start();
+    publishAlertRules();
+    powerMonitor.setAlertEngine(&alertEngine);
+    protection.SetAlertEngine(&alertEngine);
+    powerMonitor.setProtection(&protection);
+    powerMonitor.setGovernor(&governor);
+    if (!config.applianceSignatures.empty())
+        applianceDetector.LoadSignatures(config.applianceSignatures);
+    powerMonitor.setApplianceDetector(&applianceDetector);
+    anomalyDetector.SetAlertEngine(&alertEngine);
+    powerMonitor.setAnomalyDetector(&anomalyDetector);
+    powerQuality.SetAlertEngine(&alertEngine);
+    powerMonitor.setPowerQuality(&powerQuality);
+    
     bool success = powerMonitor.initialize(config.type, config.bus, config.address, config.calibration);
     
     if (success)
-    {
         LOG_INFO("Sensor manager initialized successfully");
-        updateCpuTemperature();
-    }
     
     return success;
 }
@@ -32,45 +64,87 @@ bool SensorManager::initialize(const SensorConfig& config)
 void SensorManager::shutdown()
 {
     powerMonitor.stop();
+    powerMonitor.setAlertEngine(nullptr);
+    powerMonitor.setProtection(nullptr);
+    powerMonitor.setGovernor(nullptr);
+    powerMonitor.setApplianceDetector(nullptr);
+    powerMonitor.setAnomalyDetector(nullptr);
+    powerMonitor.setPowerQuality(nullptr);
+    alertEngine.Stop();
+    thermalMonitor.Stop();
+    
+    if (recorder.IsOpen())
+    {
+        powerMonitor.setRecorder(nullptr);
+        LOG_INFOF("Sensor trace closed: {} samples", recorder.GetRecordCount());
+        recorder.Close();
+    }
+    
     LOG_INFO("Sensor manager shut down");
 }
 
-void SensorManager::updateCpuTemperature()
+void SensorManager::publishAlertRules()
 {
-    std::ifstream tempFile("/sys/class/thermal/thermal_zone0/temp");
-    if (tempFile.is_open())
+    std::vector<AlertRule> rules;
     {
-        std::string line;
-        if (std::getline(tempFile, line))
-        {
-            try
-            {
-                cpuTemperature = std::stof(line) / 1000.0f;
-            }
-            catch (...)
-            {
-                cpuTemperature = 0.0f;
-            }
-        }
-        tempFile.close();
+        std::lock_guard<std::mutex> lock(rulesMutex);
+        
+        AlertRule warning;
+        warning.name = "power_warning";
+        warning.threshold = powerWarningThreshold;
+        warning.hysteresis = thresholdHysteresis;
+        warning.minDurationMs = thresholdMinDurationMs;
+        warning.cooldownMs = thresholdCooldownMs;
+        rules.push_back(warning);
+        
+        AlertRule critical = warning;
+        critical.name = "power_critical";
+        critical.threshold = powerCriticalThreshold;
+        rules.push_back(critical);
+        
+        AlertRule temperature;
+        temperature.name = "cpu_temperature";
+        temperature.metric = AlertMetric::TEMPERATURE;
+        temperature.threshold = temperatureWarningThreshold;
+        temperature.hysteresis = 2.0f;
+        temperature.cooldownMs = thresholdCooldownMs;
+        rules.push_back(temperature);
+        
+        rules.insert(rules.end(), customRules.begin(), customRules.end());
     }
+    
+    alertEngine.SetRules(std::move(rules));
 }
 
-void SensorManager::checkThresholds(const PowerData& data)
+// Поток рассылки событий, не поток опроса
+void SensorManager::onAlert(const AlertEvent& event)
 {
-    if (data.power >= powerCriticalThreshold && powerThresholdCallback)
-        powerThresholdCallback(data.power, powerCriticalThreshold);
-    else if (data.power >= powerWarningThreshold && powerThresholdCallback)
-        powerThresholdCallback(data.power, powerWarningThreshold);
-
-    if (cpuTemperature >= temperatureWarningThreshold && temperatureCallback)
-        temperatureCallback(cpuTemperature);
+    if (!event.raised)
+        return;
+    
+    std::string rule = event.rule;
+    if (rule == OverloadProtection::TRIP_RULE)
+    {
+        RelayController* relay = protection.GetRelay();
+        if (relay)
+            relay->CompleteEmergencyOff();
+    }
+    
+    std::lock_guard<std::mutex> lock(callbackMutex);
+    if ((rule == "power_warning" || rule == "power_critical") && powerThresholdCallback)
+        powerThresholdCallback(event.value, event.threshold);
+    else if (rule == "cpu_temperature" && temperatureCallback)
+        temperatureCallback(event.value);
+    else if (rule == OverloadProtection::TRIP_RULE && tripCallback)
+        tripCallback(event.value, event.threshold);
 }
 
 void SensorManager::setPowerThresholds(float warning, float critical)
 {
     powerWarningThreshold = warning;
     powerCriticalThreshold = critical;
+    publishAlertRules();
+    updateGovernorLimits();
     LOG_INFO("Power thresholds set: Warning=" + 
              std::to_string(warning) + "W, Critical=" + 
              std::to_string(critical) + "W");
@@ -79,30 +153,55 @@ void SensorManager::setPowerThresholds(float warning, float critical)
 void SensorManager::setTemperatureThreshold(float warning)
 {
     temperatureWarningThreshold = warning;
+    publishAlertRules();
     LOG_INFO("Temperature warning threshold set: " + std::to_string(warning) + "°C");
 }
 
-PowerData SensorManager::getPowerData()
+void SensorManager::setThresholdTuning(float hysteresis, int minDurationMs, int cooldownMs)
 {
-    PowerData data = powerMonitor.getCurrentData();
+    {
+        std::lock_guard<std::mutex> lock(rulesMutex);
+        thresholdHysteresis = std::max(0.0f, hysteresis);
+        thresholdMinDurationMs = std::max(0, minDurationMs);
+        thresholdCooldownMs = std::max(0, cooldownMs);
+    }
+    publishAlertRules();
+}
 
-    static auto lastTempUpdate = std::chrono::steady_clock::now();
-    auto now = std::chrono::steady_clock::now();
-    
-    if (std::chrono::duration_cast<std::chrono::seconds>(now - lastTempUpdate).count() >= 10)
+void SensorManager::setAlertRules(std::vector<AlertRule> rules)
+{
+    size_t count = rules.size();
     {
-        updateCpuTemperature();
-        lastTempUpdate = now;
+        std::lock_guard<std::mutex> lock(rulesMutex);
+        customRules = std::move(rules);
     }
-    
-    checkThresholds(data);
-    return data;
+    publishAlertRules();
+    LOG_INFO("Custom alert rules: " + std::to_string(count));
 }
 
-float SensorManager::getCpuTemperature()
+void SensorManager::subscribeAlerts(AlertListener listener)
 {
-    updateCpuTemperature();
-    return cpuTemperature;
+    alertEngine.Subscribe(std::move(listener));
+}
+
+PowerData SensorManager::getPowerData()
+{
+    return powerMonitor.getCurrentData();
+}
+
+float SensorManager::getCpuTemperature() const
+{
+    return thermalMonitor.GetCpuTemperature();
+}
+
+ThermalSnapshot SensorManager::getThermalSnapshot() const
+{
+    return thermalMonitor.GetSnapshot();
+}
+
+void SensorManager::setThermalInterval(int intervalMs)
+{
+    thermalMonitor.SetInterval(intervalMs);
 }
 
 std::map<std::string, float> SensorManager::getStatistics(int periodSeconds)
@@ -119,7 +218,7 @@ std::map<std::string, float> SensorManager::getStatistics(int periodSeconds)
     stats["power_factor"] = current.power_factor;
     stats["frequency"] = current.frequency;
     stats["energy"] = current.energy;
-    stats["temperature"] = cpuTemperature;
+    stats["temperature"] = thermalMonitor.GetCpuTemperature();
     stats["power_avg"] = powerMonitor.getAveragePower(periodSeconds);
     stats["power_max"] = powerMonitor.getMaxPower(periodSeconds);
     stats["power_min"] = powerMonitor.getMinPower(periodSeconds);
@@ -133,6 +232,28 @@ void SensorManager::resetEnergyCounter()
     powerMonitor.resetEnergy();
 }
 
+void SensorManager::restoreEnergyCounter(int64_t nanoWh)
+{
+    powerMonitor.restoreEnergy(nanoWh);
+}
+
+int64_t SensorManager::getEnergyNanoWh() const
+{
+    return powerMonitor.getEnergyNanoWh();
+}
+
+void SensorManager::setEnergySink(EnergyQueue* queue)
+{
+    powerMonitor.setEnergySink(queue);
+}
+
+void SensorManager::setSampleRate(int hz)
+{
+    powerMonitor.setSampleRate(hz);
+    if (hz > 0)
+        governor.SetBaseRate(hz);
+}
+
 void SensorManager::calibrate(float referenceValue)
 {
     LOG_INFO("Calibration requested with reference: " + std::to_string(referenceValue));
@@ -140,14 +261,104 @@ void SensorManager::calibrate(float referenceValue)
 
 void SensorManager::setPowerThresholdCallback(std::function<void(float, float)> callback)
 {
+    std::lock_guard<std::mutex> lock(callbackMutex);
     powerThresholdCallback = callback;
 }
 
 void SensorManager::setTemperatureCallback(std::function<void(float)> callback)
 {
+    std::lock_guard<std::mutex> lock(callbackMutex);
     temperatureCallback = callback;
 }
 
+void SensorManager::setTripCallback(std::function<void(float, float)> callback)
+{
+    std::lock_guard<std::mutex> lock(callbackMutex);
+    tripCallback = callback;
+}
+
+void SensorManager::setProtectionRelay(RelayController* relay)
+{
+    protection.SetRelay(relay);
+}
+
+void SensorManager::setProtectionSettings(const ProtectionSettings& settings)
+{
+    protection.Configure(settings);
+    protectionSettings = settings;
+    updateGovernorLimits();
+}
+
+void SensorManager::updateGovernorLimits()
+{
+    // Частота повышается у порога предупреждения и в зоне, где копится I²t
+    float power = powerWarningThreshold.load();
+    if (protectionSettings.enabled && protectionSettings.instantPower > 0)
+        power = std::min(power, protectionSettings.instantPower);
+    float current = protectionSettings.enabled ? protectionSettings.ratedCurrent : 0.0f;
+    governor.SetWatchLimits(power, current);
+}
+
+void SensorManager::setGovernorSettings(const GovernorSettings& settings)
+{
+    governor.Configure(settings);
+}
+
+bool SensorManager::shouldDeferBackgroundWork()
+{
+    return governor.ShouldDeferBackgroundWork();
+}
+
+GovernorMode SensorManager::getSamplingMode() const
+{
+    return governor.GetMode();
+}
+
+int SensorManager::getCurrentSampleRate() const
+{
+    return governor.GetRate();
+}
+
+void SensorManager::setApplianceDetection(const NILMSettings& settings)
+{
+    applianceDetector.Configure(settings);
+}
+
+ApplianceSnapshot SensorManager::getAppliances() const
+{
+    return applianceDetector.GetSnapshot();
+}
+
+void SensorManager::setAnomalyDetection(const AnomalySettings& settings)
+{
+    anomalyDetector.Configure(settings);
+}
+
+void SensorManager::setSeasonalBaseline(const float (&watts)[AnomalyDetector::WEEK_HOURS])
+{
+    anomalyDetector.SetSeasonalBaseline(watts);
+}
+
+AnomalySnapshot SensorManager::getAnomalies() const
+{
+    return anomalyDetector.GetSnapshot();
+}
+
+void SensorManager::setPowerQualitySettings(const PQSettings& settings)
+{
+    powerQuality.Configure(settings);
+}
+
+PQSnapshot SensorManager::getPowerQuality() const
+{
+    return powerQuality.GetSnapshot();
+}
+
+ProtectionStatus SensorManager::getProtectionStatus() const
+{
+    return protection.GetStatus();
+}
+
 bool SensorManager::isPowerSensorActive() const
 {
     return currentConfig.enabled && powerMonitor.isDataValid();
@@ -171,5 +382,5 @@ std::string SensorManager::getSensorStatus() const
 void SensorManager::simulatePowerSpike(float power, int durationMs)
 {
     LOG_INFO("Simulating power spike: " + std::to_string(power) + "W for " + std::to_string(durationMs) + "ms");
-    powerMonitor.simulateLoad(power);
+    powerMonitor.simulatePowerSpike(power, durationMs);
 }
\ No newline at end of file
@@ -1,21 +1,30 @@
 #include "../includes/Statistics.h"
 #include "../includes/Logger.h"
+#include "../includes/Metrics.h"
 #include <iomanip>
 #include <sstream>
 #include <fstream>
 #include <ctime>
-
-#ifdef RASPBERRY_PI
+#include <algorithm>
+#include <charconv>
+#include <cstring>
 #include <json/json.h>
-#endif
 
-Statistics::Statistics() : peakHours({8, 23}) {}
+static constexpr size_t EXPORT_BUFFER_SIZE = 64 * 1024;
+static constexpr size_t HISTORY_CAPACITY = 43200;
+
+Statistics::Statistics() : peakHours({8, 23})
+{
+    tariffTable = TariffTable::TwoRate(tariffPeak, tariffOffpeak, peakHours.first, peakHours.second);
+}
 
 void Statistics::setTariffs(float peak, float offpeak)
 {
     std::lock_guard<std::mutex> lock(statsMutex);
     tariffPeak = peak;
     tariffOffpeak = offpeak;
+    tariffTable = TariffTable::TwoRate(tariffPeak, tariffOffpeak, peakHours.first, peakHours.second);
+    recalculateCostsLocked();
     LOG_INFO("Tariffs set: Peak=" + std::to_string(peak) + ", Offpeak=" + std::to_string(offpeak));
 }
 
@@ -23,30 +32,33 @@ void Statistics::setPeakHours(int start, int end)
 {
     std::lock_guard<std::mutex> lock(statsMutex);
     peakHours = {start, end};
+    tariffTable = TariffTable::TwoRate(tariffPeak, tariffOffpeak, peakHours.first, peakHours.second);
+    recalculateCostsLocked();
     LOG_INFO("Peak hours set: " + std::to_string(start) + ":00 - " + std::to_string(end) + ":00");
 }
 
 void Statistics::addEnergyReading(float energy)
+{
+    addEnergyReading(energy, std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+void Statistics::addEnergyReading(float energy, uint64_t timestamp)
 {
     std::lock_guard<std::mutex> lock(statsMutex);
     
     EnergyRecord record;
-    record.timestamp = std::chrono::duration_cast<std::chrono::seconds>(
-        std::chrono::system_clock::now().time_since_epoch()).count();
+    record.timestamp = timestamp;
     record.energy = energy;
-    
-    std::time_t now = std::time(nullptr);
-    std::tm* localTime = std::localtime(&now);
-    int currentHour = localTime->tm_hour;
-    
-    record.cost = calculateCost(energy, currentHour);
+    record.cost = calculateCost(energy, record.timestamp);
     
     energyHistory.push_back(record);
     
-    if (energyHistory.size() > 43200)
+    if (energyHistory.size() > HISTORY_CAPACITY)
         energyHistory.erase(energyHistory.begin());
-
+    
     updateDailyStats(record);
+    forecaster.AddReading(record.energy, record.cost, record.timestamp, tariffTable);
 }
 
 void Statistics::addPowerReading(float power, int durationSeconds)
@@ -58,17 +70,79 @@ void Statistics::addPowerReading(float power, int durationSeconds)
     addEnergyReading(energy);
 }
 
-void Statistics::updateDailyStats(const EnergyRecord& record)
+size_t Statistics::drainEnergyQueue(bool flush)
 {
-    std::time_t ts = static_cast<std::time_t>(record.timestamp);
-    std::tm* time = std::localtime(&ts);
+    // Единственный потребитель очереди; дельты сводятся в записи по минутам
+    size_t drained = 0;
+    EnergyDelta delta;
     
-    char dateStr[11];
-    std::strftime(dateStr, sizeof(dateStr), "%Y-%m-%d", time);
-    std::string date(dateStr);
+    while (energyQueue.pop(delta))
+    {
+        uint64_t minute = delta.timestamp / 60000;
+        if (pendingMinute != 0 && minute != pendingMinute && pendingEnergyNanoWh != 0)
+        {
+            addEnergyReading(static_cast<float>(static_cast<double>(pendingEnergyNanoWh) /
+                                                EnergyAccumulator::NANO_WH_PER_KWH),
+                             pendingMinute * 60);
+            pendingEnergyNanoWh = 0;
+        }
+        
+        pendingMinute = minute;
+        pendingEnergyNanoWh += delta.nanoWh;
+        drained++;
+        
+        std::lock_guard<std::mutex> lock(statsMutex);
+        totalEnergyNanoWh += delta.nanoWh;
+    }
     
-    int hour = time->tm_hour;
-    bool isPeakHour = (hour >= peakHours.first && hour < peakHours.second);
+    if (flush && pendingEnergyNanoWh != 0)
+    {
+        addEnergyReading(static_cast<float>(static_cast<double>(pendingEnergyNanoWh) /
+                                            EnergyAccumulator::NANO_WH_PER_KWH),
+                         pendingMinute * 60);
+        pendingEnergyNanoWh = 0;
+    }
+    
+    // Дельты приходят по порядку и раз в секунду даже без нагрузки: записей раньше
+    // текущей минуты больше не будет, и часы без потребления закрываются здесь
+    if (pendingMinute != 0)
+    {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        forecaster.Advance(pendingMinute * 60, tariffTable);
+    }
+    
+    static MetricsRegistry& metrics = MetricsRegistry::GetInstance();
+    static Counter& deltaCounter = metrics.GetCounter("smart_plug_energy_deltas_total", "Energy deltas drained from the sampler");
+    static Gauge& energyGauge = metrics.GetGauge("smart_plug_energy_total_kwh", "Energy counted since the counter was reset");
+    static Gauge& historyGauge = metrics.GetGauge("smart_plug_history_records", "Per-minute records held in memory");
+    
+    deltaCounter.Add(drained);
+    {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        energyGauge.Set(static_cast<double>(totalEnergyNanoWh) / EnergyAccumulator::NANO_WH_PER_KWH);
+        historyGauge.Set(static_cast<double>(energyHistory.size()));
+    }
+    
+    return drained;
+}
+
+double Statistics::getTotalEnergyKWh()
+{
+    std::lock_guard<std::mutex> lock(statsMutex);
+    return static_cast<double>(totalEnergyNanoWh) / EnergyAccumulator::NANO_WH_PER_KWH;
+}
+
+void Statistics::restoreTotalEnergy(int64_t nanoWh)
+{
+    std::lock_guard<std::mutex> lock(statsMutex);
+    totalEnergyNanoWh = nanoWh;
+}
+
+void Statistics::updateDailyStats(const EnergyRecord& record)
+{
+    const LocalHour& local = tariffTable.resolve(record.timestamp);
+    std::string date(local.date);
+    bool isPeakHour = tariffTable.isPeakSlot(local.slot);
     
     if (dailyStats.find(date) == dailyStats.end())
     {
@@ -89,15 +163,110 @@ void Statistics::updateDailyStats(const EnergyRecord& record)
         stats.energy_peak += record.energy;
     else
         stats.energy_offpeak += record.energy;
-
+    
     stats.cost_total += record.cost;
     stats.usage_hours = static_cast<int>(stats.energy_total * 1000.0f / 60.0f);
 }
 
-float Statistics::calculateCost(float energy, int hour)
+float Statistics::calculateCost(float energy, uint64_t timestamp)
+{
+    return energy * tariffTable.priceAt(timestamp);
+}
+
+void Statistics::setTariffTable(const TariffTable& table)
+{
+    std::lock_guard<std::mutex> lock(statsMutex);
+    tariffTable = table;
+    tariffTable.compile();
+    recalculateCostsLocked();
+    LOG_INFO("Tariff table set: " + std::to_string(tariffTable.getBandCount()) + " bands, price " +
+             std::to_string(tariffTable.getMinPrice()) + " - " + std::to_string(tariffTable.getMaxPrice()));
+}
+
+void Statistics::recalculateCosts()
+{
+    std::lock_guard<std::mutex> lock(statsMutex);
+    recalculateCostsLocked();
+}
+
+void Statistics::recalculateCostsLocked()
+{
+    if (energyHistory.empty())
+    {
+        forecaster.Reprice(tariffTable);
+        return;
+    }
+    
+    // Сначала слоты тарифа (localtime раз в час), затем плотный проход умножения
+    size_t count = energyHistory.size();
+    std::vector<float> prices(count);
+    std::vector<uint8_t> peakFlags(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        int slot = tariffTable.resolve(energyHistory[i].timestamp).slot;
+        prices[i] = tariffTable.priceOfSlot(slot);
+        peakFlags[i] = tariffTable.isPeakSlot(slot) ? 1 : 0;
+    }
+    
+    EnergyRecord* records = energyHistory.data();
+    for (size_t i = 0; i < count; i++)
+        records[i].cost = records[i].energy * prices[i];
+    
+    // Дневная статистика пересчитывается только за дни, полностью лежащие в истории
+    std::string firstDate = tariffTable.resolve(records[0].timestamp).date;
+    bool firstDayPartial = count >= HISTORY_CAPACITY;
+    
+    for (auto it = dailyStats.lower_bound(firstDate); it != dailyStats.end(); ++it)
+    {
+        if (firstDayPartial && it->first == firstDate)
+            continue;
+        it->second.cost_total = 0;
+        it->second.energy_peak = 0;
+        it->second.energy_offpeak = 0;
+    }
+    
+    for (size_t i = 0; i < count; i++)
+    {
+        const LocalHour& local = tariffTable.resolve(records[i].timestamp);
+        if (firstDayPartial && firstDate == local.date)
+            continue;
+        
+        auto it = dailyStats.find(local.date);
+        if (it == dailyStats.end())
+            continue;
+        
+        it->second.cost_total += records[i].cost;
+        if (peakFlags[i])
+            it->second.energy_peak += records[i].energy;
+        else
+            it->second.energy_offpeak += records[i].energy;
+    }
+    
+    // Стоимость с начала периодов прогноза; начало месяца может быть старше истории
+    for (ForecastPeriod period : {ForecastPeriod::DAY, ForecastPeriod::WEEK, ForecastPeriod::MONTH})
+    {
+        uint64_t from = forecaster.GetPeriodStart(period);
+        auto first = std::lower_bound(energyHistory.begin(), energyHistory.end(), from,
+                                      [](const EnergyRecord& record, uint64_t time) { return record.timestamp < time; });
+        double cost = 0.0;
+        for (auto it = first; it != energyHistory.end(); ++it)
+            cost += it->cost;
+        forecaster.SetCost(period, cost);
+    }
+    forecaster.Reprice(tariffTable);
+}
+
+void Statistics::setForecastSmoothing(float alpha, float gamma)
 {
-    bool isPeakHour = (hour >= peakHours.first && hour < peakHours.second);
-    return energy * (isPeakHour ? tariffPeak : tariffOffpeak);
+    std::lock_guard<std::mutex> lock(statsMutex);
+    forecaster.Configure(alpha, gamma);
+}
+
+EnergyForecast Statistics::getForecast()
+{
+    // Только чтение: часы прогноза сдвигает drainEnergyQueue
+    std::lock_guard<std::mutex> lock(statsMutex);
+    return forecaster.GetForecast();
 }
 
 std::map<std::string, float> Statistics::getTodayStats()
@@ -241,51 +410,208 @@ std::vector<EnergyRecord> Statistics::getHistory(int hours)
 {
     std::lock_guard<std::mutex> lock(statsMutex);
     
-    std::vector<EnergyRecord> result;
     uint64_t cutoff = std::chrono::duration_cast<std::chrono::seconds>(
         std::chrono::system_clock::now().time_since_epoch()
     ).count() - (hours * 3600);
     
-    for (const auto& record : energyHistory)
-        if (record.timestamp >= cutoff)
-            result.push_back(record);
+    auto first = std::lower_bound(energyHistory.begin(), energyHistory.end(), cutoff,
+        [](const EnergyRecord& record, uint64_t ts) { return record.timestamp < ts; });
     
-    return result;
+    return std::vector<EnergyRecord>(first, energyHistory.end());
 }
 
-bool Statistics::exportToCSV(const std::string& filename, int days)
+size_t Statistics::forEachHistoryBucket(uint64_t from, uint64_t to, uint64_t step,
+                                        const std::function<void(const HistoryBucket&)>& visitor)
 {
+    if (step == 0 || to <= from)
+        return 0;
+    
     std::lock_guard<std::mutex> lock(statsMutex);
     
-    std::ofstream file(filename);
+    // energyHistory растёт только в конец, поэтому отсортирован по времени
+    auto byTime = [](const EnergyRecord& record, uint64_t ts) { return record.timestamp < ts; };
+    auto first = std::lower_bound(energyHistory.begin(), energyHistory.end(), from, byTime);
+    auto last = std::lower_bound(first, energyHistory.end(), to, byTime);
+    
+    size_t emitted = 0;
+    HistoryBucket bucket {0, 0.0f, 0.0f, 0};
+    
+    for (auto it = first; it != last; ++it)
+    {
+        uint64_t bucketStart = from + ((it->timestamp - from) / step) * step;
+        if (bucket.samples > 0 && bucketStart != bucket.timestamp)
+        {
+            visitor(bucket);
+            emitted++;
+            bucket = HistoryBucket{0, 0.0f, 0.0f, 0};
+        }
+        
+        bucket.timestamp = bucketStart;
+        bucket.energy += it->energy;
+        bucket.cost += it->cost;
+        bucket.samples++;
+    }
+    
+    if (bucket.samples > 0)
+    {
+        visitor(bucket);
+        emitted++;
+    }
+    
+    return emitted;
+}
+
+std::vector<DailyStats> Statistics::snapshotDailyStats(int days)
+{
+    std::string cutoff;
+    if (days > 0)
+    {
+        std::time_t start = std::time(nullptr) - static_cast<std::time_t>(days - 1) * 24 * 3600;
+        char startStr[11];
+        std::strftime(startStr, sizeof(startStr), "%Y-%m-%d", std::localtime(&start));
+        cutoff = startStr;
+    }
+    
+    std::vector<DailyStats> rows;
+    std::lock_guard<std::mutex> lock(statsMutex);
+    rows.reserve(dailyStats.size());
+    for (auto it = dailyStats.lower_bound(cutoff); it != dailyStats.end(); ++it)
+        rows.push_back(it->second);
+    
+    return rows;
+}
+
+std::unique_ptr<StatisticsExport> Statistics::createExport(int days, StatisticsExport::Format format)
+{
+    return std::make_unique<StatisticsExport>(snapshotDailyStats(days), format);
+}
+
+bool Statistics::exportToFile(const std::string& filename, int days, StatisticsExport::Format format)
+{
+    auto exporter = createExport(days, format);
+    
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
     if (!file.is_open())
     {
-        LOG_ERROR("Failed to open CSV file: " + filename);
+        LOG_ERROR("Failed to open export file: " + filename);
         return false;
     }
     
-    file << "Date,Energy Total (kWh),Energy Peak (kWh),Energy Offpeak (kWh),"
-         << "Cost Total (RUB),Usage Hours\n";
+    std::vector<char> buffer(EXPORT_BUFFER_SIZE);
+    while (size_t written = exporter->read(buffer.data(), buffer.size()))
+        file.write(buffer.data(), static_cast<std::streamsize>(written));
     
-    for (const auto& pair : dailyStats)
+    file.close();
+    if (!file)
     {
-        const DailyStats& stats = pair.second;
-        file << stats.date << ","
-             << stats.energy_total << ","
-             << stats.energy_peak << ","
-             << stats.energy_offpeak << ","
-             << stats.cost_total << ","
-             << stats.usage_hours << "\n";
+        LOG_ERROR("Failed to write export file: " + filename);
+        return false;
     }
     
-    file.close();
-    LOG_INFO("Statistics exported to CSV: " + filename);
+    LOG_INFO("Statistics exported (" + std::to_string(exporter->getRowCount()) + " days) to: " + filename);
     return true;
 }
 
+bool Statistics::exportToCSV(const std::string& filename, int days)
+{
+    return exportToFile(filename, days, StatisticsExport::FORMAT_CSV);
+}
+
+bool Statistics::exportToBinary(const std::string& filename, int days)
+{
+    return exportToFile(filename, days, StatisticsExport::FORMAT_BINARY);
+}
+
+StatisticsExport::StatisticsExport(std::vector<DailyStats> snapshot, Format exportFormat)
+    : rows(std::move(snapshot)), format(exportFormat)
+{
+    if (format == FORMAT_BINARY)
+        appendBinary();
+    else
+        pending = "Date,Energy Total (kWh),Energy Peak (kWh),Energy Offpeak (kWh),"
+                  "Cost Total (RUB),Usage Hours\n";
+}
+
+size_t StatisticsExport::read(char* buffer, size_t size)
+{
+    fillPending(size);
+    
+    size_t count = std::min(size, pending.size() - pendingOffset);
+    std::memcpy(buffer, pending.data() + pendingOffset, count);
+    pendingOffset += count;
+    return count;
+}
+
+void StatisticsExport::fillPending(size_t want)
+{
+    if (pending.size() - pendingOffset >= want || nextRow >= rows.size())
+        return;
+    
+    pending.erase(0, pendingOffset);
+    pendingOffset = 0;
+    pending.reserve(want + 128);
+    
+    while (pending.size() < want && nextRow < rows.size())
+        appendCSVRow(rows[nextRow++]);
+}
+
+void StatisticsExport::appendCSVRow(const DailyStats& stats)
+{
+    char line[160];
+    char* p = line;
+    char* end = line + sizeof(line);
+    
+    std::memcpy(p, stats.date.data(), std::min<size_t>(stats.date.size(), 10));
+    p += std::min<size_t>(stats.date.size(), 10);
+    
+    for (float value : {stats.energy_total, stats.energy_peak, stats.energy_offpeak, stats.cost_total})
+    {
+        *p++ = ',';
+        p = std::to_chars(p, end, value).ptr;
+    }
+    *p++ = ',';
+    p = std::to_chars(p, end, stats.usage_hours).ptr;
+    *p++ = '\n';
+    
+    pending.append(line, p);
+}
+
+void StatisticsExport::appendBinary()
+{
+    // "SPS1", u32 count, затем колонки по count элементов:
+    // u32 date (YYYYMMDD), f32 energy_total, f32 energy_peak, f32 energy_offpeak,
+    // f32 cost_total, i32 usage_hours
+    uint32_t count = static_cast<uint32_t>(rows.size());
+    pending.reserve(8 + rows.size() * 24);
+    pending.append("SPS1", 4);
+    pending.append(reinterpret_cast<const char*>(&count), sizeof(count));
+    
+    auto appendColumn = [this](auto getter) {
+        for (const DailyStats& stats : rows)
+        {
+            auto value = getter(stats);
+            pending.append(reinterpret_cast<const char*>(&value), sizeof(value));
+        }
+    };
+    
+    appendColumn([](const DailyStats& stats) {
+        uint32_t date = 0;
+        for (char c : stats.date)
+            if (c >= '0' && c <= '9')
+                date = date * 10 + static_cast<uint32_t>(c - '0');
+        return date;
+    });
+    appendColumn([](const DailyStats& stats) { return stats.energy_total; });
+    appendColumn([](const DailyStats& stats) { return stats.energy_peak; });
+    appendColumn([](const DailyStats& stats) { return stats.energy_offpeak; });
+    appendColumn([](const DailyStats& stats) { return stats.cost_total; });
+    appendColumn([](const DailyStats& stats) { return static_cast<int32_t>(stats.usage_hours); });
+    
+    nextRow = rows.size();
+}
+
 std::string Statistics::getJSONReport(int days)
 {
-#ifdef RASPBERRY_PI
     Json::Value root;
     Json::Value today(Json::objectValue);
     Json::Value week(Json::objectValue);
@@ -303,18 +629,31 @@ std::string Statistics::getJSONReport(int days)
     
     for (const auto& pair : monthStats)
         month[pair.first] = pair.second;
-
+    
     root["today"] = today;
     root["week"] = week;
     root["month"] = month;
+    
+    // Посуточные строки за последние days дней
+    Json::Value daily(Json::arrayValue);
+    for (const DailyStats& stats : snapshotDailyStats(days))
+    {
+        Json::Value row;
+        row["date"] = stats.date;
+        row["energy_total"] = stats.energy_total;
+        row["energy_peak"] = stats.energy_peak;
+        row["energy_offpeak"] = stats.energy_offpeak;
+        row["cost_total"] = stats.cost_total;
+        row["usage_hours"] = stats.usage_hours;
+        daily.append(row);
+    }
+    root["days"] = days;
+    root["daily"] = daily;
     root["timestamp"] = static_cast<int>(std::time(nullptr));
     
     Json::StreamWriterBuilder builder;
     builder["indentation"] = "  ";
     return Json::writeString(builder, root);
-#else
-    return "";
-#endif
 }
 
 void Statistics::clearHistory()
@@ -0,0 +1,252 @@
+#include "../includes/TariffTable.h"
+
+#include <algorithm>
+#include <ctime>
+#include <cstdlib>
+#include <sstream>
+
+static const char* const DAY_NAMES[7] = {"mon", "tue", "wed", "thu", "fri", "sat", "sun"};
+
+TariffTable::TariffTable()
+{
+    clear(0.0f);
+    compile();
+}
+
+void TariffTable::clear(float price)
+{
+    defaultPrice = price;
+    bands.clear();
+    holidays.reset();
+    seasonOfMonth.fill(0);
+}
+
+void TariffTable::setSeasons(const std::array<uint8_t, 12>& monthToSeason)
+{
+    for (size_t i = 0; i < seasonOfMonth.size(); i++)
+        seasonOfMonth[i] = std::min<uint8_t>(monthToSeason[i], MAX_SEASONS - 1);
+}
+
+void TariffTable::addBand(const TariffBand& band)
+{
+    bands.push_back(band);
+}
+
+void TariffTable::addHoliday(int month, int day)
+{
+    if (month >= 1 && month <= 12 && day >= 1 && day <= 31)
+        holidays.set((month - 1) * 32 + day);
+}
+
+void TariffTable::compile()
+{
+    prices.fill(defaultPrice);
+    
+    // Полосы применяются по порядку, более поздние перекрывают ранние
+    for (const TariffBand& band : bands)
+        for (int season = 0; season < MAX_SEASONS; season++)
+        {
+            if (!(band.seasonsMask & (1 << season)))
+                continue;
+            
+            for (int day = 0; day < 7; day++)
+            {
+                if (!(band.daysMask & (1 << day)))
+                    continue;
+                
+                for (int hour = 0; hour < 24; hour++)
+                {
+                    bool inside = band.startHour <= band.endHour
+                        ? (hour >= band.startHour && hour < band.endHour)
+                        : (hour >= band.startHour || hour < band.endHour);
+                    if (inside)
+                        prices[season * HOURS_PER_WEEK + day * 24 + hour] = band.price;
+                }
+            }
+        }
+    
+    for (int season = 0; season < MAX_SEASONS; season++)
+    {
+        auto first = prices.begin() + season * HOURS_PER_WEEK;
+        float minPrice = *std::min_element(first, first + HOURS_PER_WEEK);
+        for (int i = 0; i < HOURS_PER_WEEK; i++)
+            peak[season * HOURS_PER_WEEK + i] = first[i] > minPrice ? 1 : 0;
+    }
+    
+    cached.hourStart = UINT64_MAX;
+}
+
+TariffTable TariffTable::TwoRate(float peakPrice, float offpeakPrice, int peakStart, int peakEnd)
+{
+    TariffTable table;
+    table.clear(offpeakPrice);
+    table.addBand(TariffBand{0x7F, 0xFF, peakStart, peakEnd, peakPrice});
+    table.compile();
+    return table;
+}
+
+const LocalHour& TariffTable::resolve(uint64_t timestamp) const
+{
+    // localtime вызывается не чаще раза в час, остальное - поиск в таблице
+    if (timestamp - cached.hourStart >= 3600)
+        resolveSlow(timestamp);
+    return cached;
+}
+
+void TariffTable::resolveSlow(uint64_t timestamp) const
+{
+    std::time_t ts = static_cast<std::time_t>(timestamp);
+    std::tm local {};
+    localtime_r(&ts, &local);
+    
+    cached.hourStart = timestamp - static_cast<uint64_t>(local.tm_min * 60 + local.tm_sec);
+    cached.hour = local.tm_hour;
+    cached.weekday = (local.tm_wday + 6) % 7;
+    cached.holiday = holidays.test(local.tm_mon * 32 + local.tm_mday);
+    std::strftime(cached.date, sizeof(cached.date), "%Y-%m-%d", &local);
+    
+    int day = cached.holiday ? 6 : cached.weekday;
+    cached.slot = seasonOfMonth[local.tm_mon] * HOURS_PER_WEEK + day * 24 + local.tm_hour;
+}
+
+bool TariffTable::parseDays(const std::string& spec, uint8_t& mask)
+{
+    auto dayIndex = [](const std::string& name) {
+        for (int i = 0; i < 7; i++)
+            if (name == DAY_NAMES[i])
+                return i;
+        return -1;
+    };
+    
+    mask = 0;
+    std::stringstream ss(spec);
+    std::string item;
+    while (std::getline(ss, item, ','))
+    {
+        size_t dash = item.find('-');
+        int first = dayIndex(item.substr(0, dash));
+        int last = dash == std::string::npos ? first : dayIndex(item.substr(dash + 1));
+        if (first < 0 || last < 0)
+            return false;
+        
+        for (int day = first; ; day = (day + 1) % 7)
+        {
+            mask |= static_cast<uint8_t>(1 << day);
+            if (day == last)
+                break;
+        }
+    }
+    return mask != 0;
+}
+
+bool TariffTable::parseBand(const std::string& spec, TariffBand& band)
+{
+    // Формат: дни/часы/цена[/сезоны], например "mon-fri/07-23/5.5/0,1"
+    std::vector<std::string> fields;
+    std::stringstream ss(spec);
+    std::string field;
+    while (std::getline(ss, field, '/'))
+        fields.push_back(field);
+    
+    if (fields.size() < 3 || fields.size() > 4)
+        return false;
+    
+    if (!parseDays(fields[0], band.daysMask))
+        return false;
+    
+    size_t dash = fields[1].find('-');
+    if (dash == std::string::npos)
+        return false;
+    band.startHour = std::atoi(fields[1].substr(0, dash).c_str());
+    band.endHour = std::atoi(fields[1].substr(dash + 1).c_str());
+    if (band.startHour < 0 || band.startHour > 23 || band.endHour < 0 || band.endHour > 24)
+        return false;
+    if (band.endHour == 24)
+        band.endHour = band.startHour == 0 ? 24 : 0;
+    
+    char* end = nullptr;
+    band.price = std::strtof(fields[2].c_str(), &end);
+    if (end == fields[2].c_str() || band.price < 0)
+        return false;
+    
+    band.seasonsMask = 0xFF;
+    if (fields.size() == 4)
+    {
+        band.seasonsMask = 0;
+        std::stringstream seasons(fields[3]);
+        std::string season;
+        while (std::getline(seasons, season, ','))
+        {
+            int index = std::atoi(season.c_str());
+            if (index < 0 || index >= MAX_SEASONS)
+                return false;
+            band.seasonsMask |= static_cast<uint8_t>(1 << index);
+        }
+    }
+    
+    return true;
+}
+
+bool TariffTable::parseBands(const std::string& specs)
+{
+    std::stringstream ss(specs);
+    std::string spec;
+    while (std::getline(ss, spec, ';'))
+    {
+        if (spec.empty())
+            continue;
+        
+        TariffBand band;
+        if (!parseBand(spec, band))
+            return false;
+        addBand(band);
+    }
+    return true;
+}
+
+bool TariffTable::parseSeasons(const std::string& spec)
+{
+    // Двенадцать индексов сезона по месяцам: "1,1,0,0,0,0,0,0,0,0,1,1"
+    std::array<uint8_t, 12> months {};
+    std::stringstream ss(spec);
+    std::string item;
+    size_t count = 0;
+    while (std::getline(ss, item, ','))
+    {
+        int season = std::atoi(item.c_str());
+        if (count >= months.size() || season < 0 || season >= MAX_SEASONS)
+            return false;
+        months[count++] = static_cast<uint8_t>(season);
+    }
+    
+    if (count != months.size())
+        return false;
+    
+    setSeasons(months);
+    return true;
+}
+
+bool TariffTable::parseHolidays(const std::string& spec)
+{
+    // Даты "MM-DD" через запятую, праздники тарифицируются как воскресенье
+    std::stringstream ss(spec);
+    std::string item;
+    while (std::getline(ss, item, ','))
+    {
+        size_t dash = item.find('-');
+        if (dash == std::string::npos)
+            return false;
+        addHoliday(std::atoi(item.substr(0, dash).c_str()), std::atoi(item.substr(dash + 1).c_str()));
+    }
+    return true;
+}
+
+float TariffTable::getMinPrice() const
+{
+    return *std::min_element(prices.begin(), prices.end());
+}
+
+float TariffTable::getMaxPrice() const
+{
+    return *std::max_element(prices.begin(), prices.end());
+}
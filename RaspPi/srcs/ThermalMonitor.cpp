@@ -0,0 +1,185 @@
+#include "../includes/ThermalMonitor.h"
+#include "../includes/Logger.h"
+#include "../includes/Metrics.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace
+{
+    // Файл sysfs с одним числом; позиция не сдвигается, поэтому fd читается повторно
+    bool ReadNumber(int fd, long& value, int base)
+    {
+        char buffer[32];
+        ssize_t length = pread(fd, buffer, sizeof(buffer) - 1, 0);
+        if (length <= 0)
+            return false;
+        
+        buffer[length] = '\0';
+        char* end = nullptr;
+        value = std::strtol(buffer, &end, base);
+        return end != buffer;
+    }
+}
+
+ThermalMonitor::~ThermalMonitor()
+{
+    Stop();
+}
+
+void ThermalMonitor::OpenSources()
+{
+    std::string thermalDir = root + "/class/thermal";
+    std::vector<int> zoneNumbers;
+    
+    if (DIR* dir = opendir(thermalDir.c_str()))
+    {
+        while (dirent* entry = readdir(dir))
+            if (std::strncmp(entry->d_name, "thermal_zone", 12) == 0)
+                zoneNumbers.push_back(std::atoi(entry->d_name + 12));
+        closedir(dir);
+    }
+    std::sort(zoneNumbers.begin(), zoneNumbers.end());
+    
+    zoneCount = 0;
+    cpuZone = 0;
+    for (int number : zoneNumbers)
+    {
+        if (zoneCount == ThermalSnapshot::MAX_ZONES)
+        {
+            LOG_WARNINGF("Only the first {} thermal zones are monitored", ThermalSnapshot::MAX_ZONES);
+            break;
+        }
+        
+        std::string zoneDir = thermalDir + "/thermal_zone" + std::to_string(number);
+        int fd = open((zoneDir + "/temp").c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            continue;
+        
+        std::string type = "zone" + std::to_string(number);
+        std::ifstream typeFile(zoneDir + "/type");
+        std::getline(typeFile, type);
+        
+        ThermalZone& zone = zoneInfo[zoneCount];
+        std::memset(&zone, 0, sizeof(zone));
+        std::strncpy(zone.type, type.c_str(), sizeof(zone.type) - 1);
+        if (type.find("cpu") != std::string::npos && std::strstr(zoneInfo[cpuZone].type, "cpu") == nullptr)
+            cpuZone = zoneCount;
+        
+        zoneFds[zoneCount++] = fd;
+    }
+    
+    throttleFd = open((root + "/devices/platform/soc/soc:firmware/get_throttled").c_str(), O_RDONLY | O_CLOEXEC);
+    frequencyFd = open((root + "/devices/system/cpu/cpu0/cpufreq/scaling_cur_freq").c_str(), O_RDONLY | O_CLOEXEC);
+    
+    LOG_INFOF("Thermal monitor: {} zones, throttle state {}, CPU frequency {}", zoneCount,
+              throttleFd >= 0 ? "available" : "unavailable", frequencyFd >= 0 ? "available" : "unavailable");
+}
+
+void ThermalMonitor::CloseSources()
+{
+    for (int i = 0; i < zoneCount; ++i)
+        close(zoneFds[i]);
+    zoneCount = 0;
+    
+    if (throttleFd >= 0)
+        close(throttleFd);
+    if (frequencyFd >= 0)
+        close(frequencyFd);
+    throttleFd = -1;
+    frequencyFd = -1;
+}
+
+bool ThermalMonitor::Start(int intervalMs, const std::string& sysfsRoot)
+{
+    if (running.load())
+        return true;
+    
+    root = sysfsRoot;
+    SetInterval(intervalMs);
+    OpenSources();
+    Sample();
+    
+    running = true;
+    sampler = std::thread(&ThermalMonitor::SamplerLoop, this);
+    return zoneCount > 0;
+}
+
+void ThermalMonitor::Stop()
+{
+    if (!running.exchange(false))
+        return;
+    
+    wakeCondition.notify_one();
+    if (sampler.joinable())
+        sampler.join();
+    CloseSources();
+}
+
+void ThermalMonitor::SetInterval(int intervalMs)
+{
+    interval.store(std::max(100, intervalMs), std::memory_order_relaxed);
+    wakeCondition.notify_one();
+}
+
+void ThermalMonitor::Sample()
+{
+    static MetricsRegistry& metrics = MetricsRegistry::GetInstance();
+    static Gauge& temperatureGauge = metrics.GetGauge("smart_plug_cpu_temperature_celsius", "CPU temperature");
+    static Gauge& throttledGauge = metrics.GetGauge("smart_plug_cpu_throttled", "Raspberry Pi throttling flags (get_throttled)");
+    
+    ThermalSnapshot next {};
+    next.zoneCount = zoneCount;
+    for (int i = 0; i < zoneCount; ++i)
+    {
+        next.zones[i] = zoneInfo[i];
+        long milliCelsius = 0;
+        next.zones[i].valid = ReadNumber(zoneFds[i], milliCelsius, 10);
+        next.zones[i].celsius = next.zones[i].valid ? static_cast<float>(milliCelsius) / 1000.0f : 0.0f;
+    }
+    if (zoneCount > 0 && next.zones[cpuZone].valid)
+        next.cpuTemperature = next.zones[cpuZone].celsius;
+    
+    long value = 0;
+    next.throttleAvailable = throttleFd >= 0 && ReadNumber(throttleFd, value, 16);
+    next.throttled = next.throttleAvailable ? static_cast<uint32_t>(value) : 0;
+    if (frequencyFd >= 0 && ReadNumber(frequencyFd, value, 10))
+        next.cpuFrequencyKHz = static_cast<uint32_t>(value);
+    
+    next.timestamp = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    
+    uint32_t previous = snapshot.Load().throttled & 0xF;
+    uint32_t current = next.throttled & 0xF;
+    if (current != previous && current != 0)
+        LOG_WARNINGF("CPU throttling: under-voltage {}, frequency capped {}, throttled {}, soft temperature limit {}",
+                     (current & Throttle::UNDER_VOLTAGE) ? 1 : 0, (current & Throttle::FREQUENCY_CAPPED) ? 1 : 0,
+                     (current & Throttle::THROTTLED) ? 1 : 0, (current & Throttle::SOFT_TEMP_LIMIT) ? 1 : 0);
+    
+    snapshot.Store(next);
+    temperatureGauge.Set(next.cpuTemperature);
+    throttledGauge.Set(next.throttled);
+    
+    if (listener)
+        listener(next);
+}
+
+void ThermalMonitor::SamplerLoop()
+{
+    while (running.load(std::memory_order_acquire))
+    {
+        {
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            wakeCondition.wait_for(lock, std::chrono::milliseconds(interval.load(std::memory_order_relaxed)));
+        }
+        
+        if (running.load(std::memory_order_acquire))
+            Sample();
+    }
+}
@@ -1,29 +1,291 @@
 #include <iostream>
 #include <csignal>
-#include <atomic>
+#include <algorithm>
+#include <chrono>
 #include "../includes/HTTPServer.h"
 #include "../includes/RelayController.h"
 #include "../includes/ConfigManager.h"
+#include "../includes/ConfigWatcher.h"
+#include "../includes/EventLoop.h"
+#include "../includes/Checkpoint.h"
 #include "../includes/Logger.h"
 
-std::atomic<bool> running{true};
+bool LoadTariffTable(const ConfigSnapshot& config, TariffTable& table)
+{
+    std::string bands = config.Get<std::string>("tariff.bands", "");
+    if (bands.empty())
+        return false;
+    
+    table.clear(config.Get("tariff.offpeak", 2.0f));
+    
+    std::string seasons = config.Get<std::string>("tariff.seasons", "");
+    if (!seasons.empty() && !table.parseSeasons(seasons))
+    {
+        LOG_ERROR("Invalid tariff.seasons: " + seasons);
+        return false;
+    }
+    
+    if (!table.parseHolidays(config.Get<std::string>("tariff.holidays", "")))
+    {
+        LOG_ERROR("Invalid tariff.holidays");
+        return false;
+    }
+    
+    if (!table.parseBands(bands))
+    {
+        LOG_ERROR("Invalid tariff.bands: " + bands);
+        return false;
+    }
+    
+    table.compile();
+    return true;
+}
 
-void SignalHandler(int signal)
+void ApplyTariffs(const ConfigSnapshot& config, Statistics& statistics)
 {
-    LOG_INFO("Received signal: " + std::to_string(signal));
-    running = false;
+    statistics.setTariffs(config.Get("tariff.peak", 5.0f), config.Get("tariff.offpeak", 2.0f));
+    
+    TariffTable tariffTable;
+    if (LoadTariffTable(config, tariffTable))
+        statistics.setTariffTable(tariffTable);
 }
 
-void SetupSignalHandlers()
+ProtectionSettings LoadProtectionSettings(const ConfigSnapshot& config)
 {
-    signal(SIGINT, SignalHandler);
-    signal(SIGTERM, SignalHandler);
+    ProtectionSettings settings;
+    settings.enabled = config.Get("protection.enabled", false);
+    settings.ratedCurrent = config.Get("protection.rated_current", 10.0f);
+    settings.instantCurrent = config.Get("protection.instant_current", 40.0f);
+    settings.instantPower = config.Get("protection.instant_power", 0.0f);
+    settings.i2t = config.Get("protection.i2t", 500.0f);
+    return settings;
 }
 
-int main(int argc, char** argv)
+GovernorSettings LoadGovernorSettings(const ConfigSnapshot& config)
 {
-    SetupSignalHandlers();
+    GovernorSettings settings;
+    settings.enabled = config.Get("governor.enabled", true);
+    settings.minRateHz = config.Get("governor.min_rate", 2);
+    settings.boostRateHz = config.Get("governor.boost_rate", 50);
+    settings.warmTemperature = config.Get("governor.warm_temperature", 65.0f);
+    settings.hotTemperature = config.Get("governor.hot_temperature", 75.0f);
+    settings.highLoad = config.Get("governor.high_load", 0.85f);
+    settings.nearThreshold = config.Get("governor.near_threshold", 0.9f);
+    settings.transientWatts = config.Get("governor.transient_watts", 200.0f);
+    settings.boostHoldMs = config.Get("governor.boost_hold_ms", 5000);
+    return settings;
+}
+
+NILMSettings LoadNILMSettings(const ConfigSnapshot& config)
+{
+    NILMSettings settings;
+    settings.enabled = config.Get("nilm.enabled", true);
+    settings.edgeThreshold = config.Get("nilm.edge_threshold", 30.0f);
+    settings.settleSamples = config.Get("nilm.settle_samples", 3);
+    settings.matchTolerance = config.Get("nilm.match_tolerance", 0.15f);
+    settings.minMatchWatts = config.Get("nilm.min_match_watts", 15.0f);
+    return settings;
+}
+
+AnomalySettings LoadAnomalySettings(const ConfigSnapshot& config)
+{
+    AnomalySettings settings;
+    settings.enabled = config.Get("anomaly.enabled", true);
+    settings.alpha = config.Get("anomaly.alpha", 0.01f);
+    settings.warmupSamples = config.Get("anomaly.warmup_samples", 100);
+    settings.spikeSigmas = config.Get("anomaly.spike_sigmas", 6.0f);
+    settings.cusumSlack = config.Get("anomaly.cusum_slack", 1.0f);
+    settings.cusumLimit = config.Get("anomaly.cusum_limit", 8.0f);
+    settings.seasonalRatio = config.Get("anomaly.seasonal_ratio", 0.5f);
+    settings.seasonalMinWatts = config.Get("anomaly.seasonal_min_watts", 50.0f);
+    return settings;
+}
+
+PQSettings LoadPQSettings(const ConfigSnapshot& config)
+{
+    PQSettings settings;
+    settings.enabled = config.Get("pq.enabled", true);
+    settings.nominalVoltage = config.Get("pq.nominal_voltage", 230.0f);
+    settings.nominalFrequency = config.Get("pq.nominal_frequency", 50.0f);
+    settings.sagThreshold = config.Get("pq.sag_threshold", 0.90f);
+    settings.swellThreshold = config.Get("pq.swell_threshold", 1.10f);
+    settings.interruptionThreshold = config.Get("pq.interruption_threshold", 0.05f);
+    settings.hysteresis = config.Get("pq.hysteresis", 0.02f);
+    settings.frequencyTolerance = config.Get("pq.frequency_tolerance", 0.5f);
+    settings.waveform = config.Get("pq.waveform", true);
+    settings.samplesPerCycle = config.Get("pq.samples_per_cycle", 64);
+    return settings;
+}
+
+// Норма по часам недели - средняя мощность тех же часов за последние недели
+void UpdateSeasonalBaseline(Statistics& statistics, SensorManager& sensorManager, int weeks)
+{
+    uint64_t now = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    uint64_t span = static_cast<uint64_t>(std::max(1, weeks)) * 7 * 24 * 3600;
+    uint64_t to = now - now % 3600;
+    
+    double sums[AnomalyDetector::WEEK_HOURS] = {};
+    int counts[AnomalyDetector::WEEK_HOURS] = {};
+    statistics.forEachHistoryBucket(to > span ? to - span : 0, to, 3600, [&](const HistoryBucket& bucket) {
+        // Записи поминутные; неполные часы не учитываются
+        if (bucket.samples < 30)
+            return;
+        int slot = AnomalyDetector::SeasonalSlot(bucket.timestamp);
+        sums[slot] += bucket.energy * 1000.0 * 60.0 / bucket.samples;
+        counts[slot]++;
+    });
+    
+    float baseline[AnomalyDetector::WEEK_HOURS];
+    int known = 0;
+    for (int slot = 0; slot < AnomalyDetector::WEEK_HOURS; ++slot)
+    {
+        baseline[slot] = counts[slot] > 0 ? static_cast<float>(sums[slot] / counts[slot]) : 0.0f;
+        known += counts[slot] > 0 ? 1 : 0;
+    }
+    
+    sensorManager.setSeasonalBaseline(baseline);
+    LOG_DEBUGF("Seasonal power baseline: {} of {} hours known", known, AnomalyDetector::WEEK_HOURS);
+}
 
+// Обучение по записанной трассе: сигнатуры сохраняются в nilm.signatures
+void TrainApplianceSignatures(ConfigManager& config)
+{
+    std::string trace = config.GetString("nilm.train_trace", "");
+    std::string output = config.GetString("nilm.signatures", "");
+    if (trace.empty())
+        return;
+    if (output.empty())
+    {
+        LOG_WARNING("nilm.train_trace is set but nilm.signatures is not, training skipped");
+        return;
+    }
+    
+    auto signatures = ApplianceDetector::TrainFromTrace(trace, LoadNILMSettings(*config.GetSnapshot()),
+                                                        config.GetInt("nilm.min_occurrences", 3));
+    if (!signatures.empty())
+        ApplianceDetector::SaveSignatures(output, signatures);
+}
+
+void ApplyConfigChanges(const ConfigSnapshot& previous, const ConfigSnapshot& current,
+                        SensorManager& sensorManager, Statistics& statistics, HTTPServer& server)
+{
+    Logger& logger = Logger::GetInstance();
+    
+    if (current.Differs(previous, "log.level"))
+        logger.SetLogLevel(static_cast<LogLevel>(current.Get("log.level", 1)));
+    if (current.Differs(previous, "log.console"))
+        logger.EnableConsoleOutput(current.Get("log.console", true));
+    
+    if (current.Differs(previous, "sensor.warning_threshold") ||
+        current.Differs(previous, "sensor.critical_threshold"))
+        sensorManager.setPowerThresholds(current.Get("sensor.warning_threshold", 2000.0f),
+                                         current.Get("sensor.critical_threshold", 3000.0f));
+    
+    if (current.Differs(previous, "sensor.threshold_hysteresis") ||
+        current.Differs(previous, "sensor.threshold_min_duration_ms") ||
+        current.Differs(previous, "sensor.alert_cooldown_ms"))
+        sensorManager.setThresholdTuning(current.Get("sensor.threshold_hysteresis", 50.0f),
+                                         current.Get("sensor.threshold_min_duration_ms", 1000),
+                                         current.Get("sensor.alert_cooldown_ms", 60000));
+    
+    if (AlertEngine::RulesDiffer(previous, current))
+        sensorManager.setAlertRules(AlertEngine::ParseRules(current));
+    
+    static const char* protectionKeys[] = {
+        "protection.enabled", "protection.rated_current", "protection.instant_current",
+        "protection.instant_power", "protection.i2t"
+    };
+    for (const char* key : protectionKeys)
+    {
+        if (current.Differs(previous, key))
+        {
+            sensorManager.setProtectionSettings(LoadProtectionSettings(current));
+            break;
+        }
+    }
+    
+    if (current.Differs(previous, "sensor.sample_rate"))
+        sensorManager.setSampleRate(current.Get("sensor.sample_rate", 10));
+    static const char* nilmKeys[] = {
+        "nilm.enabled", "nilm.edge_threshold", "nilm.settle_samples", "nilm.match_tolerance", "nilm.min_match_watts"
+    };
+    for (const char* key : nilmKeys)
+    {
+        if (current.Differs(previous, key))
+        {
+            sensorManager.setApplianceDetection(LoadNILMSettings(current));
+            break;
+        }
+    }
+    
+    static const char* anomalyKeys[] = {
+        "anomaly.enabled", "anomaly.alpha", "anomaly.warmup_samples", "anomaly.spike_sigmas",
+        "anomaly.cusum_slack", "anomaly.cusum_limit", "anomaly.seasonal_ratio", "anomaly.seasonal_min_watts"
+    };
+    for (const char* key : anomalyKeys)
+    {
+        if (current.Differs(previous, key))
+        {
+            sensorManager.setAnomalyDetection(LoadAnomalySettings(current));
+            break;
+        }
+    }
+    
+    static const char* pqKeys[] = {
+        "pq.enabled", "pq.nominal_voltage", "pq.nominal_frequency", "pq.sag_threshold", "pq.swell_threshold",
+        "pq.interruption_threshold", "pq.hysteresis", "pq.frequency_tolerance", "pq.waveform", "pq.samples_per_cycle"
+    };
+    for (const char* key : pqKeys)
+    {
+        if (current.Differs(previous, key))
+        {
+            sensorManager.setPowerQualitySettings(LoadPQSettings(current));
+            break;
+        }
+    }
+    
+    static const char* governorKeys[] = {
+        "governor.enabled", "governor.min_rate", "governor.boost_rate", "governor.warm_temperature",
+        "governor.hot_temperature", "governor.high_load", "governor.near_threshold",
+        "governor.transient_watts", "governor.boost_hold_ms"
+    };
+    for (const char* key : governorKeys)
+    {
+        if (current.Differs(previous, key))
+        {
+            sensorManager.setGovernorSettings(LoadGovernorSettings(current));
+            break;
+        }
+    }
+    
+    if (current.Differs(previous, "thermal.interval_ms"))
+        sensorManager.setThermalInterval(current.Get("thermal.interval_ms", 2000));
+    
+    static const char* tariffKeys[] = {
+        "tariff.peak", "tariff.offpeak", "tariff.bands", "tariff.seasons", "tariff.holidays"
+    };
+    for (const char* key : tariffKeys)
+    {
+        if (current.Differs(previous, key))
+        {
+            ApplyTariffs(current, statistics);
+            break;
+        }
+    }
+    
+    if (current.Differs(previous, "forecast.alpha") || current.Differs(previous, "forecast.gamma"))
+        statistics.setForecastSmoothing(current.Get("forecast.alpha", 0.05f), current.Get("forecast.gamma", 0.3f));
+    
+    if (current.Differs(previous, "security.api_key"))
+        server.SetConfigAPIKeys(current.Get<std::string>("security.api_key", ""));
+}
+
+int main(int argc, char** argv)
+{
+    // Сигналы принимает signalfd главного цикла; маску наследуют все потоки
+    EventLoop::BlockSignals({SIGINT, SIGTERM, SIGHUP});
+    
     ConfigManager& config = ConfigManager::GetInstance();
     
     std::string configPath = "config/config.json";
@@ -34,24 +296,62 @@ int main(int argc, char** argv)
         std::cerr << "Warning: Using default configuration\n";
     
     config.PrintConfig();
-
+    
     Logger& logger = Logger::GetInstance();
     logger.SetLogLevel(static_cast<LogLevel>(config.GetLogLevel()));
     logger.EnableConsoleOutput(config.GetBool("log.console", true));
     
-    if (config.GetBool("log.file", false))
+    // log.file_enabled включает запись, log.file - путь к файлу
+    if (config.GetBool("log.file_enabled", false))
     {
         std::string logFile = config.GetString("log.file", "logs/smart_plug.log");
         logger.EnableFileOutput(true, logFile);
     }
     
+    LogRotationConfig rotation;
+    rotation.maxBytes = static_cast<uint64_t>(config.GetInt("log.rotate_size_kb", 10240)) * 1024;
+    rotation.maxAgeSeconds = config.GetInt("log.rotate_age_hours", 0) * 3600;
+    rotation.keepFiles = config.GetInt("log.rotate_keep", 5);
+    rotation.compress = config.GetBool("log.rotate_compress", false);
+    logger.SetRotation(rotation);
+    
+    std::string binaryLogFile = config.GetString("log.binary_file", "");
+    if (!binaryLogFile.empty())
+        logger.EnableBinaryOutput(true, binaryLogFile);
+    
+    if (config.GetBool("log.async", false))
+    {
+        AsyncLogConfig asyncConfig;
+        asyncConfig.queueSize = static_cast<size_t>(config.GetInt("log.queue_size", 4096));
+        asyncConfig.overflow = config.GetString("log.overflow", "drop") == "block"
+            ? LogOverflowPolicy::BLOCK : LogOverflowPolicy::DROP;
+        asyncConfig.flushIntervalMs = config.GetInt("log.flush_interval_ms", 1000);
+        asyncConfig.flushEveryRecords = static_cast<size_t>(config.GetInt("log.flush_records", 256));
+        logger.EnableAsyncMode(asyncConfig);
+    }
+    
     LOG_INFO("Starting Smart Plug Server...");
     
+    Checkpoint checkpoint;
+    CheckpointState restored;
+    bool hasCheckpoint = false;
+    std::string checkpointPath = config.GetString("checkpoint.file", "data/smart_plug.state");
+    if (!checkpointPath.empty() && checkpoint.Open(checkpointPath))
+        hasCheckpoint = checkpoint.GetRestoredState(restored);
+    
+    // После аварийного перезапуска реле возвращается в прежнее состояние,
+    // а не переключается в relay.default_state
+    RelayState initialState = config.GetString("relay.default_state", "off") == "on"
+        ? RelayState::ON : RelayState::OFF;
+    if (hasCheckpoint && config.GetBool("relay.restore_state", true) &&
+        restored.relayState != RelayState::UNKNOWN)
+        initialState = restored.relayState;
+    
     RelayController relay;
     int gpioPin = config.GetGPIOPin();
     bool simulationMode = config.GetSimulationMode();
     
-    if (!relay.Initialize(gpioPin, simulationMode))
+    if (!relay.Initialize(gpioPin, simulationMode, false, initialState))
     {
         LOG_ERROR("Failed to initialize relay controller");
         return 1;
@@ -59,12 +359,6 @@ int main(int argc, char** argv)
     
     LOG_INFO("Relay controller initialized on GPIO pin: " + std::to_string(gpioPin));
     
-    std::string defaultState = config.GetString("relay.default_state", "off");
-    if (defaultState == "on")
-        relay.TurnOn();
-    else
-        relay.TurnOff();
-    
     SensorManager sensorManager;
     SensorConfig sensorConfig;
     
@@ -74,6 +368,21 @@ int main(int argc, char** argv)
     sensorConfig.calibration = config.GetFloat("sensor.calibration", 1.0);
     sensorConfig.name = config.GetString("sensor.name", "default");
     sensorConfig.enabled = config.GetBool("sensor.enabled", false);
+    sensorConfig.replayFile = config.GetString("sensor.replay_file", "");
+    sensorConfig.replaySpeed = config.GetFloat("sensor.replay_speed", 1.0f);
+    sensorConfig.recordFile = config.GetString("sensor.record_file", "");
+    sensorConfig.simulationSeed = static_cast<uint32_t>(config.GetInt("sensor.simulation_seed", 5489));
+    sensorConfig.loadProfile = config.GetString("sensor.load_profile", "");
+    sensorConfig.thermalIntervalMs = config.GetInt("thermal.interval_ms", 2000);
+    
+    TrainApplianceSignatures(config);
+    sensorConfig.applianceSignatures = config.GetString("nilm.signatures", "");
+    sensorManager.setApplianceDetection(LoadNILMSettings(*config.GetSnapshot()));
+    sensorManager.setAnomalyDetection(LoadAnomalySettings(*config.GetSnapshot()));
+    sensorManager.setPowerQualitySettings(LoadPQSettings(*config.GetSnapshot()));
+    
+    if (hasCheckpoint)
+        sensorManager.restoreEnergyCounter(restored.energyNanoWh);
     
     if (!sensorManager.initialize(sensorConfig))
         LOG_ERROR("Failed to initialize sensor manager");
@@ -82,6 +391,10 @@ int main(int argc, char** argv)
         float warningThreshold = config.GetFloat("sensor.warning_threshold", 2000.0f);
         float criticalThreshold = config.GetFloat("sensor.critical_threshold", 3000.0f);
         sensorManager.setPowerThresholds(warningThreshold, criticalThreshold);
+        sensorManager.setThresholdTuning(config.GetFloat("sensor.threshold_hysteresis", 50.0f),
+                                         config.GetInt("sensor.threshold_min_duration_ms", 1000),
+                                         config.GetInt("sensor.alert_cooldown_ms", 60000));
+        sensorManager.setAlertRules(AlertEngine::ParseRules(*config.GetSnapshot()));
         
         sensorManager.setPowerThresholdCallback(
             [](float power, float threshold) {
@@ -89,16 +402,30 @@ int main(int argc, char** argv)
                            std::to_string(power) + "W > " + 
                            std::to_string(threshold) + "W");
             });
+        
+        sensorManager.setGovernorSettings(LoadGovernorSettings(*config.GetSnapshot()));
+        sensorManager.setProtectionSettings(LoadProtectionSettings(*config.GetSnapshot()));
+        sensorManager.setProtectionRelay(&relay);
+        sensorManager.setTripCallback(
+            [](float value, float limit) {
+                LOG_ERROR("Overload protection tripped: " + std::to_string(value) +
+                          " (limit " + std::to_string(limit) + ")");
+            });
     }
     
     Statistics statistics;
-    float peakTariff = config.GetFloat("tariff.peak", 5.0f);
-    float offpeakTariff = config.GetFloat("tariff.offpeak", 2.0f);
-    statistics.setTariffs(peakTariff, offpeakTariff);
-
+    ApplyTariffs(*config.GetSnapshot(), statistics);
+    statistics.setForecastSmoothing(config.GetFloat("forecast.alpha", 0.05f), config.GetFloat("forecast.gamma", 0.3f));
+    if (hasCheckpoint)
+        statistics.restoreTotalEnergy(restored.energyNanoWh);
+    
+    sensorManager.setEnergySink(&statistics.getEnergyQueue());
+    sensorManager.setSampleRate(config.GetInt("sensor.sample_rate", 10));
+    
     HTTPServer server(relay, sensorManager, statistics);
-
-        int port = config.GetServerPort();
+    server.SetConfigAPIKeys(config.GetString("security.api_key", ""));
+    
+    int port = config.GetServerPort();
     std::string address = config.GetServerAddress();
     
     if (!server.Start(port, address))
@@ -108,32 +435,108 @@ int main(int argc, char** argv)
         return 1;
     }
     
-    LOG_INFO("Server is running. Press Ctrl+C to stop.");
-
-    while (running)
-    {
-        static auto lastStatUpdate = std::chrono::steady_clock::now();
-        auto now = std::chrono::steady_clock::now();
-        
-        if (std::chrono::duration_cast<std::chrono::seconds>(now - lastStatUpdate).count() >= 60)
+    config.AddValidator([](const ConfigSnapshot& candidate, std::string& error) {
+        TariffTable table;
+        if (!candidate.Get<std::string>("tariff.bands", "").empty() && !LoadTariffTable(candidate, table))
         {
-            if (sensorManager.isPowerSensorActive())
-            {
-                PowerData data = sensorManager.getPowerData();
-                statistics.addPowerReading(data.power, 60);
-            }
-            lastStatUpdate = now;
+            error = "invalid tariff table";
+            return false;
         }
-        
-        std::this_thread::sleep_for(std::chrono::seconds(1));
+        return true;
+    });
+    config.Subscribe([&](const ConfigSnapshot& previous, const ConfigSnapshot& current) {
+        ApplyConfigChanges(previous, current, sensorManager, statistics, server);
+    });
+    
+    EventLoop loop;
+    if (!loop.IsValid())
+    {
+        LOG_ERROR("Failed to create event loop");
+        server.Stop();
+        relay.Shutdown();
+        return 1;
     }
     
+    loop.AddSignals({SIGINT, SIGTERM, SIGHUP}, [&](int signo) {
+        LOG_INFO("Received signal: " + std::to_string(signo));
+        if (signo == SIGHUP)
+        {
+            Logger::RequestReopen();
+            config.ReloadConfig();
+        }
+        else
+            loop.Stop();
+    });
+    
+    // Очередь энергии рассчитана на ~17 минут отсчетов, хватает и редкого опроса
+    // При перегреве свёртка откладывается, пока очередь не заполнится наполовину
+    loop.AddTimer(std::chrono::seconds(std::max(1, config.GetInt("stats.drain_interval", 5))), [&]() {
+        EnergyQueue& queue = statistics.getEnergyQueue();
+        if (queue.size() < queue.capacity() / 2 && sensorManager.shouldDeferBackgroundWork())
+            return;
+        statistics.drainEnergyQueue();
+    });
+    
+    // Норма по часам недели меняется медленно, пересчёт раз в час
+    loop.AddTimer(std::chrono::hours(1), [&]() {
+        if (sensorManager.shouldDeferBackgroundWork())
+            return;
+        UpdateSeasonalBaseline(statistics, sensorManager, config.GetInt("anomaly.seasonal_weeks", 4));
+    });
+    
+    // Сжатие ротированных журналов тоже ждёт; отсрочки считает сам регулятор
+    logger.SetBackgroundWorkGate([&sensorManager]() { return sensorManager.shouldDeferBackgroundWork(); });
+    
+    auto saveCheckpoint = [&](int64_t minEnergyDelta) {
+        CheckpointState state;
+        state.energyNanoWh = sensorManager.getEnergyNanoWh();
+        state.relayState = relay.GetState();
+        checkpoint.Save(state, minEnergyDelta);
+    };
+    
+    // 1 Вт*ч = 1e9 нВт*ч; при интервале 5 минут это не больше 288 записей в сутки
+    int64_t checkpointMinDelta = static_cast<int64_t>(config.GetFloat("checkpoint.min_delta_wh", 1.0f) * 1e9);
+    loop.AddTimer(std::chrono::seconds(std::max(1, config.GetInt("checkpoint.interval", 300))), [&]() {
+        saveCheckpoint(checkpointMinDelta);
+    });
+    
+    // Переключение реле сохраняется сразу, но запись идёт в главном цикле
+    relay.SetStateChangeCallback([&](RelayState) {
+        loop.Post([&]() { saveCheckpoint(checkpointMinDelta); });
+    });
+    
+    uint64_t reportedDrops = 0;
+    loop.AddTimer(std::chrono::minutes(1), [&]() {
+        uint64_t dropped = logger.GetDroppedCount();
+        if (dropped != reportedDrops)
+        {
+            LOG_WARNING("Log records dropped: " + std::to_string(dropped - reportedDrops));
+            reportedDrops = dropped;
+        }
+    });
+    
+    // Перечитывание выполняется в главном цикле, поток наблюдателя только будит его
+    ConfigWatcher configWatcher;
+    if (config.GetBool("config.watch", true))
+        configWatcher.Start(config.GetConfigPath(), [&loop]() {
+            loop.Post([]() { ConfigManager::GetInstance().ReloadConfig(); });
+        });
+    
+    LOG_INFO("Server is running. Press Ctrl+C to stop.");
+    loop.Run();
+    
     LOG_INFO("Shutting down server...");
+    configWatcher.Stop();
     server.Stop();
-    relay.Shutdown();
     sensorManager.shutdown();
+    statistics.drainEnergyQueue(true);
+    relay.SetStateChangeCallback(nullptr);
+    saveCheckpoint(0);
+    relay.Shutdown();
     
     LOG_INFO("Server stopped successfully");
+    logger.DisableAsyncMode();
+    logger.SetBackgroundWorkGate(nullptr);
     
     return 0;
 }
\ No newline at end of file
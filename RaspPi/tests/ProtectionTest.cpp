@@ -0,0 +1,150 @@
+#include "../bench/BenchAccess.h"
+#include "../includes/AlertEngine.h"
+#include "../includes/HAL.h"
+#include "../includes/Logger.h"
+#include "../includes/OverloadProtection.h"
+#include "../includes/PowerMonitor.h"
+#include "../includes/RelayController.h"
+
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+
+// Защита от перегрузки на полном пути опроса: симулятор нагрузки, FakeClock
+// и PowerMonitor. Время срабатывания по I²t сверяется с t = i2t / (I² - Iном²).
+
+namespace
+{
+    constexpr int SAMPLE_RATE_HZ = 10;
+    constexpr double SAMPLE_PERIOD_S = 1.0 / SAMPLE_RATE_HZ;
+    // Так же, как в PowerMonitor::simulateData
+    constexpr double SOURCE_IMPEDANCE = 0.4;
+    
+    int failures = 0;
+    
+    void Expect(bool condition, const char* what)
+    {
+        if (!condition)
+        {
+            std::fprintf(stderr, "FAILED: %s\n", what);
+            failures++;
+        }
+    }
+    
+    // Ток резистивной нагрузки с учётом просадки напряжения в симуляторе
+    double SimulatedCurrent(double watts)
+    {
+        double current = watts / LoadSimulator::NOMINAL_VOLTAGE;
+        return watts / (LoadSimulator::NOMINAL_VOLTAGE - SOURCE_IMPEDANCE * current);
+    }
+    
+    struct TripResult
+    {
+        bool tripped;
+        double seconds;             // время отсчёта, на котором сработала защита
+        ProtectionStatus status;
+        RelayState relayState;
+    };
+    
+    TripResult RunLoad(float watts, const ProtectionSettings& settings)
+    {
+        FakeClock clock(0);
+        
+        RelayController relay;
+        relay.Initialize(17, true, false, RelayState::ON);
+        
+        AlertEngine alerts;
+        OverloadProtection protection;
+        protection.Configure(settings);
+        protection.SetRelay(&relay);
+        protection.SetAlertEngine(&alerts);
+        
+        std::mutex mutex;
+        std::condition_variable tripped;
+        bool done = false;
+        uint64_t tripMs = 0;
+        alerts.Subscribe([&](const AlertEvent& event) {
+            if (!event.raised || std::strcmp(event.rule, OverloadProtection::TRIP_RULE) != 0)
+                return;
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!done)
+                tripMs = event.timestamp;
+            done = true;
+            tripped.notify_one();
+        });
+        alerts.Start();
+        
+        // Нагрузка с первого отсчёта; время идёт только по часам симуляции
+        PowerMonitor monitor;
+        monitor.setClock(&clock);
+        monitor.getLoadSimulator().SetBaseLoad(watts);
+        monitor.setSampleRate(SAMPLE_RATE_HZ);
+        monitor.setProtection(&protection);
+        monitor.initialize(PowerMonitor::SENSOR_SIMULATION);
+        
+        TripResult result {};
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            result.tripped = tripped.wait_for(lock, std::chrono::seconds(5), [&] { return done; });
+            result.seconds = static_cast<double>(tripMs) / 1000.0;
+        }
+        
+        monitor.stop();
+        alerts.Stop();
+        result.status = protection.GetStatus();
+        result.relayState = relay.GetState();
+        relay.Shutdown();
+        return result;
+    }
+    
+    void TestInstantTrip()
+    {
+        ProtectionSettings settings;
+        settings.enabled = true;
+        
+        // ~47 А при пороге 40 А: отключение на первом же отсчёте
+        TripResult result = RunLoad(10000.0f, settings);
+        Expect(result.tripped, "instant: protection tripped");
+        Expect(result.status.lastReason == TripReason::INSTANT_CURRENT, "instant: reason is instant current");
+        Expect(result.seconds < SAMPLE_PERIOD_S, "instant: tripped on the first sample");
+        Expect(result.status.trips == 1, "instant: exactly one trip");
+        Expect(result.relayState == RelayState::OFF, "instant: relay is off");
+        Expect(result.status.lastLatencyNs >= 0, "instant: latency recorded");
+    }
+    
+    void TestI2tTrip(float watts)
+    {
+        ProtectionSettings settings;
+        settings.enabled = true;
+        
+        double current = SimulatedCurrent(watts);
+        double expected = settings.i2t / (current * current - settings.ratedCurrent * settings.ratedCurrent);
+        
+        TripResult result = RunLoad(watts, settings);
+        std::printf("I2t %.0f W: I = %.2f A, expected %.3f s, tripped at %.3f s\n",
+                    watts, current, expected, result.seconds);
+        
+        Expect(result.tripped, "i2t: protection tripped");
+        Expect(result.status.lastReason == TripReason::I2T, "i2t: reason is I2t");
+        Expect(result.relayState == RelayState::OFF, "i2t: relay is off");
+        // Срабатывание на первом отсчёте после набора i2t; шум напряжения - доли процента
+        Expect(result.seconds >= expected * 0.97 - SAMPLE_PERIOD_S, "i2t: not earlier than the curve");
+        Expect(result.seconds <= expected * 1.03 + SAMPLE_PERIOD_S, "i2t: not later than the curve");
+    }
+}
+
+int main()
+{
+    QuietLogger(LogLevel::ERROR);
+    
+    TestInstantTrip();
+    TestI2tTrip(3000.0f);
+    TestI2tTrip(2600.0f);
+    
+    if (failures)
+        std::fprintf(stderr, "%d check(s) failed\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,371 @@
+// Декодер бинарного журнала (BinaryLogSink) в текст или JSON Lines.
+// Использование: smart_plug_logdecode [--json] <file.bin>
+
+#include "../includes/BinaryLogSink.h"
+
+#include <charconv>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+static const char* const LEVEL_NAMES[] = {"DEBUG", "INFO", "WARNING", "ERROR"};
+
+class Reader
+{
+public:
+    explicit Reader(const std::string& data) : data(data) {}
+    
+    bool atEnd() const { return pos >= data.size(); }
+    size_t position() const { return pos; }
+    
+    bool byte(uint8_t& value)
+    {
+        if (pos >= data.size())
+            return false;
+        value = static_cast<uint8_t>(data[pos++]);
+        return true;
+    }
+    
+    bool raw(void* out, size_t size)
+    {
+        if (data.size() - pos < size)
+            return false;
+        std::memcpy(out, data.data() + pos, size);
+        pos += size;
+        return true;
+    }
+    
+    bool varint(uint64_t& value)
+    {
+        value = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            uint8_t b;
+            if (!byte(b))
+                return false;
+            value |= static_cast<uint64_t>(b & 0x7F) << shift;
+            if (!(b & 0x80))
+                return true;
+        }
+        return false;
+    }
+    
+    bool string(std::string& out)
+    {
+        uint64_t size;
+        if (!varint(size) || data.size() - pos < size)
+            return false;
+        out.assign(data, pos, size);
+        pos += size;
+        return true;
+    }
+    
+    bool magic()
+    {
+        return data.size() - pos >= 4 && std::memcmp(data.data() + pos, BinaryLog::MAGIC, 4) == 0;
+    }
+
+private:
+    const std::string& data;
+    size_t pos {0};
+};
+
+struct Argument
+{
+    std::string text;
+    bool quoted;
+};
+
+static std::string JsonEscape(const std::string& value)
+{
+    std::string out;
+    for (char c : value)
+    {
+        switch (c)
+        {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    char buffer[8];
+                    std::snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+                    out += buffer;
+                }
+                else
+                    out += c;
+        }
+    }
+    return out;
+}
+
+template <typename T>
+static std::string NumberToString(T value)
+{
+    char buffer[32];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    return std::string(buffer, result.ptr);
+}
+
+static std::string FormatTime(uint64_t realtimeNs)
+{
+    std::time_t seconds = static_cast<std::time_t>(realtimeNs / 1000000000ULL);
+    std::tm local {};
+    localtime_r(&seconds, &local);
+    char buffer[32];
+    size_t length = std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &local);
+    std::snprintf(buffer + length, sizeof(buffer) - length, ".%03d",
+                  static_cast<int>((realtimeNs / 1000000ULL) % 1000));
+    return buffer;
+}
+
+static std::string Substitute(const std::string& format, const std::vector<Argument>& args)
+{
+    std::string out;
+    size_t start = 0;
+    size_t index = 0;
+    
+    while (index < args.size())
+    {
+        size_t placeholder = format.find("{}", start);
+        if (placeholder == std::string::npos)
+            break;
+        out.append(format, start, placeholder - start);
+        out += args[index++].text;
+        start = placeholder + 2;
+    }
+    
+    out.append(format, start, std::string::npos);
+    return out;
+}
+
+static bool ReadArgument(Reader& reader, const std::map<uint64_t, std::string>& strings, Argument& arg)
+{
+    uint8_t tag;
+    if (!reader.byte(tag))
+        return false;
+    
+    arg.quoted = false;
+    switch (tag)
+    {
+        case BinaryLog::TAG_INT:
+        {
+            uint64_t zigzag;
+            if (!reader.varint(zigzag))
+                return false;
+            arg.text = NumberToString(static_cast<int64_t>((zigzag >> 1) ^ (~(zigzag & 1) + 1)));
+            return true;
+        }
+        case BinaryLog::TAG_UINT:
+        {
+            uint64_t value;
+            if (!reader.varint(value))
+                return false;
+            arg.text = NumberToString(value);
+            return true;
+        }
+        case BinaryLog::TAG_F32:
+        {
+            float value;
+            if (!reader.raw(&value, sizeof(value)))
+                return false;
+            arg.text = NumberToString(value);
+            return true;
+        }
+        case BinaryLog::TAG_F64:
+        {
+            double value;
+            if (!reader.raw(&value, sizeof(value)))
+                return false;
+            arg.text = NumberToString(value);
+            return true;
+        }
+        case BinaryLog::TAG_STR:
+            arg.quoted = true;
+            return reader.string(arg.text);
+        case BinaryLog::TAG_STRREF:
+        {
+            uint64_t id;
+            if (!reader.varint(id))
+                return false;
+            auto it = strings.find(id);
+            arg.text = it != strings.end() ? it->second : "<unknown string>";
+            arg.quoted = true;
+            return true;
+        }
+        case BinaryLog::TAG_BOOL:
+        {
+            uint8_t value;
+            if (!reader.byte(value))
+                return false;
+            arg.text = value ? "true" : "false";
+            return true;
+        }
+        case BinaryLog::TAG_CHAR:
+        {
+            uint8_t value;
+            if (!reader.byte(value))
+                return false;
+            arg.text = std::string(1, static_cast<char>(value));
+            arg.quoted = true;
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool json = false;
+    std::string filename;
+    
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--json")
+            json = true;
+        else
+            filename = arg;
+    }
+    
+    if (filename.empty())
+    {
+        std::cerr << "Usage: " << argv[0] << " [--json] <binary log>\n";
+        return 2;
+    }
+    
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open())
+    {
+        std::cerr << "Cannot open " << filename << "\n";
+        return 1;
+    }
+    std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    
+    Reader reader(data);
+    std::map<uint64_t, BinaryLog::FormatSite> formats;
+    std::map<uint64_t, std::string> strings;
+    uint64_t realtimeBase = 0;
+    uint64_t monotonicBase = 0;
+    uint64_t monotonic = 0;
+    uint64_t records = 0;
+    
+    while (!reader.atEnd())
+    {
+        // Новый сегмент начинается при каждом открытии файла логгером
+        if (reader.magic())
+        {
+            uint8_t magic[4];
+            uint8_t version;
+            if (!reader.raw(magic, 4) || !reader.byte(version) ||
+                !reader.raw(&realtimeBase, sizeof(realtimeBase)) ||
+                !reader.raw(&monotonicBase, sizeof(monotonicBase)))
+                break;
+            
+            if (version != BinaryLog::VERSION)
+            {
+                std::cerr << "Unsupported version " << static_cast<int>(version) << "\n";
+                return 1;
+            }
+            
+            formats.clear();
+            strings.clear();
+            monotonic = monotonicBase;
+            continue;
+        }
+        
+        uint8_t entry;
+        if (!reader.byte(entry))
+            break;
+        
+        bool ok = true;
+        if (entry == BinaryLog::ENTRY_FORMAT)
+        {
+            uint64_t id = 0, line = 0;
+            uint8_t level = 0;
+            BinaryLog::FormatSite site;
+            ok = reader.varint(id) && reader.byte(level) && reader.varint(line) &&
+                 reader.string(site.function) && reader.string(site.format);
+            site.level = level;
+            site.line = static_cast<int>(line);
+            if (ok)
+                formats[id] = site;
+        }
+        else if (entry == BinaryLog::ENTRY_STRING)
+        {
+            uint64_t id;
+            std::string value;
+            ok = reader.varint(id) && reader.string(value);
+            if (ok)
+                strings[id] = value;
+        }
+        else if (entry == BinaryLog::ENTRY_RECORD)
+        {
+            uint64_t id = 0, delta = 0;
+            uint8_t argCount = 0;
+            ok = reader.varint(id) && reader.varint(delta) && reader.byte(argCount);
+            
+            std::vector<Argument> args(argCount);
+            for (uint8_t i = 0; ok && i < argCount; i++)
+                ok = ReadArgument(reader, strings, args[i]);
+            if (!ok)
+                break;
+            
+            monotonic += delta;
+            uint64_t realtime = realtimeBase + (monotonic - monotonicBase);
+            
+            auto it = formats.find(id);
+            BinaryLog::FormatSite site = it != formats.end() ? it->second
+                : BinaryLog::FormatSite{1, 0, "", "<unknown format " + std::to_string(id) + ">"};
+            const char* level = site.level >= 0 && site.level <= 3 ? LEVEL_NAMES[site.level] : "UNKNOWN";
+            std::string message = Substitute(site.format, args);
+            
+            if (json)
+            {
+                std::cout << "{\"time_ns\":" << realtime
+                          << ",\"time\":\"" << FormatTime(realtime) << "\""
+                          << ",\"level\":\"" << level << "\""
+                          << ",\"function\":\"" << JsonEscape(site.function) << "\""
+                          << ",\"line\":" << site.line
+                          << ",\"format\":\"" << JsonEscape(site.format) << "\""
+                          << ",\"args\":[";
+                for (size_t i = 0; i < args.size(); i++)
+                {
+                    if (i > 0)
+                        std::cout << ",";
+                    if (args[i].quoted)
+                        std::cout << "\"" << JsonEscape(args[i].text) << "\"";
+                    else
+                        std::cout << args[i].text;
+                }
+                std::cout << "],\"message\":\"" << JsonEscape(message) << "\"}\n";
+            }
+            else
+            {
+                std::cout << "[" << FormatTime(realtime) << "] [" << level << "] ";
+                if (!site.function.empty())
+                    std::cout << "[" << site.function << ":" << site.line << "] ";
+                std::cout << message << "\n";
+            }
+            records++;
+        }
+        else
+            ok = false;
+        
+        if (!ok)
+        {
+            std::cerr << "Corrupt entry at offset " << reader.position() << "\n";
+            return 1;
+        }
+    }
+    
+    std::cerr << records << " records decoded\n";
+    return 0;
+}